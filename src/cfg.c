@@ -30,9 +30,12 @@
 #define _(str) gettext(str)
 
 #include <cfg.h>
+#include <cpufreq.h>
 #include <graph.h>
+#include <hwmon.h>
 #include <pio.h>
 #include <plog.h>
+#include <powercap.h>
 
 /* Properties of each sensor */
 static const char *ATT_SENSOR_ALARM_ENABLED = "alarm_enabled";
@@ -47,10 +50,22 @@ static const char *ATT_SENSOR_APPINDICATOR_LABEL_ENABLED
 = "appindicator_label_enabled";
 static const char *ATT_SENSOR_POSITION = "position";
 static const char *ATT_SENSOR_HIDE = "hide";
+static const char *ATT_SENSOR_UPDATE_INTERVAL = "update_interval";
 
 /* Update interval of the measures of the sensors */
 static const char *KEY_SENSOR_UPDATE_INTERVAL
 = "sensor-update-interval";
+static const char *KEY_SENSOR_UPDATE_INTERVAL_MS
+= "sensor-update-interval-ms";
+
+/* Minimal update interval of the sensors in milliseconds */
+static const int SENSOR_UPDATE_INTERVAL_MIN = 50;
+
+/* Adaptive sampling settings */
+static const char *KEY_SENSOR_ADAPTIVE_SAMPLING_ENABLED
+= "sensor-adaptive-sampling-enabled";
+static const char *KEY_SENSOR_ADAPTIVE_SAMPLING_MAX_INTERVAL
+= "sensor-adaptive-sampling-max-interval";
 
 /* Graph settings */
 static const char *KEY_GRAPH_UPDATE_INTERVAL = "graph-update-interval";
@@ -131,6 +146,30 @@ static const char *KEY_PROVIDER_LIBATASMART_ENABLED
 = "provider-libatasmart-enabled";
 static const char *KEY_PROVIDER_NVCTRL_ENABLED = "provider-nvctrl-enabled";
 static const char *KEY_PROVIDER_UDISKS2_ENABLED = "provider-udisks2-enabled";
+static const char *KEY_PROVIDER_HWMON_ENABLED = "provider-hwmon-enabled";
+static const char *KEY_PROVIDER_HWMON_SYSFS_ROOT = "provider-hwmon-sysfs-root";
+static const char *KEY_PROVIDER_POWERCAP_ENABLED = "provider-powercap-enabled";
+static const char *KEY_PROVIDER_POWERCAP_SYSFS_ROOT
+= "provider-powercap-sysfs-root";
+static const char *KEY_PROVIDER_CPUFREQ_ENABLED = "provider-cpufreq-enabled";
+static const char *KEY_PROVIDER_CPUFREQ_SYSFS_ROOT
+= "provider-cpufreq-sysfs-root";
+static const char *KEY_PROVIDER_CPUSTAT_ENABLED = "provider-cpustat-enabled";
+
+/* Update interval of each provider, NULL if not configurable */
+static const char *KEY_PROVIDER_UPDATE_INTERVALS[PSENSOR_PROVIDERS_COUNT] = {
+	[PSENSOR_PROVIDER_LMSENSOR] = "provider-lmsensors-update-interval",
+	[PSENSOR_PROVIDER_NVCTRL] = "provider-nvctrl-update-interval",
+	[PSENSOR_PROVIDER_GTOP] = "provider-gtop2-update-interval",
+	[PSENSOR_PROVIDER_ATIADL] = "provider-atiadlsdk-update-interval",
+	[PSENSOR_PROVIDER_ATASMART] = "provider-libatasmart-update-interval",
+	[PSENSOR_PROVIDER_HDDTEMP] = "provider-hddtemp-update-interval",
+	[PSENSOR_PROVIDER_UDISKS2] = "provider-udisks2-update-interval",
+	[PSENSOR_PROVIDER_HWMON] = "provider-hwmon-update-interval",
+	[PSENSOR_PROVIDER_POWERCAP] = "provider-powercap-update-interval",
+	[PSENSOR_PROVIDER_CPUFREQ] = "provider-cpufreq-update-interval",
+	[PSENSOR_PROVIDER_CPUSTAT] = "provider-cpustat-update-interval"
+};
 
 static const char *KEY_DEFAULT_HIGH_THRESHOLD_TEMPERATURE
 = "default-high-threshold-temperature";
@@ -147,11 +186,35 @@ static char *sensor_config_path;
 
 static void (*slog_enabled_cbk)(void *);
 
+static void (*sensor_enabled_cbk)(const char *, bool, void *);
+static void *sensor_enabled_cbk_data;
+
+static void (*sensor_graph_enabled_cbk)(const char *, bool, void *);
+static void *sensor_graph_enabled_cbk_data;
+
 static char *get_string(const char *key)
 {
 	return g_settings_get_string(settings, key);
 }
 
+/*
+ * Returns a copy of the string of a key, or of 'def' if it is empty.
+ * The returned string must be freed with free().
+ */
+static char *get_string_or_default(const char *key, const char *def)
+{
+	char *str, *ret;
+
+	str = get_string(key);
+	if (str && *str)
+		ret = strdup(str);
+	else
+		ret = strdup(def);
+	g_free(str);
+
+	return ret;
+}
+
 static void set_string(const char *key, const char *str)
 {
 	g_settings_set_string(settings, key, str);
@@ -494,10 +557,12 @@ struct config *config_load(void)
 	c->slog_enabled = is_slog_enabled();
 	c->slog_interval = config_get_slog_interval();
 
-	c->sensor_update_interval
-		= get_int(KEY_SENSOR_UPDATE_INTERVAL);
-	if (c->sensor_update_interval < 1)
-		c->sensor_update_interval = 1;
+	c->sensor_update_interval = get_int(KEY_SENSOR_UPDATE_INTERVAL_MS);
+	if (c->sensor_update_interval <= 0)
+		c->sensor_update_interval
+			= 1000 * get_int(KEY_SENSOR_UPDATE_INTERVAL);
+	if (c->sensor_update_interval < SENSOR_UPDATE_INTERVAL_MIN)
+		c->sensor_update_interval = SENSOR_UPDATE_INTERVAL_MIN;
 
 	c->graph_update_interval = get_int(KEY_GRAPH_UPDATE_INTERVAL);
 	if (c->graph_update_interval < 1)
@@ -541,7 +606,14 @@ void config_save(const struct config *c)
 
 	set_int(KEY_GRAPH_MONITORING_DURATION, c->graph_monitoring_duration);
 
-	set_int(KEY_SENSOR_UPDATE_INTERVAL, c->sensor_update_interval);
+	set_int(KEY_SENSOR_UPDATE_INTERVAL_MS, c->sensor_update_interval);
+
+	/* Rounded value in seconds for the previous versions */
+	if (c->sensor_update_interval < 1000)
+		set_int(KEY_SENSOR_UPDATE_INTERVAL, 1);
+	else
+		set_int(KEY_SENSOR_UPDATE_INTERVAL,
+			c->sensor_update_interval / 1000);
 
 	set_bool(KEY_INTERFACE_HIDE_ON_STARTUP, c->hide_on_startup);
 
@@ -841,6 +913,21 @@ bool config_is_sensor_graph_enabled(const char *sid)
 void config_set_sensor_graph_enabled(const char *sid, bool enabled)
 {
 	sensor_set_bool(sid, ATT_SENSOR_GRAPH_ENABLED, enabled);
+
+	if (sensor_graph_enabled_cbk)
+		sensor_graph_enabled_cbk(sid,
+					 enabled,
+					 sensor_graph_enabled_cbk_data);
+}
+
+void
+config_set_sensor_graph_enabled_changed_cbk(void (*cbk)(const char *,
+							bool,
+							void *),
+					    void *data)
+{
+	sensor_graph_enabled_cbk = cbk;
+	sensor_graph_enabled_cbk_data = data;
 }
 
 bool config_get_sensor_alarm_high_threshold(const char *sid, double *v)
@@ -907,6 +994,30 @@ bool config_is_sensor_enabled(const char *sid)
 void config_set_sensor_enabled(const char *sid, bool enabled)
 {
 	sensor_set_bool(sid, ATT_SENSOR_HIDE, !enabled);
+
+	if (sensor_enabled_cbk)
+		sensor_enabled_cbk(sid, enabled, sensor_enabled_cbk_data);
+}
+
+void config_set_sensor_enabled_changed_cbk(void (*cbk)(const char *,
+						       bool,
+						       void *),
+					   void *data)
+{
+	sensor_enabled_cbk = cbk;
+	sensor_enabled_cbk_data = data;
+}
+
+int config_get_sensor_update_interval(const char *sid)
+{
+	int interval;
+
+	interval = sensor_get_int(sid, ATT_SENSOR_UPDATE_INTERVAL);
+
+	if (interval < 0)
+		return 0;
+
+	return interval;
 }
 
 bool config_is_appindicator_label_enabled(const char *sid)
@@ -961,6 +1072,76 @@ bool config_is_atiadlsdk_enabled(void)
 	return get_bool(KEY_PROVIDER_ATIADLSDK_ENABLED);
 }
 
+bool config_is_hwmon_enabled(void)
+{
+	return get_bool(KEY_PROVIDER_HWMON_ENABLED);
+}
+
+char *config_get_hwmon_sysfs_root(void)
+{
+	return get_string_or_default(KEY_PROVIDER_HWMON_SYSFS_ROOT,
+				     HWMON_SYSFS_ROOT);
+}
+
+bool config_is_powercap_enabled(void)
+{
+	return get_bool(KEY_PROVIDER_POWERCAP_ENABLED);
+}
+
+char *config_get_powercap_sysfs_root(void)
+{
+	return get_string_or_default(KEY_PROVIDER_POWERCAP_SYSFS_ROOT,
+				     POWERCAP_SYSFS_ROOT);
+}
+
+bool config_is_cpufreq_enabled(void)
+{
+	return get_bool(KEY_PROVIDER_CPUFREQ_ENABLED);
+}
+
+char *config_get_cpufreq_sysfs_root(void)
+{
+	return get_string_or_default(KEY_PROVIDER_CPUFREQ_SYSFS_ROOT,
+				     CPUFREQ_SYSFS_ROOT);
+}
+
+bool config_is_cpustat_enabled(void)
+{
+	return get_bool(KEY_PROVIDER_CPUSTAT_ENABLED);
+}
+
+int config_get_provider_update_interval(enum psensor_provider p)
+{
+	int interval;
+
+	if (!KEY_PROVIDER_UPDATE_INTERVALS[p])
+		return 0;
+
+	interval = get_int(KEY_PROVIDER_UPDATE_INTERVALS[p]);
+
+	if (interval < 0)
+		return 0;
+
+	return interval;
+}
+
+bool config_is_adaptive_sampling_enabled(void)
+{
+	return get_bool(KEY_SENSOR_ADAPTIVE_SAMPLING_ENABLED);
+}
+
+int config_get_adaptive_sampling_max_interval(void)
+{
+	int interval;
+
+	interval = get_int(KEY_SENSOR_ADAPTIVE_SAMPLING_MAX_INTERVAL);
+
+	if (interval < SENSOR_UPDATE_INTERVAL_MIN)
+		return SENSOR_UPDATE_INTERVAL_MIN;
+
+	return interval;
+}
+
 void config_set_lmsensor_enable(bool b)
 {
 	set_bool(KEY_PROVIDER_LMSENSORS_ENABLED, b);
@@ -996,6 +1177,26 @@ void config_set_udisks2_enable(bool b)
 	set_bool(KEY_PROVIDER_UDISKS2_ENABLED, b);
 }
 
+void config_set_hwmon_enable(bool b)
+{
+	set_bool(KEY_PROVIDER_HWMON_ENABLED, b);
+}
+
+void config_set_powercap_enable(bool b)
+{
+	set_bool(KEY_PROVIDER_POWERCAP_ENABLED, b);
+}
+
+void config_set_cpufreq_enable(bool b)
+{
+	set_bool(KEY_PROVIDER_CPUFREQ_ENABLED, b);
+}
+
+void config_set_cpustat_enable(bool b)
+{
+	set_bool(KEY_PROVIDER_CPUSTAT_ENABLED, b);
+}
+
 enum temperature_unit config_get_temperature_unit(void)
 {
 	return get_int(KEY_INTERFACE_TEMPERATURE_UNIT);
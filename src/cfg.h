@@ -23,6 +23,7 @@
 
 #include <bool.h>
 #include <color.h>
+#include <pregistry.h>
 
 enum temperature_unit {
 	CELSIUS,
@@ -58,6 +59,7 @@ struct config {
 	int graph_monitoring_duration;
 
 	int sensor_values_max_length;
+	/* Update interval of the sensors in milliseconds */
 	int sensor_update_interval;
 
 	int hide_on_startup;
@@ -88,9 +90,25 @@ void config_set_sensor_alarm_enabled(const char *, bool);
 bool config_is_sensor_graph_enabled(const char *);
 void config_set_sensor_graph_enabled(const char *, bool);
 
+/*
+ * Sets the function called by config_set_sensor_graph_enabled() with
+ * the identifier of the sensor and whether it is graphed.
+ */
+void
+config_set_sensor_graph_enabled_changed_cbk(void (*)(const char *,
+						     bool,
+						     void *),
+					    void *);
+
 char *config_get_sensor_name(const char *);
 void config_set_sensor_name(const char *, const char *);
 
+/*
+ * Returns the update interval of a sensor in milliseconds, 0 if it
+ * is updated with the other sensors of its provider.
+ */
+int config_get_sensor_update_interval(const char *sid);
+
 bool config_is_appindicator_enabled(const char *);
 void config_set_appindicator_enabled(const char *, bool);
 
@@ -114,6 +132,30 @@ void config_set_notif_script(const char *);
 bool config_is_sensor_enabled(const char *sid);
 void config_set_sensor_enabled(const char *sid, bool enabled);
 
+/*
+ * Sets the function called by config_set_sensor_enabled() with the
+ * identifier of the sensor and whether it is enabled.
+ */
+void config_set_sensor_enabled_changed_cbk(void (*)(const char *,
+						    bool,
+						    void *),
+					   void *);
+
+/*
+ * Returns the update interval of the sensors of a provider in
+ * milliseconds, 0 if they are updated every sensor_update_interval.
+ */
+int config_get_provider_update_interval(enum psensor_provider p);
+
+/*
+ * Whether the update interval of each sensor adapts to the changes
+ * of its value, see sampling.h.
+ */
+bool config_is_adaptive_sampling_enabled(void);
+
+/* Returns the longest adaptive update interval in milliseconds. */
+int config_get_adaptive_sampling_max_interval(void);
+
 bool config_is_lmsensor_enabled(void);
 void config_set_lmsensor_enable(bool);
 
@@ -135,6 +177,36 @@ void config_set_nvctrl_enable(bool);
 bool config_is_atiadlsdk_enabled(void);
 void config_set_atiadlsdk_enable(bool);
 
+bool config_is_hwmon_enabled(void);
+void config_set_hwmon_enable(bool);
+
+/*
+ * Returns the directory of the hwmon devices, HWMON_SYSFS_ROOT by
+ * default.  The returned string must be freed.
+ */
+char *config_get_hwmon_sysfs_root(void);
+
+bool config_is_powercap_enabled(void);
+void config_set_powercap_enable(bool);
+
+/*
+ * Returns the directory of the powercap zones, POWERCAP_SYSFS_ROOT
+ * by default.  The returned string must be freed.
+ */
+char *config_get_powercap_sysfs_root(void);
+
+bool config_is_cpufreq_enabled(void);
+void config_set_cpufreq_enable(bool);
+
+/*
+ * Returns the directory of the CPUs, CPUFREQ_SYSFS_ROOT by default.
+ * The returned string must be freed.
+ */
+char *config_get_cpufreq_sysfs_root(void);
+
+bool config_is_cpustat_enabled(void);
+void config_set_cpustat_enable(bool);
+
 enum temperature_unit config_get_temperature_unit(void);
 void config_set_temperature_unit(enum temperature_unit);
 
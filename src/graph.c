@@ -30,12 +30,18 @@
 #include <graph.h>
 #include <parray.h>
 #include <plog.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 /* horizontal padding */
 static const int GRAPH_H_PADDING = 4;
 /* vertical padding */
 static const int GRAPH_V_PADDING = 4;
+/*
+ * Maximal duration in seconds of the full resolution history, longer
+ * durations are drawn from the compressed history or the rollup tiers.
+ */
+static const int FULL_RESOLUTION_MAX_DURATION = 3600;
 
 bool is_smooth_curves_enabled;
 
@@ -62,6 +68,9 @@ static GdkRGBA theme_fg_color;
 /* Background color of the current desktop theme */
 static GdkRGBA theme_bg_color;
 
+/* Extrema of the enabled sensors, recomputed after new measures */
+static struct psensor_list_extrema extrema;
+
 static void update_theme(GtkWidget *w)
 {
 	style = gtk_widget_get_style_context(w);
@@ -97,42 +106,39 @@ static struct psensor **list_filter_graph_enabled(struct psensor **sensors)
 	return result;
 }
 
-/* Return the end time of the graph i.e. the more recent measure.  If
- * no measure are available, return 0.
+/* Return the end time of the graph in milliseconds i.e. the more
+ * recent measure.  If no measure are available, return 0.
  * If Bezier curves are used return the measure n-3 to avoid to
  * display a part of the curve outside the graph area.
  */
-static time_t get_graph_end_time_s(struct psensor **sensors)
+static int64_t get_graph_end_time_ms(struct psensor **sensors)
 {
-	time_t ret, t;
-	struct psensor *s;
-	struct measure *measures;
-	int i, n;
+	int64_t ret, t;
+	struct psensor_measure_iter it;
+	struct measure m;
+	int n;
 
 	ret = 0;
 	while (*sensors) {
-		s = *sensors;
-		measures = s->measures;
-
 		if (is_smooth_curves_enabled)
 			n = 2;
 		else
 			n = 0;
 
-		for (i = s->values_max_length - 1; i >= 0; i--) {
-			if (measures[i].value != UNKNOWN_DBL_VALUE) {
-				if (!n) {
-					t = measures[i].time.tv_sec;
+		psensor_measure_iter_init(&it, *sensors, true);
+		while (psensor_measure_iter_next(&it, &m)) {
+			if (m.value == UNKNOWN_DBL_VALUE)
+				continue;
 
-					if (t > ret) {
-						ret = t;
-						break;
-					}
-				} else {
-					n--;
-				}
+			if (n) {
+				n--;
+				continue;
 			}
-			i--;
+
+			t = measure_get_time_ms(&m);
+			if (t > ret)
+				ret = t;
+			break;
 		}
 
 		sensors++;
@@ -141,12 +147,19 @@ static time_t get_graph_end_time_s(struct psensor **sensors)
 	return ret;
 }
 
-static time_t get_graph_begin_time_s(struct config *cfg, time_t etime)
+static int64_t get_graph_begin_time_ms(struct config *cfg, int64_t etime)
 {
 	if (!etime)
 		return 0;
 
-	return etime - cfg->graph_monitoring_duration * 60;
+	return etime - (int64_t)cfg->graph_monitoring_duration * 60 * 1000;
+}
+
+/* Returns the horizontal position of the time 't' in milliseconds. */
+static double
+compute_x(int64_t t, int64_t bt, int64_t et, struct graph_info *info)
+{
+	return ((double)(t - bt) * info->g_width) / (et - bt) + info->g_xoff;
 }
 
 static double
@@ -157,19 +170,17 @@ compute_y(double value, double min, double max, int height, int off)
 	return height - ((double)height * (t / (max - min))) + off;
 }
 
-static char *time_to_str(time_t s)
+/* Formats the hour and minutes of 'ms' into 'buf' of 'size' bytes. */
+static char *time_to_buf(int64_t ms, char *buf, size_t size)
 {
-	char *str;
-	/* note: localtime returns a static field, no free required */
-	struct tm *tm = localtime(&s);
-
-	if (!tm)
-		return NULL;
+	struct tm tm;
+	time_t s;
 
-	str = malloc(6);
-	strftime(str, 6, "%H:%M", tm);
+	s = ms / 1000;
+	if (!localtime_r(&s, &tm) || !strftime(buf, size, "%H:%M", &tm))
+		*buf = '\0';
 
-	return str;
+	return buf;
 }
 
 static void draw_left_region(cairo_t *cr, struct graph_info *info)
@@ -295,23 +306,41 @@ static void draw_background_lines(cairo_t *cr,
 
 /* Keys: sensor identifier.
  *
- * Values: array of time_t. Each time_t is corresponding to a sensor
- * measure which has been used as the start point of a Bezier curve.
+ * Values: array of times in milliseconds. Each time is corresponding
+ * to a sensor measure which has been used as the start point of a
+ * Bezier curve.
  */
 static GHashTable *times;
 
+/*
+ * Returns whether 'm' can be drawn and, if so, sets 't' to its time
+ * and 'v' to its value.
+ */
+static bool
+get_drawable_measure(const struct measure *m, int64_t *t, double *v)
+{
+	*t = measure_get_time_ms(m);
+	*v = m->value;
+
+	return *v != UNKNOWN_DBL_VALUE && *t;
+}
+
 static void draw_sensor_smooth_curve(struct psensor *s,
+				     int tier,
 				     cairo_t *cr,
 				     double min,
 				     double max,
-				     int bt,
-				     int et,
+				     int64_t bt,
+				     int64_t et,
 				     struct graph_info *info)
 {
-	int i, dt, vdt, j, k, found;
+	int n, j, k, found;
 	double x[4], y[4], v;
-	time_t t, t0, *stimes;
+	int64_t t, t0, *stimes;
 	GdkRGBA *color;
+	struct psensor_measure_iter it;
+	struct measure m;
+	bool valid;
 
 	if (!times)
 		times = g_hash_table_new_full(g_str_hash,
@@ -321,6 +350,8 @@ static void draw_sensor_smooth_curve(struct psensor *s,
 
 	stimes = g_hash_table_lookup(times, s->id);
 
+	n = psensor_get_tier_length(s, tier);
+
 	color = config_get_sensor_color(s->id);
 
 	cairo_set_source_rgb(cr,
@@ -329,19 +360,16 @@ static void draw_sensor_smooth_curve(struct psensor *s,
 			     color->blue);
 	gdk_rgba_free(color);
 
-	/* search the index of the first measure used as a start point
-	 * of a Bezier curve. The start and end points of the Bezier
-	 * curves must be preserved to ensure the same overall shape
-	 * of the graph.
+	/* search the first measure used as a start point of a Bezier
+	 * curve. The start and end points of the Bezier curves must
+	 * be preserved to ensure the same overall shape of the graph.
 	 */
-	i = 0;
+	psensor_measure_iter_init_tier(&it, s, tier, false);
+	valid = psensor_measure_iter_next(&it, &m);
 	if (stimes) {
-		while (i < s->values_max_length) {
-			t = s->measures[i].time.tv_sec;
-			v = s->measures[i].value;
-
+		while (valid) {
 			found = 0;
-			if (v != UNKNOWN_DBL_VALUE && t) {
+			if (get_drawable_measure(&m, &t, &v)) {
 				k = 0;
 				while (stimes[k]) {
 					if (t == stimes[k]) {
@@ -355,53 +383,48 @@ static void draw_sensor_smooth_curve(struct psensor *s,
 			if (found)
 				break;
 
-			i++;
+			valid = psensor_measure_iter_next(&it, &m);
 		}
 	}
 
-	stimes = malloc((s->values_max_length + 1) * sizeof(time_t));
-	memset(stimes, 0, (s->values_max_length + 1) * sizeof(time_t));
+	stimes = malloc((n + 1) * sizeof(int64_t));
+	memset(stimes, 0, (n + 1) * sizeof(int64_t));
 	g_hash_table_insert(times, strdup(s->id), stimes);
 
-	if (i == s->values_max_length)
-		i = 0;
+	if (!valid) {
+		psensor_measure_iter_init_tier(&it, s, tier, false);
+		valid = psensor_measure_iter_next(&it, &m);
+	}
 
 	k = 0;
-	dt = et - bt;
-	while (i < s->values_max_length) {
+	while (valid) {
 		j = 0;
 		t = 0;
-		while (i < s->values_max_length && j < 4) {
-			t = s->measures[i].time.tv_sec;
-			v = s->measures[i].value;
-
-			if (v == UNKNOWN_DBL_VALUE || !t) {
-				i++;
-				continue;
+		while (valid && j < 4) {
+			if (get_drawable_measure(&m, &t, &v)) {
+				x[0 + j] = compute_x(t, bt, et, info);
+				y[0 + j] = compute_y(v,
+						     min,
+						     max,
+						     info->g_height,
+						     info->g_yoff);
+
+				if (j == 0)
+					t0 = t;
+
+				j++;
 			}
 
-			vdt = t - bt;
-
-			x[0 + j] = ((double)vdt * info->g_width)
-				/ dt + info->g_xoff;
-			y[0 + j] = compute_y(v,
-					     min,
-					     max,
-					     info->g_height,
-					     info->g_yoff);
-
-			if (j == 0)
-				t0 = t;
-
-			i++;
-			j++;
+			/* the end point starts the next curve */
+			if (j < 4)
+				valid = psensor_measure_iter_next(&it, &m);
 		}
 
 		if (j == 4) {
 			cairo_move_to(cr, x[0], y[0]);
 			cairo_curve_to(cr, x[1], y[1], x[2], y[3], x[3], y[3]);
-			stimes[k++] = t0;
-			i--;
+			if (k < n)
+				stimes[k++] = t0;
 		}
 	}
 
@@ -409,16 +432,20 @@ static void draw_sensor_smooth_curve(struct psensor *s,
 }
 
 static void draw_sensor_curve(struct psensor *s,
+			      int tier,
 			      cairo_t *cr,
 			      double min,
 			      double max,
-			      int bt,
-			      int et,
+			      int64_t bt,
+			      int64_t et,
 			      struct graph_info *info)
 {
-	int first, i, t, dt, vdt;
+	int first;
+	int64_t t;
 	double v, x, y;
 	GdkRGBA *color;
+	struct psensor_measure_iter it;
+	struct measure m;
 
 	color = config_get_sensor_color(s->id);
 	cairo_set_source_rgb(cr,
@@ -427,18 +454,13 @@ static void draw_sensor_curve(struct psensor *s,
 			     color->blue);
 	gdk_rgba_free(color);
 
-	dt = et - bt;
 	first = 1;
-	for (i = 0; i < s->values_max_length; i++) {
-		t = s->measures[i].time.tv_sec;
-		v = s->measures[i].value;
-
-		if (v == UNKNOWN_DBL_VALUE || !t)
+	psensor_measure_iter_init_tier(&it, s, tier, false);
+	while (psensor_measure_iter_next(&it, &m)) {
+		if (!get_drawable_measure(&m, &t, &v))
 			continue;
 
-		vdt = t - bt;
-
-		x = ((double)vdt * info->g_width) / dt + info->g_xoff;
+		x = compute_x(t, bt, et, info);
 
 		y = compute_y(v, min, max, info->g_height, info->g_yoff);
 
@@ -477,14 +499,16 @@ graph_update(struct psensor **sensors,
 	     struct config *config,
 	     GtkWidget *window)
 {
-	int et, bt, width, height, g_width, g_height;
-	double min_rpm, max_rpm, mint, maxt, min, max;
-	char *strmin, *strmax;
+	int width, height, g_width, g_height, span, tier;
+	int64_t et, bt;
+	double min_rpm, max_rpm, mint, maxt, max_percent, max_power, max_freq,
+		max_rate, min, max;
+	char strmin[PSENSOR_VALUE_STR_SIZE], strmax[PSENSOR_VALUE_STR_SIZE];
 	/* horizontal and vertical offset of the graph */
 	int g_xoff, g_yoff, no_graphs, use_celsius;
 	cairo_surface_t *cst;
 	cairo_t *cr, *cr_pixmap;
-	char *str_btime, *str_etime;
+	char str_btime[6], str_etime[6];
 	cairo_text_extents_t te_btime, te_etime, te_max, te_min;
 	struct psensor **sensor_cur, **enabled_sensors;
 	GtkAllocation galloc;
@@ -498,25 +522,46 @@ graph_update(struct psensor **sensors,
 
 	enabled_sensors = list_filter_graph_enabled(sensors);
 
-	min_rpm = get_min_rpm(enabled_sensors);
-	max_rpm = get_max_rpm(enabled_sensors);
+	span = config->graph_monitoring_duration * 60;
+
+	psensor_list_extrema_update(&extrema, enabled_sensors, span);
+
+	min_rpm = extrema.min[PSENSOR_VALUE_RPM];
+	max_rpm = extrema.max[PSENSOR_VALUE_RPM];
 
 	if (config_get_temperature_unit() == CELSIUS)
 		use_celsius = 1;
 	else
 		use_celsius = 0;
 
-	mint = get_min_temp(enabled_sensors);
-	strmin = psensor_value_to_str(SENSOR_TYPE_TEMP, mint, use_celsius);
+	mint = extrema.min[PSENSOR_VALUE_TEMP];
+	psensor_value_to_buf(SENSOR_TYPE_TEMP,
+			     mint,
+			     use_celsius,
+			     strmin,
+			     sizeof(strmin));
+
+	maxt = extrema.max[PSENSOR_VALUE_TEMP];
+	psensor_value_to_buf(SENSOR_TYPE_TEMP,
+			     maxt,
+			     use_celsius,
+			     strmax,
+			     sizeof(strmax));
 
-	maxt = get_max_temp(enabled_sensors);
-	strmax = psensor_value_to_str(SENSOR_TYPE_TEMP, maxt, use_celsius);
+	max_percent = extrema.max[PSENSOR_VALUE_PERCENT];
+	max_power = extrema.max[PSENSOR_VALUE_POWER];
+	max_freq = extrema.max[PSENSOR_VALUE_FREQ];
+	max_rate = extrema.max[PSENSOR_VALUE_RATE];
 
-	et = get_graph_end_time_s(enabled_sensors);
-	bt = get_graph_begin_time_s(config, et);
+	/* the rates are 0 most of the time, drawn at the bottom */
+	if (max_rate < 1)
+		max_rate = 1;
 
-	str_btime = time_to_str(bt);
-	str_etime = time_to_str(et);
+	et = get_graph_end_time_ms(enabled_sensors);
+	bt = get_graph_begin_time_ms(config, et);
+
+	time_to_buf(bt, str_btime, sizeof(str_btime));
+	time_to_buf(et, str_etime, sizeof(str_etime));
 
 	gtk_widget_get_allocation(w_graph, &galloc);
 	width = galloc.width;
@@ -571,14 +616,12 @@ graph_update(struct psensor **sensors,
 	/* draw graph begin time */
 	cairo_move_to(cr, g_xoff, height - GRAPH_V_PADDING);
 	cairo_show_text(cr, str_btime);
-	free(str_btime);
 
 	/* draw graph end time */
 	cairo_move_to(cr,
 		      width - te_etime.width - GRAPH_H_PADDING,
 		      height - GRAPH_V_PADDING);
 	cairo_show_text(cr, str_etime);
-	free(str_etime);
 
 	draw_background_lines(cr, mint, maxt, config, &info);
 
@@ -598,20 +641,30 @@ graph_update(struct psensor **sensors,
 				max = max_rpm;
 			} else if (s->type & SENSOR_TYPE_PERCENT) {
 				min = 0;
-				max = get_max_value(enabled_sensors,
-						    SENSOR_TYPE_PERCENT);
+				max = max_percent;
+			} else if (s->type & SENSOR_TYPE_POWER) {
+				min = 0;
+				max = max_power;
+			} else if (s->type & SENSOR_TYPE_FREQ) {
+				min = 0;
+				max = max_freq;
+			} else if (s->type & SENSOR_TYPE_RATE) {
+				min = 0;
+				max = max_rate;
 			} else {
 				min = mint;
 				max = maxt;
 			}
 
+			tier = psensor_get_tier(s, span);
+
 			if (is_smooth_curves_enabled)
-				draw_sensor_smooth_curve(s, cr,
+				draw_sensor_smooth_curve(s, tier, cr,
 							 min, max,
 							 bt, et,
 							 &info);
 			else
-				draw_sensor_curve(s, cr,
+				draw_sensor_curve(s, tier, cr,
 						  min, max,
 						  bt, et,
 						  &info);
@@ -636,12 +689,10 @@ graph_update(struct psensor **sensors,
 
 	cairo_move_to(cr, GRAPH_H_PADDING, te_max.height + GRAPH_V_PADDING);
 	cairo_show_text(cr, strmax);
-	free(strmax);
 
 	cairo_move_to(cr,
 		      GRAPH_H_PADDING, height - (te_min.height / 2) - g_yoff);
 	cairo_show_text(cr, strmin);
-	free(strmin);
 
 	cr_pixmap = gdk_cairo_create(gtk_widget_get_window(w_graph));
 
@@ -665,9 +716,11 @@ int compute_values_max_length(struct config *c)
 	int n, duration, interval;
 
 	duration = c->graph_monitoring_duration * 60;
+	if (duration > FULL_RESOLUTION_MAX_DURATION)
+		duration = FULL_RESOLUTION_MAX_DURATION;
 	interval = c->sensor_update_interval;
 
-	n = 3 + ceil((((double)duration) / interval) + 0.5) + 3;
+	n = 3 + ceil((1000.0 * duration / interval) + 0.5) + 3;
 
 	return n;
 }
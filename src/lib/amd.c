@@ -260,27 +260,28 @@ static int init(void)
 /* Called regularly to update sensors values */
 void amd_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor **ss, *s;
-
-	ss = sensors;
-	while (*ss) {
-		s = *ss;
-
-		if (s->type & SENSOR_TYPE_ATIADL) {
-			if (s->type & SENSOR_TYPE_TEMP)
-				psensor_set_current_value(s, get_temp(s));
-			else if (s->type & SENSOR_TYPE_RPM)
-				psensor_set_current_value(s, get_fanspeed(s));
-			else if (s->type & SENSOR_TYPE_PERCENT)
-				psensor_set_current_value(s, get_usage(s));
-		}
+	struct psensor_batch b;
+	struct psensor *s;
+	int i;
+
+	psensor_batch_begin(&b, sensors);
 
-		ss++;
+	for (i = 0; sensors[i]; i++) {
+		s = sensors[i];
+
+		if (s->type & SENSOR_TYPE_TEMP)
+			psensor_batch_set(&b, i, get_temp(s));
+		else if (s->type & SENSOR_TYPE_RPM)
+			psensor_batch_set(&b, i, get_fanspeed(s));
+		else if (s->type & SENSOR_TYPE_PERCENT)
+			psensor_batch_set(&b, i, get_usage(s));
 	}
+
+	psensor_batch_commit(&b);
 }
 
 /* Entry point for AMD sensors */
-void amd_psensor_list_append(struct psensor ***sensors, int values_len)
+void amd_psensor_list_append(struct psensor_registry *r, int values_len)
 {
 	int i, j, n;
 	struct psensor *s;
@@ -291,7 +292,7 @@ void amd_psensor_list_append(struct psensor ***sensors, int values_len)
 		/* Each GPU Adapter has 3 sensors: temp, fan speed and usage */
 		for (j = 0; j < 3; j++) {
 			s = create_sensor(i, j, values_len);
-			psensor_list_append(sensors, s);
+			psensor_registry_add(r, s);
 		}
 }
 
@@ -21,6 +21,7 @@
 #define _PSENSOR_AMD_H_
 
 #include <bool.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_LIBATIADL) && HAVE_LIBATIADL
@@ -28,7 +29,7 @@
 static inline bool amd_is_supported(void) { return true; }
 
 void amd_psensor_list_update(struct psensor **s);
-void amd_psensor_list_append(struct psensor ***s, int n);
+void amd_psensor_list_append(struct psensor_registry *r, int n);
 void amd_cleanup(void);
 
 #else
@@ -36,7 +37,8 @@ void amd_cleanup(void);
 static inline bool amd_is_supported(void) { return false; }
 
 static inline void amd_psensor_list_update(struct psensor **s) {}
-static inline void amd_psensor_list_append(struct psensor ***s, int n) {}
+static inline void
+amd_psensor_list_append(struct psensor_registry *r, int n) {}
 static inline void amd_cleanup(void) {}
 
 #endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <locale.h>
+#include <libintl.h>
+#define _(str) gettext(str)
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cpufreq.h>
+#include <pio.h>
+#include <preader.h>
+#include <ptime.h>
+
+static const char *PROVIDER_NAME = "cpufreq";
+
+/* Reads of the files of an update */
+static struct preader reader;
+
+struct cpufreq_data {
+	/* File of the value, kept open */
+	int fd;
+
+	/* Content of the file read by the last update */
+	char buf[32];
+
+	/* Whether the value is an event counter converted to a rate */
+	bool counter;
+
+	/* Counter and monotonic time in us of the previous update */
+	uint64_t count;
+	int64_t time;
+
+	/* See log_read() */
+	bool failed;
+};
+
+static void cpufreq_data_free(void *data)
+{
+	close(((struct cpufreq_data *)data)->fd);
+	free(data);
+}
+
+/*
+ * Creates the sensor of the file 'attr' of the CPU directory 'dir',
+ * 'key' identifies it among the sensors of the provider.
+ *
+ * Returns NULL if the file does not exist or cannot be read.
+ */
+static struct psensor *create_sensor(const char *dir,
+				     const char *attr,
+				     const char *key,
+				     const char *name,
+				     unsigned int type,
+				     int values_max_length)
+{
+	char path[PATH_MAX], *id;
+	int fd;
+	struct cpufreq_data *data;
+	struct psensor *s;
+
+	if (snprintf(path, sizeof(path), "%s/%s", dir, attr) >= PATH_MAX)
+		return NULL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return NULL;
+
+	id = malloc(strlen(PROVIDER_NAME) + 1 + strlen(key) + 1);
+	sprintf(id, "%s %s", PROVIDER_NAME, key);
+
+	s = psensor_create(id,
+			   strdup(name),
+			   strdup(_("CPU")),
+			   SENSOR_TYPE_CPUFREQ | SENSOR_TYPE_CPU | type,
+			   values_max_length);
+
+	data = malloc(sizeof(struct cpufreq_data));
+	data->fd = fd;
+	data->counter = type & SENSOR_TYPE_RATE;
+	data->time = 0;
+	data->failed = false;
+
+	s->provider_data = data;
+	s->provider_data_free_fct = cpufreq_data_free;
+
+	return s;
+}
+
+static struct psensor *create_freq_sensor(const char *dir,
+					  int cpu,
+					  int values_max_length)
+{
+	char key[32], name[64];
+	uint64_t khz;
+	struct psensor *s;
+
+	snprintf(key, sizeof(key), "cpu%d frequency", cpu);
+	snprintf(name, sizeof(name), _("cpu%d frequency"), cpu);
+
+	s = create_sensor(dir,
+			  "cpufreq/scaling_cur_freq",
+			  key,
+			  name,
+			  SENSOR_TYPE_FREQ,
+			  values_max_length);
+
+	if (s && sysfs_read_u64(dir, "cpufreq/cpuinfo_max_freq", &khz))
+		s->max = khz / 1000.0;
+
+	return s;
+}
+
+static struct psensor *create_core_throttle_sensor(const char *dir,
+						   int cpu,
+						   int values_max_length)
+{
+	char key[32], name[64];
+
+	snprintf(key, sizeof(key), "cpu%d throttling", cpu);
+	snprintf(name, sizeof(name), _("cpu%d throttling"), cpu);
+
+	return create_sensor(dir,
+			     "thermal_throttle/core_throttle_count",
+			     key,
+			     name,
+			     SENSOR_TYPE_RATE,
+			     values_max_length);
+}
+
+static struct psensor *create_package_throttle_sensor(const char *dir,
+						      int pkg,
+						      int values_max_length)
+{
+	char key[32], name[64];
+
+	snprintf(key, sizeof(key), "package%d throttling", pkg);
+	snprintf(name, sizeof(name), _("package %d throttling"), pkg);
+
+	return create_sensor(dir,
+			     "thermal_throttle/package_throttle_count",
+			     key,
+			     name,
+			     SENSOR_TYPE_RATE,
+			     values_max_length);
+}
+
+/* Selects the 'cpuN' directories. */
+static int is_cpu(const struct dirent *e)
+{
+	const char *p;
+
+	if (strncmp(e->d_name, "cpu", 3) || !e->d_name[3])
+		return 0;
+
+	for (p = e->d_name + 3; *p; p++)
+		if (*p < '0' || *p > '9')
+			return 0;
+
+	return 1;
+}
+
+/* Sorts the CPUs by number, 'cpu2' before 'cpu10'. */
+static int compare_cpus(const struct dirent **a, const struct dirent **b)
+{
+	return atoi((*a)->d_name + 3) - atoi((*b)->d_name + 3);
+}
+
+void cpufreq_psensor_list_append(struct psensor_registry *r,
+				 const char *root,
+				 int values_max_length)
+{
+	char dir[PATH_MAX];
+	struct dirent **cpus;
+	uint64_t pkg;
+	unsigned char *pkgs;
+	int i, n, cpu;
+
+	n = scandir(root, &cpus, is_cpu, compare_cpus);
+	if (n == -1) {
+		log_debug("%s: Cannot list %s.", PROVIDER_NAME, root);
+		return;
+	}
+
+	/* packages whose sensor is created, at most one per CPU */
+	pkgs = calloc(n, 1);
+
+	for (i = 0; i < n; i++) {
+		cpu = atoi(cpus[i]->d_name + 3);
+
+		snprintf(dir, sizeof(dir), "%s/%s", root, cpus[i]->d_name);
+
+		psensor_registry_add
+			(r, create_freq_sensor(dir, cpu, values_max_length));
+
+		psensor_registry_add
+			(r, create_core_throttle_sensor(dir,
+							cpu,
+							values_max_length));
+
+		/* the count of a package is exposed by all its CPUs */
+		if (sysfs_read_u64(dir, "topology/physical_package_id", &pkg)
+		    && pkg < (unsigned int)n && !pkgs[pkg]) {
+			pkgs[pkg] = 1;
+
+			psensor_registry_add
+				(r, create_package_throttle_sensor
+				 (dir, pkg, values_max_length));
+		}
+
+		free(cpus[i]);
+	}
+
+	free(pkgs);
+	free(cpus);
+}
+
+void cpufreq_psensor_list_update(struct psensor **sensors)
+{
+	struct psensor_batch b;
+	struct cpufreq_data *data;
+	ssize_t n;
+	bool ok;
+	uint64_t v;
+	int64_t now;
+	int i;
+
+	if (!sensors)
+		return;
+
+	preader_clear(&reader);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		preader_add(&reader, data->fd, data->buf, sizeof(data->buf));
+	}
+
+	preader_run(&reader);
+
+	now = get_monotonic_time_us();
+
+	psensor_batch_begin(&b, sensors);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		n = reader.reqs[i].ret;
+
+		ok = n > 0 && sysfs_parse_u64(data->buf, n, &v);
+		if (!log_read(&data->failed,
+			      ok,
+			      PROVIDER_NAME,
+			      sensors[i]->id)) {
+			data->time = 0;
+			continue;
+		}
+
+		if (!data->counter) {
+			/* kHz */
+			psensor_batch_set(&b, i, v / 1000.0);
+			continue;
+		}
+
+		/* a counter going backward has been reset, skipped */
+		if (data->time && now > data->time && v >= data->count)
+			psensor_batch_set(&b,
+					  i,
+					  (v - data->count) * 1000000.0
+					  / (now - data->time));
+
+		data->count = v;
+		data->time = now;
+	}
+
+	psensor_batch_commit(&b);
+}
+
+void cpufreq_cleanup(void)
+{
+	preader_free(&reader);
+}
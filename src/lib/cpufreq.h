@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_CPUFREQ_H_
+#define _PSENSOR_CPUFREQ_H_
+
+#include <pregistry.h>
+#include <psensor.h>
+
+/* Directory of the CPUs exposed by the kernel */
+#define CPUFREQ_SYSFS_ROOT "/sys/devices/system/cpu"
+
+/*
+ * Adds the sensors of the CPUs found in the directory 'root',
+ * usually CPUFREQ_SYSFS_ROOT:
+ *  - the current frequency of each core, 'cpufreq/scaling_cur_freq',
+ *  - the rate of the thermal throttling events of each core and of
+ *    each package, 'thermal_throttle/core_throttle_count' and
+ *    'thermal_throttle/package_throttle_count' (x86 only).
+ */
+void cpufreq_psensor_list_append(struct psensor_registry *r,
+				 const char *root,
+				 int values_max_length);
+
+/*
+ * Reads the files of 'sensors' in a batch.  The throttling rates are
+ * the number of events per second since the previous update, nothing
+ * is set by the first one.
+ */
+void cpufreq_psensor_list_update(struct psensor **sensors);
+
+void cpufreq_cleanup(void);
+
+#endif
@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <locale.h>
+#include <libintl.h>
+#define _(str) gettext(str)
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cpustat.h>
+#include <pio.h>
+
+static const char *PROVIDER_NAME = "cpustat";
+
+/* Initial size of the buffer of the content of /proc/stat */
+#define STAT_BUFFER_SIZE 4096
+
+/*
+ * Times read by the last update, shared by the sensors: the file is
+ * parsed once for all the CPUs.
+ */
+static struct {
+	/* /proc/stat, kept open */
+	int fd;
+
+	char *buf;
+	size_t size;
+
+	/* Times by CPU number */
+	struct cpustat_times *times;
+	int count;
+
+	/* See log_read() */
+	bool failed;
+} proc_stat = { .fd = -1 };
+
+struct cpustat_data {
+	/* CPUs of the sensor, a single one or the ones of a package */
+	int *cpus;
+	int count;
+
+	/* Times of the previous update, 'total' is 0 if none */
+	struct cpustat_times last;
+};
+
+/* Number of the fields of a 'cpuN' line, user to steal */
+#define FIELDS_COUNT 8
+
+/* Fields which are not used time: idle and iowait */
+#define FIELD_IDLE 3
+#define FIELD_IOWAIT 4
+
+int cpustat_parse(const char *buf, struct cpustat_times *times, int n)
+{
+	const char *p;
+	char *end;
+	unsigned long long v;
+	uint64_t used, total;
+	long cpu;
+	int i, max;
+
+	max = 0;
+
+	/* the 'cpu' lines are the first ones */
+	for (p = buf; !strncmp(p, "cpu", 3); p = end + 1) {
+		cpu = -1;
+		if (p[3] >= '0' && p[3] <= '9')
+			cpu = strtol(p + 3, &end, 10);
+		else
+			end = (char *)p + 3;
+
+		used = 0;
+		total = 0;
+		for (i = 0; i < FIELDS_COUNT; i++) {
+			p = end;
+			v = strtoull(p, &end, 10);
+			if (end == p)
+				break;
+
+			total += v;
+			if (i != FIELD_IDLE && i != FIELD_IOWAIT)
+				used += v;
+		}
+
+		if (cpu >= 0 && cpu < INT_MAX) {
+			if (cpu < n) {
+				times[cpu].used += used;
+				times[cpu].total += total;
+			}
+
+			if (cpu >= max)
+				max = cpu + 1;
+		}
+
+		end = strchr(end, '\n');
+		if (!end)
+			break;
+	}
+
+	return max;
+}
+
+double cpustat_get_usage(const struct cpustat_times *last,
+			 const struct cpustat_times *cur)
+{
+	if (cur->total <= last->total || cur->used < last->used)
+		return UNKNOWN_DBL_VALUE;
+
+	return 100.0 * (cur->used - last->used) / (cur->total - last->total);
+}
+
+/* Reads the content of /proc/stat from its beginning into proc_stat.buf. */
+static bool read_stat(void)
+{
+	ssize_t n;
+
+	while (1) {
+		n = pread(proc_stat.fd, proc_stat.buf, proc_stat.size - 1, 0);
+		if (n <= 0)
+			return false;
+
+		if ((size_t)n < proc_stat.size - 1)
+			break;
+
+		/* the content may be truncated */
+		proc_stat.size *= 2;
+		proc_stat.buf = realloc(proc_stat.buf, proc_stat.size);
+	}
+
+	proc_stat.buf[n] = '\0';
+
+	return true;
+}
+
+/* Reads and parses the times of all the CPUs. */
+static bool update_times(void)
+{
+	if (!log_read(&proc_stat.failed,
+		      read_stat(),
+		      PROVIDER_NAME,
+		      CPUSTAT_PROC_STAT))
+		return false;
+
+	memset(proc_stat.times, 0, proc_stat.count * sizeof(*proc_stat.times));
+	cpustat_parse(proc_stat.buf, proc_stat.times, proc_stat.count);
+
+	return true;
+}
+
+/* Returns the package of a CPU, -1 if unknown. */
+static int get_package(const char *root, int cpu)
+{
+	char dir[PATH_MAX];
+	long pkg;
+
+	snprintf(dir, sizeof(dir), "%s/cpu%d", root, cpu);
+
+	if (!sysfs_read_long(dir, "topology/physical_package_id", &pkg)
+	    || pkg < 0 || pkg > INT_MAX)
+		return -1;
+
+	return pkg;
+}
+
+static void cpustat_data_free(void *data)
+{
+	free(((struct cpustat_data *)data)->cpus);
+	free(data);
+}
+
+/*
+ * Creates the usage sensor of the 'count' CPUs 'cpus', 'key'
+ * identifies it among the sensors of the provider.
+ */
+static struct psensor *create_sensor(const char *key,
+				     const char *name,
+				     int *cpus,
+				     int count,
+				     int values_max_length)
+{
+	char *id;
+	struct cpustat_data *data;
+	struct psensor *s;
+
+	id = malloc(strlen(PROVIDER_NAME) + 1 + strlen(key) + 1);
+	sprintf(id, "%s %s", PROVIDER_NAME, key);
+
+	s = psensor_create(id,
+			   strdup(name),
+			   strdup(_("CPU")),
+			   SENSOR_TYPE_CPUSTAT | SENSOR_TYPE_CPU_USAGE,
+			   values_max_length);
+
+	data = malloc(sizeof(struct cpustat_data));
+	data->cpus = cpus;
+	data->count = count;
+	data->last.used = 0;
+	data->last.total = 0;
+
+	s->provider_data = data;
+	s->provider_data_free_fct = cpustat_data_free;
+
+	return s;
+}
+
+/* Adds the aggregated sensor of each package of the CPUs. */
+static void append_packages(struct psensor_registry *r,
+			    const char *root,
+			    int values_max_length)
+{
+	char key[32], name[64];
+	int *pkgs, *cpus;
+	int cpu, pkg, n;
+
+	pkgs = malloc(proc_stat.count * sizeof(int));
+
+	for (cpu = 0; cpu < proc_stat.count; cpu++)
+		if (proc_stat.times[cpu].total)
+			pkgs[cpu] = get_package(root, cpu);
+		else
+			pkgs[cpu] = -1;
+
+	/* the package numbers are lower than the number of CPUs */
+	for (pkg = 0; pkg < proc_stat.count; pkg++) {
+		cpus = malloc(proc_stat.count * sizeof(int));
+
+		for (cpu = 0, n = 0; cpu < proc_stat.count; cpu++)
+			if (pkgs[cpu] == pkg)
+				cpus[n++] = cpu;
+
+		if (!n) {
+			free(cpus);
+			continue;
+		}
+
+		snprintf(key, sizeof(key), "package%d usage", pkg);
+		snprintf(name, sizeof(name), _("package %d usage"), pkg);
+
+		psensor_registry_add(r,
+				     create_sensor(key,
+						   name,
+						   cpus,
+						   n,
+						   values_max_length));
+	}
+
+	free(pkgs);
+}
+
+void cpustat_psensor_list_append(struct psensor_registry *r,
+				 const char *path,
+				 const char *root,
+				 int values_max_length)
+{
+	char key[32], name[64];
+	int cpu, *cpus;
+
+	if (proc_stat.fd != -1)
+		return;
+
+	proc_stat.fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (proc_stat.fd == -1) {
+		log_err(_("%s: Cannot open %s."), PROVIDER_NAME, path);
+		return;
+	}
+
+	proc_stat.size = STAT_BUFFER_SIZE;
+	proc_stat.buf = malloc(proc_stat.size);
+
+	if (!read_stat()) {
+		log_err(_("%s: Cannot read %s."), PROVIDER_NAME, path);
+		cpustat_cleanup();
+		return;
+	}
+
+	proc_stat.count = cpustat_parse(proc_stat.buf, NULL, 0);
+	proc_stat.times = malloc(proc_stat.count * sizeof(*proc_stat.times));
+	update_times();
+
+	for (cpu = 0; cpu < proc_stat.count; cpu++) {
+		/* offline when psensor starts */
+		if (!proc_stat.times[cpu].total)
+			continue;
+
+		snprintf(key, sizeof(key), "cpu%d usage", cpu);
+		snprintf(name, sizeof(name), _("cpu%d usage"), cpu);
+
+		cpus = malloc(sizeof(int));
+		*cpus = cpu;
+
+		psensor_registry_add(r,
+				     create_sensor(key,
+						   name,
+						   cpus,
+						   1,
+						   values_max_length));
+	}
+
+	append_packages(r, root, values_max_length);
+}
+
+void cpustat_psensor_list_update(struct psensor **sensors)
+{
+	struct psensor_batch b;
+	struct cpustat_data *data;
+	struct cpustat_times cur;
+	double v;
+	int i, k, cpu;
+
+	if (!sensors || !update_times())
+		return;
+
+	psensor_batch_begin(&b, sensors);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+
+		cur.used = 0;
+		cur.total = 0;
+		for (k = 0; k < data->count; k++) {
+			cpu = data->cpus[k];
+
+			cur.used += proc_stat.times[cpu].used;
+			cur.total += proc_stat.times[cpu].total;
+		}
+
+		if (data->last.total) {
+			v = cpustat_get_usage(&data->last, &cur);
+
+			if (v != UNKNOWN_DBL_VALUE)
+				psensor_batch_set(&b, i, v);
+		}
+
+		data->last = cur;
+	}
+
+	psensor_batch_commit(&b);
+}
+
+void cpustat_cleanup(void)
+{
+	if (proc_stat.fd != -1)
+		close(proc_stat.fd);
+
+	free(proc_stat.buf);
+	free(proc_stat.times);
+
+	proc_stat.fd = -1;
+	proc_stat.buf = NULL;
+	proc_stat.times = NULL;
+	proc_stat.count = 0;
+	proc_stat.failed = false;
+}
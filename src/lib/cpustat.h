@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_CPUSTAT_H_
+#define _PSENSOR_CPUSTAT_H_
+
+#include <stdint.h>
+
+#include <pregistry.h>
+#include <psensor.h>
+
+/* File of the CPU times of the kernel */
+#define CPUSTAT_PROC_STAT "/proc/stat"
+
+/* Directory of the CPUs, for their package */
+#define CPUSTAT_SYSFS_ROOT "/sys/devices/system/cpu"
+
+/* Times of a CPU, in USER_HZ, 0 if it is not listed */
+struct cpustat_times {
+	/* user, nice, system, irq, softirq and steal */
+	uint64_t used;
+
+	/* used, idle and iowait */
+	uint64_t total;
+};
+
+/*
+ * Parses the 'cpuN' lines of the content of /proc/stat, the times of
+ * each CPU N below 'n' are added to 'times[N]'.
+ *
+ * Returns the highest N plus 1, whatever 'n'.
+ */
+int cpustat_parse(const char *buf, struct cpustat_times *times, int n);
+
+/*
+ * Returns the usage in percent between the times 'last' and 'cur',
+ * UNKNOWN_DBL_VALUE if no time elapsed or if the counters went
+ * backward.
+ */
+double cpustat_get_usage(const struct cpustat_times *last,
+			 const struct cpustat_times *cur);
+
+/*
+ * Adds a usage sensor for each CPU listed in the file 'path', usually
+ * CPUSTAT_PROC_STAT, and for each package of CPUs.  The packages are
+ * read in the directory 'root', usually CPUSTAT_SYSFS_ROOT.
+ */
+void cpustat_psensor_list_append(struct psensor_registry *r,
+				 const char *path,
+				 const char *root,
+				 int values_max_length);
+
+/*
+ * Reads the times of all the CPUs once and sets the usage of each
+ * sensor since the previous update, nothing is set by the first one.
+ */
+void cpustat_psensor_list_update(struct psensor **sensors);
+
+void cpustat_cleanup(void);
+
+#endif
@@ -21,25 +21,27 @@
 
 #include <bool.h>
 #include <config.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_ATASMART) && HAVE_ATASMART
 
 static inline bool atasmart_is_supported(void) { return true; }
 
-void atasmart_psensor_list_append(struct psensor ***, int);
+void atasmart_psensor_list_append(struct psensor_registry *, int);
 void atasmart_psensor_list_update(struct psensor **);
 
 #else
 
 static inline bool atasmart_is_supported(void) { return false; }
 
-static inline void atasmart_psensor_list_append(struct psensor ***s, int n) {}
+static inline void
+atasmart_psensor_list_append(struct psensor_registry *r, int n) {}
 static inline void atasmart_psensor_list_update(struct psensor **s) {}
 
 #endif
 
-void hddtemp_psensor_list_append(struct psensor ***sensors, int values_length);
+void hddtemp_psensor_list_append(struct psensor_registry *r, int values_length);
 void hddtemp_psensor_list_update(struct psensor **sensors);
 
 #endif
@@ -122,7 +122,7 @@ static void analyze_disk(const char *dname)
 }
 
 void
-atasmart_psensor_list_append(struct psensor ***sensors, int values_max_length)
+atasmart_psensor_list_append(struct psensor_registry *r, int values_max_length)
 {
 	char **paths, **tmp, *id;
 	SkDisk *disk;
@@ -148,7 +148,7 @@ atasmart_psensor_list_append(struct psensor ***sensors, int values_max_length)
 					       disk,
 					       values_max_length);
 
-			psensor_list_append(sensors, sensor);
+			psensor_registry_add(r, sensor);
 		} else {
 			log_err(_("%s: sk_disk_open() failure: %s."),
 				PROVIDER_NAME,
@@ -166,36 +166,34 @@ atasmart_psensor_list_append(struct psensor ***sensors, int values_max_length)
 
 void atasmart_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor **cur, *s;
+	struct psensor_batch b;
+	struct psensor *s;
 	uint64_t kelvin;
-	int ret;
+	int i, ret;
 	double c;
 	SkDisk *disk;
 
 	if (!sensors)
 		return;
 
-	cur = sensors;
-	while (*cur) {
-		s = *cur;
-		if (!(s->type & SENSOR_TYPE_REMOTE)
-		    && s->type & SENSOR_TYPE_ATASMART) {
-			disk = get_disk(s);
+	psensor_batch_begin(&b, sensors);
+
+	for (i = 0; sensors[i]; i++) {
+		s = sensors[i];
+		disk = get_disk(s);
+
+		ret = sk_disk_smart_read_data(disk);
 
-			ret = sk_disk_smart_read_data(disk);
+		if (!ret) {
+			ret = sk_disk_smart_get_temperature(disk, &kelvin);
 
 			if (!ret) {
-				ret = sk_disk_smart_get_temperature(disk,
-								    &kelvin);
-
-				if (!ret) {
-					c = (kelvin - 273150) / 1000;
-					psensor_set_current_value(s, c);
-					log_fct("%s %.2f", s->id, c);
-				}
+				c = (kelvin - 273150) / 1000;
+				psensor_batch_set(&b, i, c);
+				log_fct("%s %.2f", s->id, c);
 			}
 		}
-
-		cur++;
 	}
+
+	psensor_batch_commit(&b);
 }
@@ -174,8 +174,19 @@ static char *next_hdd_info(char *string, struct hdd_info *info)
 	return c;
 }
 
+/* Returns the identifier of the sensor of a disk. */
+static char *create_id(const char *name)
+{
+	char *id;
+
+	id = malloc(strlen(PROVIDER_NAME) + 1 + strlen(name) + 1);
+	sprintf(id, "%s %s", PROVIDER_NAME, name);
+
+	return id;
+}
+
 void
-hddtemp_psensor_list_append(struct psensor ***sensors, int values_max_length)
+hddtemp_psensor_list_append(struct psensor_registry *r, int values_max_length)
 {
 	char *hddtemp_output, *c, *id;
 	struct hdd_info info;
@@ -199,53 +210,37 @@ hddtemp_psensor_list_append(struct psensor ***sensors, int values_max_length)
 	c = hddtemp_output;
 
 	while (c && (c = next_hdd_info(c, &info))) {
-		id = malloc(strlen(PROVIDER_NAME) + 1 + strlen(info.name) + 1);
-		sprintf(id, "%s %s", PROVIDER_NAME, info.name);
+		id = create_id(info.name);
 
 		sensor = create_sensor(id, info.name, values_max_length);
 
-		psensor_list_append(sensors, sensor);
+		psensor_registry_add(r, sensor);
 	}
 
 	free(hddtemp_output);
 }
 
-static void update(struct psensor **sensors, struct hdd_info *info)
-{
-	while (*sensors) {
-		if (!((*sensors)->type & SENSOR_TYPE_REMOTE)
-		    && (*sensors)->type & SENSOR_TYPE_HDDTEMP
-		    && !strcmp((*sensors)->id + 8, info->name))
-			psensor_set_current_value(*sensors,
-						  (double)info->temp);
-
-		sensors++;
-	}
-}
-
-static bool contains_hddtemp_sensor(struct psensor **sensors)
+static void update(struct psensor_batch *b, struct hdd_info *info)
 {
-	struct psensor *s;
+	char *id;
+	int i;
 
-	if (!sensors)
-		return false;
+	id = create_id(info->name);
 
-	while (*sensors) {
-		s = *sensors;
-		if (!(s->type & SENSOR_TYPE_REMOTE)
-		     && (s->type & SENSOR_TYPE_HDDTEMP))
-			return true;
-		sensors++;
-	}
+	for (i = 0; b->sensors[i]; i++)
+		if (!strcmp(b->sensors[i]->id, id)) {
+			psensor_batch_set(b, i, (double)info->temp);
+			break;
+		}
 
-	return false;
+	free(id);
 }
 
 void hddtemp_psensor_list_update(struct psensor **sensors)
 {
 	char *hddtemp_output;
 
-	if (!contains_hddtemp_sensor(sensors))
+	if (!sensors || !*sensors)
 		return;
 
 	hddtemp_output = fetch();
@@ -256,16 +251,21 @@ void hddtemp_psensor_list_update(struct psensor **sensors)
 	if (hddtemp_output[0] == '|') {
 		char *c = hddtemp_output;
 		struct hdd_info info;
+		struct psensor_batch b;
 
 		info.name = NULL;
 		info.temp = 0;
 
+		psensor_batch_begin(&b, sensors);
+
 		while (c && (c = next_hdd_info(c, &info))) {
 
-			update(sensors, &info);
+			update(&b, &info);
 
 			free(info.name);
 		}
+
+		psensor_batch_commit(&b);
 	} else {
 		log_err(_("%s: wrong string: %s."),
 			PROVIDER_NAME,
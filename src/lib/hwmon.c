@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <locale.h>
+#include <libintl.h>
+#define _(str) gettext(str)
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <hwmon.h>
+#include <parray.h>
+#include <pio.h>
+#include <preader.h>
+
+static const char *PROVIDER_NAME = "hwmon";
+
+/* Reads of the inputs of an update */
+static struct preader reader;
+
+/* Suffixes of the alarm attributes of an input, 'tempN_alarm'... */
+static const char *const ALARM_SUFFIXES[] = {
+	"alarm",
+	"max_alarm",
+	"crit_alarm"
+};
+
+#define ALARMS_COUNT ARRAY_SIZE(ALARM_SUFFIXES)
+
+/* Thread watching the alarm attributes, see hwmon_alarm_watch_start() */
+static struct alarm_watcher {
+	pthread_t thread;
+	bool started;
+
+	/* The first one is the read end of 'stop_pipe' */
+	struct pollfd *fds;
+	struct psensor **sensors;
+	int count;
+
+	int stop_pipe[2];
+
+	void (*cbk)(struct psensor *, void *);
+	void *data;
+} watcher;
+
+struct hwmon_data {
+	/* Input file, kept open */
+	int fd;
+
+	/* Content of the input file read by the last update */
+	char buf[32];
+
+	/* Divisor converting the value of the files to the sensor unit */
+	int scale;
+
+	/* See log_read() */
+	bool failed;
+
+	/* Alarm attributes of ALARM_SUFFIXES, -1 if they do not exist */
+	int alarm_fds[ALARMS_COUNT];
+};
+
+/*
+ * Reads the value of an open attribute from its beginning, sysfs
+ * regenerates the content at each read at offset 0.
+ */
+static bool read_long(int fd, long *v)
+{
+	char buf[32];
+	ssize_t n;
+
+	n = pread(fd, buf, sizeof(buf), 0);
+	if (n <= 0)
+		return false;
+
+	return sysfs_parse_long(buf, n, v);
+}
+
+static void hwmon_data_free(void *data)
+{
+	struct hwmon_data *d;
+	unsigned int i;
+
+	d = data;
+
+	close(d->fd);
+
+	for (i = 0; i < ALARMS_COUNT; i++)
+		if (d->alarm_fds[i] != -1)
+			close(d->alarm_fds[i]);
+
+	free(d);
+}
+
+/* Returns the displayed name of a chip, see lmsensor.c. */
+static char *get_chip_name(const char *prefix)
+{
+	if (!strcmp(prefix, "coretemp"))
+		return strdup(_("Intel CPU"));
+
+	if (!strcmp(prefix, "k10temp")
+	    || !strcmp(prefix, "k8temp")
+	    || !strcmp(prefix, "fam15h_power"))
+		return strdup(_("AMD CPU"));
+
+	if (!strcmp(prefix, "nouveau"))
+		return strdup(_("NVIDIA GPU"));
+
+	if (!strcmp(prefix, "via-cputemp"))
+		return strdup(_("VIA CPU"));
+
+	if (!strcmp(prefix, "acpitz"))
+		return strdup(_("ACPI"));
+
+	return strdup(prefix);
+}
+
+/* Copies into 'buf' the name of the target of the link 'path'. */
+static bool read_link_name(const char *path, char *buf, size_t size)
+{
+	char target[PATH_MAX];
+	const char *name;
+	ssize_t n;
+
+	n = readlink(path, target, sizeof(target) - 1);
+	if (n <= 0)
+		return false;
+	target[n] = '\0';
+
+	name = strrchr(target, '/');
+	if (name)
+		name++;
+	else
+		name = target;
+
+	return snprintf(buf, size, "%s", name) < (int)size;
+}
+
+/*
+ * Copies into 'buf' the bus and the name of the device of the hwmon
+ * directory 'dir', such as 'platform-coretemp.0' or
+ * 'pci-0000:01:00.0'.  Unlike 'hwmonN', which depends on the probing
+ * order of the drivers, it is stable across the reboots.
+ *
+ * Returns false for a virtual device, which has no 'device' link.
+ */
+static bool get_bus_name(const char *dir, char *buf, size_t size)
+{
+	char path[PATH_MAX], bus[64], dev[NAME_MAX + 1];
+
+	if (snprintf(path, sizeof(path), "%s/device", dir) >= PATH_MAX
+	    || !read_link_name(path, dev, sizeof(dev)))
+		return false;
+
+	if (snprintf(path, sizeof(path), "%s/device/subsystem", dir) >= PATH_MAX
+	    || !read_link_name(path, bus, sizeof(bus)))
+		return false;
+
+	return snprintf(buf, size, "%s-%s", bus, dev) < (int)size;
+}
+
+/*
+ * Creates the sensor of the input file 'input' of a device,
+ * 'tempN_input' or 'fanN_input', 'bus' identifies the device, see
+ * get_bus_name().
+ *
+ * Returns NULL if the sensor is faulty or cannot be read.
+ */
+static struct psensor *create_sensor(const char *dir,
+				     const char *bus,
+				     const char *chip,
+				     const char *input,
+				     int values_max_length)
+{
+	char attr[NAME_MAX + 1], label[64], path[PATH_MAX];
+	const char *kind;
+	char *id;
+	int fd, type, scale, len;
+	unsigned int i;
+	long v;
+	struct hwmon_data *data;
+	struct psensor *s;
+
+	if (!strncmp(input, "temp", 4)) {
+		type = SENSOR_TYPE_HWMON | SENSOR_TYPE_TEMP;
+		scale = 1000;
+	} else {
+		type = SENSOR_TYPE_HWMON | SENSOR_TYPE_RPM | SENSOR_TYPE_FAN;
+		scale = 1;
+	}
+
+	/* 'tempN' or 'fanN', the prefix of the other attributes */
+	kind = strchr(input, '_');
+	len = kind - input;
+
+	snprintf(attr, sizeof(attr), "%.*s_fault", len, input);
+	if (sysfs_read_long(dir, attr, &v) && v)
+		return NULL;
+
+	if (snprintf(path, sizeof(path), "%s/%s", dir, input) >= PATH_MAX)
+		return NULL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		log_err(_("%s: Cannot open %s."), PROVIDER_NAME, path);
+		return NULL;
+	}
+
+	if ((type & SENSOR_TYPE_TEMP) && !read_long(fd, &v)) {
+		close(fd);
+		return NULL;
+	}
+
+	snprintf(attr, sizeof(attr), "%.*s_label", len, input);
+	if (!sysfs_read(dir, attr, label, sizeof(label)))
+		snprintf(label, sizeof(label), "%.*s", len, input);
+
+	id = malloc(strlen(PROVIDER_NAME)
+		    + 1
+		    + strlen(chip)
+		    + 1
+		    + strlen(bus)
+		    + 1
+		    + strlen(label)
+		    + 1);
+	sprintf(id, "%s %s-%s %s", PROVIDER_NAME, chip, bus, label);
+
+	s = psensor_create(id,
+			   strdup(label),
+			   get_chip_name(chip),
+			   type,
+			   values_max_length);
+
+	snprintf(attr, sizeof(attr), "%.*s_max", len, input);
+	if (sysfs_read_long(dir, attr, &v))
+		s->max = (double)v / scale;
+
+	snprintf(attr, sizeof(attr), "%.*s_min", len, input);
+	if (sysfs_read_long(dir, attr, &v))
+		s->min = (double)v / scale;
+
+	data = malloc(sizeof(struct hwmon_data));
+	data->fd = fd;
+	data->scale = scale;
+	data->failed = false;
+
+	for (i = 0; i < ALARMS_COUNT; i++) {
+		snprintf(attr,
+			 sizeof(attr),
+			 "%.*s_%s",
+			 len,
+			 input,
+			 ALARM_SUFFIXES[i]);
+
+		data->alarm_fds[i] = -1;
+		if (snprintf(path, sizeof(path), "%s/%s", dir, attr)
+		    < PATH_MAX)
+			data->alarm_fds[i] = open(path, O_RDONLY | O_CLOEXEC);
+	}
+
+	s->provider_data = data;
+	s->provider_data_free_fct = hwmon_data_free;
+
+	return s;
+}
+
+/* Selects the 'tempN_input' and 'fanN_input' files. */
+static int is_input(const struct dirent *e)
+{
+	const char *suffix;
+
+	if (strncmp(e->d_name, "temp", 4) && strncmp(e->d_name, "fan", 3))
+		return 0;
+
+	suffix = strchr(e->d_name, '_');
+
+	return suffix && !strcmp(suffix, "_input");
+}
+
+static void append_device(struct psensor_registry *r,
+			  const char *root,
+			  const char *dev,
+			  int values_max_length)
+{
+	char dir[PATH_MAX], chip[64], bus[128];
+	struct dirent **inputs;
+	struct psensor *s;
+	int i, n;
+
+	snprintf(dir, sizeof(dir), "%s/%s", root, dev);
+
+	if (!get_bus_name(dir, bus, sizeof(bus)))
+		snprintf(bus, sizeof(bus), "%s", dev);
+
+	/* the attributes of the old drivers are in the device directory */
+	if (!sysfs_read(dir, "name", chip, sizeof(chip))) {
+		snprintf(dir, sizeof(dir), "%s/%s/device", root, dev);
+
+		if (!sysfs_read(dir, "name", chip, sizeof(chip)))
+			return;
+	}
+
+	n = scandir(dir, &inputs, is_input, alphasort);
+	if (n == -1)
+		return;
+
+	for (i = 0; i < n; i++) {
+		s = create_sensor(dir,
+				  bus,
+				  chip,
+				  inputs[i]->d_name,
+				  values_max_length);
+
+		if (s)
+			psensor_registry_add(r, s);
+
+		free(inputs[i]);
+	}
+
+	free(inputs);
+}
+
+static int is_device(const struct dirent *e)
+{
+	return e->d_name[0] != '.';
+}
+
+void hwmon_psensor_list_append(struct psensor_registry *r,
+			       const char *root,
+			       int values_max_length)
+{
+	struct dirent **devs;
+	int i, n;
+
+	n = scandir(root, &devs, is_device, alphasort);
+	if (n == -1) {
+		log_err(_("%s: Cannot list %s."), PROVIDER_NAME, root);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		append_device(r, root, devs[i]->d_name, values_max_length);
+		free(devs[i]);
+	}
+
+	free(devs);
+}
+
+void hwmon_psensor_list_update(struct psensor **sensors)
+{
+	struct psensor_batch b;
+	struct hwmon_data *data;
+	ssize_t n;
+	bool ok;
+	long v;
+	int i;
+
+	if (!sensors)
+		return;
+
+	preader_clear(&reader);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		preader_add(&reader, data->fd, data->buf, sizeof(data->buf));
+	}
+
+	preader_run(&reader);
+
+	psensor_batch_begin(&b, sensors);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		n = reader.reqs[i].ret;
+
+		ok = n > 0 && sysfs_parse_long(data->buf, n, &v);
+		if (log_read(&data->failed, ok, PROVIDER_NAME, sensors[i]->id))
+			psensor_batch_set(&b, i, (double)v / data->scale);
+	}
+
+	psensor_batch_commit(&b);
+}
+
+/* Body of the watching thread, 'arg' is the watcher. */
+static void *watch_alarms(void *arg)
+{
+	struct alarm_watcher *w;
+	struct pollfd *fds;
+	int i, n;
+	long v;
+
+	w = arg;
+	fds = w->fds;
+
+	while (1) {
+		n = poll(fds, w->count + 1, -1);
+
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+
+			log_err(_("%s: Cannot watch the alarms: %s."),
+				PROVIDER_NAME,
+				strerror(errno));
+			break;
+		}
+
+		if (fds[0].revents)
+			break;
+
+		for (i = 1; i <= w->count; i++) {
+			if (!(fds[i].revents & (POLLPRI | POLLERR)))
+				continue;
+
+			/* the read acknowledges the notification */
+			if (read_long(fds[i].fd, &v) && v) {
+				log_debug("%s: alarm of %s.",
+					  PROVIDER_NAME,
+					  w->sensors[i - 1]->id);
+
+				w->cbk(w->sensors[i - 1], w->data);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static void free_watcher(void)
+{
+	close(watcher.stop_pipe[0]);
+	close(watcher.stop_pipe[1]);
+
+	free(watcher.fds);
+	free(watcher.sensors);
+
+	watcher.fds = NULL;
+	watcher.sensors = NULL;
+	watcher.count = 0;
+}
+
+bool hwmon_alarm_watch_start(struct psensor **sensors,
+			     void (*cbk)(struct psensor *, void *),
+			     void *data)
+{
+	struct hwmon_data *d;
+	unsigned int k;
+	int i, n;
+	long v;
+
+	if (watcher.started || !sensors)
+		return false;
+
+	/* at most ALARMS_COUNT attributes by sensor */
+	for (i = 0, n = 0; sensors[i]; i++)
+		n += ALARMS_COUNT;
+
+	if (pipe(watcher.stop_pipe) == -1)
+		return false;
+
+	watcher.fds = malloc((n + 1) * sizeof(struct pollfd));
+	watcher.sensors = malloc(n * sizeof(struct psensor *));
+	watcher.cbk = cbk;
+	watcher.data = data;
+
+	watcher.fds[0].fd = watcher.stop_pipe[0];
+	watcher.fds[0].events = POLLIN;
+
+	for (i = 0, n = 0; sensors[i]; i++) {
+		d = sensors[i]->provider_data;
+
+		for (k = 0; k < ALARMS_COUNT; k++) {
+			if (d->alarm_fds[k] == -1)
+				continue;
+
+			/* sysfs notifies only the changes after a read */
+			read_long(d->alarm_fds[k], &v);
+
+			watcher.fds[n + 1].fd = d->alarm_fds[k];
+			watcher.fds[n + 1].events = POLLPRI;
+			watcher.sensors[n] = sensors[i];
+			n++;
+		}
+	}
+	watcher.count = n;
+
+	if (!n
+	    || pthread_create(&watcher.thread, NULL, watch_alarms, &watcher)) {
+		free_watcher();
+		return false;
+	}
+
+	log_debug("%s: watching %d alarm attributes.", PROVIDER_NAME, n);
+
+	watcher.started = true;
+
+	return true;
+}
+
+void hwmon_alarm_watch_stop(void)
+{
+	if (!watcher.started)
+		return;
+
+	if (write(watcher.stop_pipe[1], "", 1) == 1)
+		pthread_join(watcher.thread, NULL);
+	else
+		pthread_cancel(watcher.thread);
+
+	free_watcher();
+
+	watcher.started = false;
+}
+
+void hwmon_cleanup(void)
+{
+	hwmon_alarm_watch_stop();
+	preader_free(&reader);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_HWMON_H_
+#define _PSENSOR_HWMON_H_
+
+#include <pregistry.h>
+#include <psensor.h>
+
+/* Directory of the hwmon devices exposed by the kernel */
+#define HWMON_SYSFS_ROOT "/sys/class/hwmon"
+
+/*
+ * Adds the temperature and fan sensors of the hwmon devices found in
+ * the directory 'root', usually HWMON_SYSFS_ROOT.
+ *
+ * Unlike the lmsensor provider, the input files are read directly:
+ * they are opened once and stay open until the sensors are freed.
+ *
+ * Like the ones of lmsensor, the identifiers of the sensors contain
+ * the bus of their device, 'hwmonN' only for the virtual devices.
+ */
+void hwmon_psensor_list_append(struct psensor_registry *r,
+			       const char *root,
+			       int values_max_length);
+
+/*
+ * Reads all the inputs of 'sensors' in a batch, with io_uring when
+ * available, see preader.h.
+ */
+void hwmon_psensor_list_update(struct psensor **sensors);
+
+/*
+ * Watches with poll(POLLPRI) the alarm attributes of the hwmon
+ * 'sensors', 'tempN_alarm', 'tempN_crit_alarm'...  The drivers
+ * supporting it notify the changes of these attributes, an alarm is
+ * then known without waiting for the next update.
+ *
+ * 'cbk' is called by the watching thread with the sensor whose alarm
+ * has been set, concurrently with the updates of the sensors.
+ *
+ * Returns false if none of the sensors has an alarm attribute or if
+ * the thread cannot be started.
+ */
+bool hwmon_alarm_watch_start(struct psensor **sensors,
+			     void (*cbk)(struct psensor *, void *),
+			     void *data);
+
+/* Stops the watching thread, the callback is no more called. */
+void hwmon_alarm_watch_stop(void);
+
+/* Stops the alarm watching and frees the provider resources. */
+void hwmon_cleanup(void);
+
+#endif
@@ -28,38 +28,115 @@
 #include <sensors/error.h>
 
 #include <lmsensor.h>
+#include <ptime.h>
 
 static int init_done;
 
 static const char *PROVIDER_NAME = "lmsensor";
 
+/* Alarm subfeatures of a feature, as the hwmon provider */
+#define ALARMS_COUNT 3
+
+static const sensors_subfeature_type TEMP_ALARMS[ALARMS_COUNT] = {
+	SENSORS_SUBFEATURE_TEMP_ALARM,
+	SENSORS_SUBFEATURE_TEMP_MAX_ALARM,
+	SENSORS_SUBFEATURE_TEMP_CRIT_ALARM
+};
+
+static const sensors_subfeature_type FAN_ALARMS[ALARMS_COUNT] = {
+	SENSORS_SUBFEATURE_FAN_ALARM,
+	SENSORS_SUBFEATURE_FAN_MIN_ALARM,
+	SENSORS_SUBFEATURE_FAN_MAX_ALARM
+};
+
+/*
+ * Period of the reads of the alarm subfeatures, in microseconds: the
+ * hardware latches them, they do not have to be read at each update.
+ */
+static const int64_t ALARMS_PERIOD_US = 10 * 1000000;
+
+/* Time of the last read of the alarm subfeatures */
+static int64_t alarms_time;
+
+/* Numbers of the subfeatures of a sensor, resolved at creation */
 struct lmsensor_data {
 	const sensors_chip_name *chip;
 
-	const sensors_feature *feature;
+	int input;
+
+	/* The limits, -1 if they do not exist */
+	int min;
+	int max;
+	int crit;
+
+	/* The existing alarm subfeatures, the first 'alarms_count' */
+	int alarms[ALARMS_COUNT];
+	int alarms_count;
+
+	/* Whether one of the alarm subfeatures was set at the last read */
+	bool alarm;
+
+	/* Whether the last read of the input failed */
+	bool failed;
 };
 
-static const sensors_chip_name *get_chip_name(struct psensor *s)
+/* Returns the number of a subfeature of a feature, -1 if none. */
+static int get_subfeature_number(const sensors_chip_name *chip,
+				 const sensors_feature *feature,
+				 sensors_subfeature_type type)
 {
-	return ((struct lmsensor_data *)s->provider_data)->chip;
-}
+	const sensors_subfeature *sf;
 
-static const sensors_feature *get_feature(struct psensor *s)
-{
-	return ((struct lmsensor_data *)s->provider_data)->feature;
+	sf = sensors_get_subfeature(chip, feature, type);
+	if (sf)
+		return sf->number;
+
+	return -1;
 }
 
-static void lmsensor_data_set(struct psensor *s,
-			      const struct sensors_chip_name *chip,
-			      const struct sensors_feature *feature)
+static struct lmsensor_data *
+lmsensor_data_create(const sensors_chip_name *chip,
+		     const sensors_feature *feature,
+		     int input)
 {
 	struct lmsensor_data *data;
+	sensors_subfeature_type type;
+	int i, n;
 
 	data = malloc(sizeof(struct lmsensor_data));
 	data->chip = chip;
-	data->feature = feature;
+	data->input = input;
+	data->alarm = false;
+	data->failed = false;
 
-	s->provider_data = data;
+	if (feature->type == SENSORS_FEATURE_TEMP) {
+		data->min = get_subfeature_number
+			(chip, feature, SENSORS_SUBFEATURE_TEMP_MIN);
+		data->max = get_subfeature_number
+			(chip, feature, SENSORS_SUBFEATURE_TEMP_MAX);
+		data->crit = get_subfeature_number
+			(chip, feature, SENSORS_SUBFEATURE_TEMP_CRIT);
+	} else {
+		data->min = get_subfeature_number
+			(chip, feature, SENSORS_SUBFEATURE_FAN_MIN);
+		data->max = get_subfeature_number
+			(chip, feature, SENSORS_SUBFEATURE_FAN_MAX);
+		data->crit = -1;
+	}
+
+	data->alarms_count = 0;
+	for (i = 0; i < ALARMS_COUNT; i++) {
+		if (feature->type == SENSORS_FEATURE_TEMP)
+			type = TEMP_ALARMS[i];
+		else
+			type = FAN_ALARMS[i];
+
+		n = get_subfeature_number(chip, feature, type);
+		if (n != -1)
+			data->alarms[data->alarms_count++] = n;
+	}
+
+	return data;
 }
 
 static double get_value(const sensors_chip_name *name,
@@ -79,71 +156,110 @@ static double get_value(const sensors_chip_name *name,
 	return val;
 }
 
-static double get_temp_input(struct psensor *sensor)
+/* Returns the value of the subfeature 'number', if it exists. */
+static double get_limit(const sensors_chip_name *chip, int number)
 {
-	const sensors_subfeature *sf;
+	double val;
 
-	const sensors_chip_name *chip;
+	if (number != -1 && !sensors_get_value(chip, number, &val))
+		return val;
 
-	const sensors_feature *feature;
+	return UNKNOWN_DBL_VALUE;
+}
 
-	chip = get_chip_name(sensor);
-	feature = get_feature(sensor);
+/* Reads the input of a sensor with the cached subfeature number. */
+static double get_input(struct psensor *s)
+{
+	struct lmsensor_data *data;
+	double val;
+	int err;
 
-	sf = sensors_get_subfeature(chip,
-				    feature,
-				    SENSORS_SUBFEATURE_TEMP_INPUT);
-	if (sf)
-		return get_value(chip, sf);
+	data = s->provider_data;
+
+	err = sensors_get_value(data->chip, data->input, &val);
+	if (!err) {
+		data->failed = false;
+		return val;
+	}
+
+	if (!data->failed) {
+		log_err(_("%s: Cannot get value of %s: %s."),
+			PROVIDER_NAME,
+			s->id,
+			sensors_strerror(err));
+		data->failed = true;
+	}
 
 	return UNKNOWN_DBL_VALUE;
 }
 
-static double get_fan_input(struct psensor *sensor)
+/* Whether one of the alarm subfeatures of a sensor is set. */
+static bool is_alarm_set(const struct lmsensor_data *data)
 {
-	const sensors_chip_name *chip;
-	const sensors_feature *feature;
+	double val;
+	int i;
 
-	const sensors_subfeature *sf;
+	for (i = 0; i < data->alarms_count; i++)
+		if (!sensors_get_value(data->chip, data->alarms[i], &val)
+		    && val)
+			return true;
 
-	chip = get_chip_name(sensor);
-	feature = get_feature(sensor);
+	return false;
+}
 
-	sf = sensors_get_subfeature(chip,
-				    feature,
-				    SENSORS_SUBFEATURE_FAN_INPUT);
+/*
+ * Reads the alarm subfeatures of the sensors at most once per
+ * ALARMS_PERIOD_US and raises the alarm of a sensor when one of them
+ * gets set.
+ */
+static void update_alarms(struct psensor **sensors)
+{
+	struct lmsensor_data *data;
+	int64_t now;
+	bool alarm;
 
-	if (sf)
-		return get_value(chip, sf);
+	now = get_monotonic_time_us();
+	if (alarms_time && now - alarms_time < ALARMS_PERIOD_US)
+		return;
 
-	return UNKNOWN_DBL_VALUE;
+	alarms_time = now;
+
+	for (; *sensors; sensors++) {
+		data = (*sensors)->provider_data;
+
+		if (!data->alarms_count)
+			continue;
+
+		alarm = is_alarm_set(data);
+
+		if (alarm && !data->alarm)
+			psensor_raise_alarm(*sensors);
+
+		data->alarm = alarm;
+	}
 }
 
 void lmsensor_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor *s;
+	struct psensor_batch b;
 	double v;
+	int i;
 
 	if (!init_done || !sensors)
 		return;
 
-	while (*sensors) {
-		s = *sensors;
+	psensor_batch_begin(&b, sensors);
 
-		if (!(s->type & SENSOR_TYPE_REMOTE)
-		    && s->type & SENSOR_TYPE_LMSENSOR) {
+	for (i = 0; sensors[i]; i++) {
+		v = get_input(sensors[i]);
 
-			if (s->type & SENSOR_TYPE_TEMP)
-				v = get_temp_input(s);
-			else /* s->type & SENSOR_TYPE_RPM */
-				v = get_fan_input(s);
+		if (v != UNKNOWN_DBL_VALUE)
+			psensor_batch_set(&b, i, v);
+	}
 
-			if (v != UNKNOWN_DBL_VALUE)
-				psensor_set_current_value(s, v);
-		}
+	psensor_batch_commit(&b);
 
-		sensors++;
-	}
+	update_alarms(sensors);
 }
 
 static struct psensor *
@@ -156,20 +272,18 @@ lmsensor_psensor_create(const sensors_chip_name *chip,
 	int type;
 	char *id, *label, *cname;
 	struct psensor *psensor;
-	sensors_subfeature_type fault_subfeature, min_subfeature,
-		max_subfeature;
+	struct lmsensor_data *data;
+	sensors_subfeature_type input_subfeature, fault_subfeature;
 
 	if (sensors_snprintf_chip_name(name, 200, chip) < 0)
 		return NULL;
 
 	if (feature->type == SENSORS_FEATURE_TEMP) {
+		input_subfeature = SENSORS_SUBFEATURE_TEMP_INPUT;
 		fault_subfeature = SENSORS_SUBFEATURE_TEMP_FAULT;
-		max_subfeature = SENSORS_SUBFEATURE_TEMP_MAX;
-		min_subfeature = SENSORS_SUBFEATURE_TEMP_MIN;
 	} else if (feature->type == SENSORS_FEATURE_FAN) {
+		input_subfeature = SENSORS_SUBFEATURE_FAN_INPUT;
 		fault_subfeature = SENSORS_SUBFEATURE_FAN_FAULT;
-		max_subfeature = SENSORS_SUBFEATURE_FAN_MAX;
-		min_subfeature = SENSORS_SUBFEATURE_FAN_MIN;
 	} else {
 		log_err(_("%s: Wrong feature type."), PROVIDER_NAME);
 		return NULL;
@@ -179,6 +293,14 @@ lmsensor_psensor_create(const sensors_chip_name *chip,
 	if (sf && get_value(chip, sf))
 		return NULL;
 
+	sf = sensors_get_subfeature(chip, feature, input_subfeature);
+	if (!sf)
+		return NULL;
+
+	if (feature->type == SENSORS_FEATURE_TEMP
+	    && get_value(chip, sf) == UNKNOWN_DBL_VALUE)
+		return NULL;
+
 	label = sensors_get_label(chip, feature);
 	if (!label)
 		return NULL;
@@ -216,21 +338,16 @@ lmsensor_psensor_create(const sensors_chip_name *chip,
 
 	psensor = psensor_create(id, label, cname, type, values_max_length);
 
-	sf = sensors_get_subfeature(chip, feature, max_subfeature);
-	if (sf)
-		psensor->max = get_value(chip, sf);
+	data = lmsensor_data_create(chip, feature, sf->number);
 
-	sf = sensors_get_subfeature(chip, feature, min_subfeature);
-	if (sf)
-		psensor->min = get_value(chip, sf);
+	psensor->min = get_limit(chip, data->min);
+	psensor->max = get_limit(chip, data->max);
 
-	lmsensor_data_set(psensor, chip, feature);
+	/* the critical limit is the threshold of the chips without max */
+	if (psensor->max == UNKNOWN_DBL_VALUE)
+		psensor->max = get_limit(chip, data->crit);
 
-	if (feature->type == SENSORS_FEATURE_TEMP
-	    && (get_temp_input(psensor) == UNKNOWN_DBL_VALUE)) {
-		free(psensor);
-		return NULL;
-	}
+	psensor->provider_data = data;
 
 	return psensor;
 }
@@ -251,7 +368,7 @@ static void lmsensor_init(void)
 	}
 }
 
-void lmsensor_psensor_list_append(struct psensor ***sensors, int vn)
+void lmsensor_psensor_list_append(struct psensor_registry *r, int vn)
 {
 	const sensors_chip_name *chip;
 	int chip_nr, i;
@@ -275,7 +392,7 @@ void lmsensor_psensor_list_append(struct psensor ***sensors, int vn)
 				s = lmsensor_psensor_create(chip, feature, vn);
 
 				if (s)
-					psensor_list_append(sensors, s);
+					psensor_registry_add(r, s);
 			}
 		}
 	}
@@ -20,6 +20,7 @@
 #define _PSENSOR_LMSENSOR_H_
 
 #include <bool.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_LIBSENSORS) && HAVE_LIBSENSORS
@@ -27,7 +28,7 @@
 static inline bool lmsensor_is_supported(void) { return true; }
 
 void lmsensor_psensor_list_update(struct psensor **);
-void lmsensor_psensor_list_append(struct psensor ***, int);
+void lmsensor_psensor_list_append(struct psensor_registry *, int);
 void lmsensor_cleanup(void);
 
 #else
@@ -35,7 +36,8 @@ void lmsensor_cleanup(void);
 static inline bool lmsensor_is_supported(void) { return false; }
 
 static inline void lmsensor_psensor_list_update(struct psensor **s) {}
-static inline void lmsensor_psensor_list_append(struct psensor ***s, int n) {}
+static inline void
+lmsensor_psensor_list_append(struct psensor_registry *r, int n) {}
 static inline void lmsensor_cleanup(void) {}
 
 #endif
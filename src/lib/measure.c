@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2014 jeanfi@gmail.com
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License as
@@ -21,28 +21,451 @@
 #include <string.h>
 
 #include "measure.h"
+#include "stats.h"
 
-struct measure *measures_dbl_create(int size)
+static uint64_t tv_to_ms(struct timeval tv)
+{
+	return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static struct timeval ms_to_tv(uint64_t ms)
+{
+	struct timeval tv;
+
+	tv.tv_sec = ms / 1000;
+	tv.tv_usec = (ms % 1000) * 1000;
+
+	return tv;
+}
+
+static measure_value_t to_column_value(double v)
+{
+	if (v == UNKNOWN_DBL_VALUE)
+		return UNKNOWN_MEASURE_VALUE;
+
+	return v;
+}
+
+static double from_column_value(measure_value_t v)
+{
+	if (v == UNKNOWN_MEASURE_VALUE)
+		return UNKNOWN_DBL_VALUE;
+
+	return v;
+}
+
+static void deque_init(struct measure_deque *d, int size)
+{
+	d->seqs = malloc(size * sizeof(uint32_t));
+	d->first = 0;
+	d->len = 0;
+}
+
+static void deque_free(struct measure_deque *d)
+{
+	free(d->seqs);
+	d->seqs = NULL;
+	d->len = 0;
+}
+
+static int get_index(const struct measure_columns *c, int i)
+{
+	i += c->head;
+
+	if (i >= c->size)
+		i -= c->size;
+
+	return i;
+}
+
+static measure_value_t get_seq_value(const struct measure_columns *c,
+				     uint32_t seq)
+{
+	return c->values[get_index(c, seq - (c->count - c->size))];
+}
+
+static uint32_t deque_back(const struct measure_deque *d, int size)
+{
+	return d->seqs[(d->first + d->len - 1) % size];
+}
+
+static void deque_push_back(struct measure_deque *d, int size, uint32_t seq)
+{
+	d->seqs[(d->first + d->len) % size] = seq;
+	d->len++;
+}
+
+/* Removes the measures which are not anymore in the history. */
+static void deque_evict(struct measure_deque *d,
+			const struct measure_columns *c)
+{
+	while (d->len && c->count - d->seqs[d->first] > c->size) {
+		d->first++;
+		if (d->first == c->size)
+			d->first = 0;
+		d->len--;
+	}
+}
+
+/* Adds the measure 'seq', its value must be known. */
+static void window_add(struct measure_columns *c, uint32_t seq)
+{
+	measure_value_t v;
+	struct measure_deque *d;
+
+	v = get_seq_value(c, seq);
+
+	d = &c->min_deque;
+	while (d->len && get_seq_value(c, deque_back(d, c->size)) >= v)
+		d->len--;
+	deque_push_back(d, c->size, seq);
+
+	d = &c->max_deque;
+	while (d->len && get_seq_value(c, deque_back(d, c->size)) <= v)
+		d->len--;
+	deque_push_back(d, c->size, seq);
+}
+
+/* Recomputes the queues from the content of the history. */
+static void window_rebuild(struct measure_columns *c)
+{
+	uint32_t seq;
+	int i;
+
+	c->min_deque.first = c->min_deque.len = 0;
+	c->max_deque.first = c->max_deque.len = 0;
+
+	for (i = 0; i < c->size; i++) {
+		seq = c->count - c->size + i;
+
+		if (get_seq_value(c, seq) != UNKNOWN_MEASURE_VALUE)
+			window_add(c, seq);
+	}
+}
+
+static void clear(struct measure_columns *c)
+{
+	int i;
+
+	for (i = 0; i < c->size; i++)
+		c->values[i] = UNKNOWN_MEASURE_VALUE;
+
+	memset(c->times, 0, c->size * sizeof(uint32_t));
+}
+
+void measure_columns_init(struct measure_columns *c, int size)
+{
+	c->size = size;
+	c->head = 0;
+	c->values = malloc(size * sizeof(measure_value_t));
+	c->times = malloc(size * sizeof(uint32_t));
+	timerclear(&c->epoch);
+	c->count = size;
+
+	deque_init(&c->min_deque, size);
+	deque_init(&c->max_deque, size);
+
+	clear(c);
+}
+
+void measure_columns_free(struct measure_columns *c)
+{
+	free(c->values);
+	free(c->times);
+
+	deque_free(&c->min_deque);
+	deque_free(&c->max_deque);
+
+	c->values = NULL;
+	c->times = NULL;
+	c->size = 0;
+}
+
+void measure_columns_copy(struct measure_columns *c,
+			  const struct measure_columns *src,
+			  int size)
+{
+	int i, j, n;
+
+	measure_columns_init(c, size);
+
+	c->epoch = src->epoch;
+
+	n = src->size < size ? src->size : size;
+
+	for (i = 0; i < n; i++) {
+		j = get_index(src, src->size - n + i);
+		c->values[size - n + i] = src->values[j];
+		c->times[size - n + i] = src->times[j];
+	}
+
+	window_rebuild(c);
+}
+
+/*
+ * Moves the epoch so that both the stored timestamps and 'tv' can
+ * be expressed as 32 bits offsets.  Measures which are too old
+ * are dropped.
+ */
+static void rebase(struct measure_columns *c, struct timeval tv)
+{
+	uint64_t old_epoch, epoch, t;
+	int i;
+
+	old_epoch = tv_to_ms(c->epoch);
+	epoch = tv_to_ms(tv);
+
+	for (i = 0; i < c->size; i++) {
+		if (!c->times[i])
+			continue;
+
+		t = old_epoch + c->times[i] - 1;
+		if (t < epoch && tv_to_ms(tv) - t < UINT32_MAX - 1)
+			epoch = t;
+	}
+
+	for (i = 0; i < c->size; i++) {
+		if (!c->times[i])
+			continue;
+
+		t = old_epoch + c->times[i] - 1;
+		if (t < epoch || t - epoch >= UINT32_MAX - 1) {
+			c->times[i] = 0;
+			c->values[i] = UNKNOWN_MEASURE_VALUE;
+		} else {
+			c->times[i] = t - epoch + 1;
+		}
+	}
+
+	c->epoch = ms_to_tv(epoch);
+
+	window_rebuild(c);
+}
+
+void measure_columns_push(struct measure_columns *c,
+			  double value,
+			  struct timeval tv)
+{
+	uint64_t t, epoch;
+	uint32_t offset, seq;
+
+	if (timerisset(&tv)) {
+		if (!timerisset(&c->epoch))
+			c->epoch = tv;
+
+		t = tv_to_ms(tv);
+		epoch = tv_to_ms(c->epoch);
+
+		if (t < epoch || t - epoch >= UINT32_MAX - 1) {
+			rebase(c, tv);
+			epoch = tv_to_ms(c->epoch);
+		}
+
+		offset = t - epoch + 1;
+	} else {
+		offset = 0;
+	}
+
+	c->values[c->head] = to_column_value(value);
+	c->times[c->head] = offset;
+
+	c->head++;
+	if (c->head == c->size)
+		c->head = 0;
+
+	seq = c->count;
+	c->count++;
+
+	deque_evict(&c->min_deque, c);
+	deque_evict(&c->max_deque, c);
+
+	if (value != UNKNOWN_DBL_VALUE)
+		window_add(c, seq);
+}
+
+void measure_columns_get(const struct measure_columns *c,
+			 int i,
+			 struct measure *m)
+{
+	uint32_t t;
+
+	i = get_index(c, i);
+
+	m->value = from_column_value(c->values[i]);
+
+	t = c->times[i];
+	if (t)
+		m->time = ms_to_tv(tv_to_ms(c->epoch) + t - 1);
+	else
+		timerclear(&m->time);
+}
+
+/*
+ * Returns the value of the first measure of a queue.
+ *
+ * The history may be read while being updated (see psensor.c), the
+ * result is then discarded but the indexes must be checked to stay
+ * in the bounds of the arrays.
+ */
+static double deque_front_value(const struct measure_columns *c,
+				const struct measure_deque *d)
+{
+	uint32_t i;
+
+	if (!d->len)
+		return UNKNOWN_DBL_VALUE;
+
+	i = d->seqs[d->first % c->size] - (c->count - c->size);
+	if (i >= (uint32_t)c->size)
+		return UNKNOWN_DBL_VALUE;
+
+	return from_column_value(c->values[get_index(c, i)]);
+}
+
+double measure_columns_get_min(const struct measure_columns *c)
+{
+	return deque_front_value(c, &c->min_deque);
+}
+
+double measure_columns_get_max(const struct measure_columns *c)
+{
+	return deque_front_value(c, &c->max_deque);
+}
+
+void measure_tier_init(struct measure_tier *t, int step, int size)
 {
 	int i;
-	struct measure *result;
 
-	result = malloc(size * sizeof(struct measure));
+	t->step = step;
+	t->size = size;
+	t->head = 0;
+
+	t->mins = malloc(size * sizeof(measure_value_t));
+	t->avgs = malloc(size * sizeof(measure_value_t));
+	t->maxs = malloc(size * sizeof(measure_value_t));
+	t->times = calloc(size, sizeof(time_t));
+
+	for (i = 0; i < size; i++)
+		t->mins[i] = t->avgs[i] = t->maxs[i] = UNKNOWN_MEASURE_VALUE;
+
+	t->cur_time = 0;
+	t->cur_count = 0;
+}
+
+void measure_tier_free(struct measure_tier *t)
+{
+	free(t->mins);
+	free(t->avgs);
+	free(t->maxs);
+	free(t->times);
+
+	t->mins = t->avgs = t->maxs = NULL;
+	t->times = NULL;
+	t->size = 0;
+}
+
+/* Stores the rollup of the period being aggregated. */
+static void tier_flush(struct measure_tier *t)
+{
+	if (!t->cur_count)
+		return;
+
+	t->mins[t->head] = t->cur_min;
+	t->avgs[t->head] = t->cur_sum / t->cur_count;
+	t->maxs[t->head] = t->cur_max;
+	t->times[t->head] = t->cur_time;
+
+	t->head++;
+	if (t->head == t->size)
+		t->head = 0;
+
+	t->cur_count = 0;
+}
+
+void measure_tier_push(struct measure_tier *t,
+		       double value,
+		       struct timeval tv)
+{
+	time_t start;
 
-	for (i = 0; i < size; i++) {
-		result[i].value = UNKNOWN_DBL_VALUE;
-		timerclear(&result[i].time);
+	if (value == UNKNOWN_DBL_VALUE || !tv.tv_sec)
+		return;
+
+	start = tv.tv_sec - tv.tv_sec % t->step;
+
+	if (start != t->cur_time) {
+		tier_flush(t);
+		t->cur_time = start;
+	}
+
+	if (!t->cur_count) {
+		t->cur_min = t->cur_max = t->cur_sum = value;
+	} else {
+		if (value < t->cur_min)
+			t->cur_min = value;
+		if (value > t->cur_max)
+			t->cur_max = value;
+		t->cur_sum += value;
+	}
+
+	t->cur_count++;
+}
+
+int measure_tier_length(const struct measure_tier *t)
+{
+	return t->size + 1;
+}
+
+void measure_tier_get(const struct measure_tier *t,
+		      int i,
+		      struct measure_rollup *r)
+{
+	if (i == t->size) {
+		if (t->cur_count) {
+			r->min = t->cur_min;
+			r->avg = t->cur_sum / t->cur_count;
+			r->max = t->cur_max;
+			r->time.tv_sec = t->cur_time;
+		} else {
+			r->min = r->avg = r->max = UNKNOWN_DBL_VALUE;
+			r->time.tv_sec = 0;
+		}
+		r->time.tv_usec = 0;
+
+		return;
 	}
 
-	return result;
+	i += t->head;
+	if (i >= t->size)
+		i -= t->size;
+
+	r->min = from_column_value(t->mins[i]);
+	r->avg = from_column_value(t->avgs[i]);
+	r->max = from_column_value(t->maxs[i]);
+	r->time.tv_sec = t->times[i];
+	r->time.tv_usec = 0;
 }
 
-void measures_free(struct measure *measures)
+double measure_tier_get_min(const struct measure_tier *t)
 {
-	free(measures);
+	double m;
+
+	m = stats_min(t->mins, t->size);
+
+	if (t->cur_count && (m == UNKNOWN_DBL_VALUE || t->cur_min < m))
+		return t->cur_min;
+
+	return m;
 }
 
-void measure_copy(struct measure *src, struct measure *dst)
+double measure_tier_get_max(const struct measure_tier *t)
 {
-	memcpy(dst, src, sizeof(struct measure));
+	double m;
+
+	m = stats_max(t->maxs, t->size);
+
+	if (t->cur_count && (m == UNKNOWN_DBL_VALUE || t->cur_max > m))
+		return t->cur_max;
+
+	return m;
 }
@@ -23,6 +23,8 @@
 #include <float.h>
 #include <stdint.h>
 
+#include "config.h"
+
 #define UNKNOWN_DBL_VALUE DBL_MIN
 
 struct measure {
@@ -31,10 +33,181 @@ struct measure {
 	struct timeval time;
 };
 
-void measure_copy(struct measure *src, struct measure *dst);
+/* Returns the time of a measure in milliseconds since the Epoch. */
+static inline int64_t measure_get_time_ms(const struct measure *m)
+{
+	return (int64_t)m->time.tv_sec * 1000 + m->time.tv_usec / 1000;
+}
+
+/* Sets the time of a measure in milliseconds since the Epoch. */
+static inline void measure_set_time_ms(struct measure *m, int64_t ms)
+{
+	m->time.tv_sec = ms / 1000;
+	m->time.tv_usec = (ms % 1000) * 1000;
+}
+
+/*
+ * Type of the values stored in a measure history.  Histories use
+ * single precision floats when configured with
+ * --enable-float-measures.
+ */
+#ifdef ENABLE_FLOAT_MEASURES
+typedef float measure_value_t;
+#define UNKNOWN_MEASURE_VALUE FLT_MIN
+#else
+typedef double measure_value_t;
+#define UNKNOWN_MEASURE_VALUE DBL_MIN
+#endif
+
+/*
+ * Monotonic queue of the sequence numbers of the measures which
+ * may become the minimum (or maximum) of the history when older
+ * measures are overwritten.  Its capacity is the size of the
+ * history.
+ */
+struct measure_deque {
+	uint32_t *seqs;
+	int first;
+	int len;
+};
+
+/*
+ * Fixed size history of measures, used as a ring buffer.
+ *
+ * Values and timestamps are stored in two separate columns so that
+ * scanning the values does not load the timestamps.  A timestamp is
+ * stored as the number of milliseconds elapsed since 'epoch' plus
+ * one, 0 denotes an empty slot.
+ */
+struct measure_columns {
+	/* Number of slots */
+	int size;
+
+	/* Index of the oldest measure, overwritten by the next one */
+	int head;
+
+	measure_value_t *values;
+	uint32_t *times;
+
+	struct timeval epoch;
+
+	/*
+	 * Sequence number of the next measure.  The measures of the
+	 * history have the sequence numbers 'count - size' to
+	 * 'count - 1' (modulo 2^32).
+	 */
+	uint32_t count;
+
+	/* Known values of the history in increasing order */
+	struct measure_deque min_deque;
+	/* Known values of the history in decreasing order */
+	struct measure_deque max_deque;
+};
+
+void measure_columns_init(struct measure_columns *c, int size);
 
-struct measure *measures_dbl_create(int size);
+void measure_columns_free(struct measure_columns *c);
+
+/*
+ * Initializes 'c' with 'size' slots filled with the most recent
+ * measures of 'src'.
+ */
+void measure_columns_copy(struct measure_columns *c,
+			  const struct measure_columns *src,
+			  int size);
+
+/* Adds a measure, overwriting the oldest one. */
+void measure_columns_push(struct measure_columns *c,
+			  double value,
+			  struct timeval tv);
+
+/*
+ * Copies into 'm' the i-th measure, 0 being the oldest one and
+ * 'size - 1' the most recent one.  An empty slot is returned as
+ * UNKNOWN_DBL_VALUE with a cleared time.
+ */
+void measure_columns_get(const struct measure_columns *c,
+			 int i,
+			 struct measure *m);
 
-void measures_free(struct measure *measures);
+/*
+ * Returns the minimal (resp. maximal) known value of the history or
+ * UNKNOWN_DBL_VALUE if there is none.
+ *
+ * Computed in constant time, the queues are maintained by
+ * measure_columns_push().
+ */
+double measure_columns_get_min(const struct measure_columns *c);
+double measure_columns_get_max(const struct measure_columns *c);
+
+/* Minimum, average and maximum of the measures of a period. */
+struct measure_rollup {
+	double min;
+	double avg;
+	double max;
+
+	/* Start of the period */
+	struct timeval time;
+};
+
+/*
+ * Fixed size history of the rollups of consecutive periods of 'step'
+ * seconds, used as a ring buffer.  The period being aggregated is
+ * kept aside until a measure of a later period is pushed.
+ */
+struct measure_tier {
+	/* Duration of a period in seconds */
+	int step;
+
+	/* Number of slots */
+	int size;
+
+	/* Index of the oldest rollup, overwritten by the next one */
+	int head;
+
+	measure_value_t *mins;
+	measure_value_t *avgs;
+	measure_value_t *maxs;
+	/* Start of the periods, 0 for an empty slot */
+	time_t *times;
+
+	/* Period being aggregated */
+	time_t cur_time;
+	double cur_min;
+	double cur_max;
+	double cur_sum;
+	int cur_count;
+};
+
+void measure_tier_init(struct measure_tier *t, int step, int size);
+
+void measure_tier_free(struct measure_tier *t);
+
+/* Aggregates a measure, unknown values are ignored. */
+void measure_tier_push(struct measure_tier *t,
+		       double value,
+		       struct timeval tv);
+
+/*
+ * Number of rollups returned by measure_tier_get(): the slots and
+ * the period being aggregated.
+ */
+int measure_tier_length(const struct measure_tier *t);
+
+/*
+ * Copies into 'r' the i-th rollup, 0 being the oldest one and
+ * 'size' the period being aggregated.  An empty slot is returned
+ * with UNKNOWN_DBL_VALUE values and a cleared time.
+ */
+void measure_tier_get(const struct measure_tier *t,
+		      int i,
+		      struct measure_rollup *r);
+
+/*
+ * Returns the minimal (resp. maximal) value aggregated by the
+ * rollups or UNKNOWN_DBL_VALUE if there is none.
+ */
+double measure_tier_get_min(const struct measure_tier *t);
+double measure_tier_get_max(const struct measure_tier *t);
 
 #endif
@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <measure_archive.h>
+
+/*
+ * Upper bound of the encoded size of a block: a timestamp takes at
+ * most 36 bits and a value 77 bits.
+ */
+#define BLOCK_MAX_DATA ((MEASURE_BLOCK_SIZE * (36 + 77) + 7) / 8)
+
+/*
+ * Maximal difference between the timestamps of two consecutive
+ * measures of a block, so that their delta-of-delta fits in 32 bits.
+ */
+#define MAX_DELTA (1LL << 30)
+
+struct bit_writer {
+	uint8_t *data;
+	size_t bits;
+};
+
+struct bit_reader {
+	const uint8_t *data;
+	size_t size;
+	size_t bits;
+};
+
+/* Previous value and window of meaningful bits of the XOR encoding */
+struct xor_state {
+	uint64_t prev;
+	int lead;
+	int trail;
+	/* Number of meaningful bits, 0 if no window yet */
+	int len;
+};
+
+/* Writes the 'n' lowest bits of 'v', most significant first. */
+static void write_bits(struct bit_writer *w, uint64_t v, int n)
+{
+	int avail, k;
+
+	while (n > 0) {
+		avail = 8 - (w->bits & 7);
+		k = n < avail ? n : avail;
+
+		w->data[w->bits >> 3] |= ((v >> (n - k)) & ((1 << k) - 1))
+			<< (avail - k);
+
+		w->bits += k;
+		n -= k;
+	}
+}
+
+/* Reads 'n' bits, missing bits past the end of the data are 0. */
+static uint64_t read_bits(struct bit_reader *r, int n)
+{
+	uint64_t v;
+	int avail, k;
+
+	v = 0;
+	while (n > 0) {
+		avail = 8 - (r->bits & 7);
+		k = n < avail ? n : avail;
+
+		v <<= k;
+		if (r->bits < r->size * 8)
+			v |= (r->data[r->bits >> 3] >> (avail - k))
+				& ((1 << k) - 1);
+
+		r->bits += k;
+		n -= k;
+	}
+
+	return v;
+}
+
+static int64_t read_signed_bits(struct bit_reader *r, int n)
+{
+	int64_t v;
+
+	v = read_bits(r, n);
+	if (v & (1LL << (n - 1)))
+		v -= 1LL << n;
+
+	return v;
+}
+
+/*
+ * Encodes the delta-of-delta of the timestamps: '0' for 0, then
+ * '10', '110', '1110' and '1111' followed by 7, 9, 12 and 32 bits.
+ */
+static void write_dod(struct bit_writer *w, int64_t dod)
+{
+	if (!dod) {
+		write_bits(w, 0, 1);
+	} else if (dod >= -64 && dod < 64) {
+		write_bits(w, 0x2, 2);
+		write_bits(w, dod, 7);
+	} else if (dod >= -256 && dod < 256) {
+		write_bits(w, 0x6, 3);
+		write_bits(w, dod, 9);
+	} else if (dod >= -2048 && dod < 2048) {
+		write_bits(w, 0xe, 4);
+		write_bits(w, dod, 12);
+	} else {
+		write_bits(w, 0xf, 4);
+		write_bits(w, dod, 32);
+	}
+}
+
+static int64_t read_dod(struct bit_reader *r)
+{
+	if (!read_bits(r, 1))
+		return 0;
+	if (!read_bits(r, 1))
+		return read_signed_bits(r, 7);
+	if (!read_bits(r, 1))
+		return read_signed_bits(r, 9);
+	if (!read_bits(r, 1))
+		return read_signed_bits(r, 12);
+
+	return read_signed_bits(r, 32);
+}
+
+/*
+ * Encodes the XOR of the value with the previous one: '0' if equal,
+ * '10' followed by the meaningful bits if they fit in the window of
+ * the previous value, '11' followed by the number of leading zeros
+ * (5 bits), the number of meaningful bits minus one (6 bits) and the
+ * meaningful bits otherwise.
+ */
+static void write_value(struct bit_writer *w, struct xor_state *s, double v)
+{
+	uint64_t bits, x;
+	int lead, trail;
+
+	memcpy(&bits, &v, sizeof(bits));
+
+	x = bits ^ s->prev;
+	s->prev = bits;
+
+	if (!x) {
+		write_bits(w, 0, 1);
+		return;
+	}
+
+	lead = __builtin_clzll(x);
+	if (lead > 31)
+		lead = 31;
+	trail = __builtin_ctzll(x);
+
+	if (s->len && lead >= s->lead && trail >= s->trail) {
+		write_bits(w, 0x2, 2);
+	} else {
+		s->lead = lead;
+		s->trail = trail;
+		s->len = 64 - lead - trail;
+
+		write_bits(w, 0x3, 2);
+		write_bits(w, lead, 5);
+		write_bits(w, s->len - 1, 6);
+	}
+
+	write_bits(w, x >> s->trail, s->len);
+}
+
+static double read_value(struct bit_reader *r, struct xor_state *s)
+{
+	double v;
+
+	if (read_bits(r, 1)) {
+		if (read_bits(r, 1)) {
+			s->lead = read_bits(r, 5);
+			s->len = read_bits(r, 6) + 1;
+			s->trail = 64 - s->lead - s->len;
+
+			/* corrupted data */
+			if (s->trail < 0)
+				s->trail = 0;
+		}
+
+		s->prev ^= read_bits(r, s->len) << s->trail;
+	}
+
+	memcpy(&v, &s->prev, sizeof(v));
+
+	return v;
+}
+
+static int64_t timeval_to_ms(struct timeval tv)
+{
+	return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void measure_archive_init(struct measure_archive *a, int duration)
+{
+	a->duration = duration;
+	a->first = NULL;
+	a->last = NULL;
+	a->retired = NULL;
+	a->head_seq = 0;
+	a->head_count = 0;
+	a->count = 0;
+	a->size = 0;
+}
+
+static void free_blocks(struct measure_block *b, bool retired)
+{
+	struct measure_block *next;
+
+	while (b) {
+		if (retired)
+			next = b->retired_next;
+		else
+			next = b->next;
+
+		free(b);
+
+		b = next;
+	}
+}
+
+void measure_archive_free(struct measure_archive *a)
+{
+	free_blocks(a->first, false);
+	free_blocks(a->retired, true);
+
+	a->first = NULL;
+	a->last = NULL;
+	a->retired = NULL;
+}
+
+void measure_archive_release(struct measure_archive *a)
+{
+	free_blocks(a->retired, true);
+	a->retired = NULL;
+}
+
+/* Encodes the head block into a new sealed block. */
+static void seal_head(struct measure_archive *a)
+{
+	uint8_t data[BLOCK_MAX_DATA];
+	struct bit_writer w;
+	struct xor_state s;
+	struct measure_block *b;
+	int64_t delta, prev_delta;
+	size_t size;
+	int i;
+
+	memset(data, 0, sizeof(data));
+	memset(&s, 0, sizeof(s));
+	w.data = data;
+	w.bits = 0;
+
+	prev_delta = 0;
+	for (i = 0; i < a->head_count; i++) {
+		if (i)
+			delta = a->head_times[i] - a->head_times[i - 1];
+		else
+			delta = 0;
+
+		write_dod(&w, delta - prev_delta);
+		prev_delta = delta;
+
+		write_value(&w, &s, a->head_values[i]);
+	}
+
+	size = (w.bits + 7) / 8;
+
+	b = malloc(sizeof(*b) + size);
+	b->seq = a->head_seq;
+	b->count = a->head_count;
+	b->first_time = a->head_times[0];
+	b->last_time = a->head_times[a->head_count - 1];
+	b->next = NULL;
+	b->retired_next = NULL;
+	b->size = size;
+	memcpy(b->data, data, size);
+
+	if (a->last)
+		__atomic_store_n(&a->last->next, b, __ATOMIC_RELEASE);
+	else
+		__atomic_store_n(&a->first, b, __ATOMIC_RELEASE);
+	__atomic_store_n(&a->last, b, __ATOMIC_RELEASE);
+
+	a->count += b->count;
+	a->size += sizeof(*b) + size;
+
+	a->head_count = 0;
+	a->head_seq++;
+}
+
+/* Moves the oldest sealed block to the retired ones. */
+static void evict_first_block(struct measure_archive *a)
+{
+	struct measure_block *b;
+
+	b = a->first;
+
+	__atomic_store_n(&a->first, b->next, __ATOMIC_SEQ_CST);
+	if (!b->next)
+		__atomic_store_n(&a->last, NULL, __ATOMIC_RELEASE);
+
+	a->count -= b->count;
+	a->size -= sizeof(*b) + b->size;
+
+	b->retired_next = a->retired;
+	a->retired = b;
+}
+
+/* Moves the blocks older than the duration to the retired ones. */
+static void evict_blocks(struct measure_archive *a, int64_t now)
+{
+	while (a->first
+	       && now - a->first->last_time > (int64_t)a->duration * 1000)
+		evict_first_block(a);
+}
+
+void measure_archive_push(struct measure_archive *a,
+			  double value,
+			  struct timeval tv)
+{
+	int64_t t, delta;
+
+	t = timeval_to_ms(tv);
+
+	/* time jump, starts a new block */
+	if (a->head_count) {
+		delta = t - a->head_times[a->head_count - 1];
+		if (delta >= MAX_DELTA || delta <= -MAX_DELTA)
+			seal_head(a);
+	}
+
+	a->head_times[a->head_count] = t;
+	a->head_values[a->head_count] = value;
+	a->head_count++;
+
+	if (a->head_count == MEASURE_BLOCK_SIZE)
+		seal_head(a);
+
+	evict_blocks(a, t);
+}
+
+void measure_archive_clear(struct measure_archive *a)
+{
+	while (a->first)
+		evict_first_block(a);
+
+	/* the cursors on the head block must not see the next one */
+	a->head_count = 0;
+	a->head_seq++;
+}
+
+int measure_archive_length(const struct measure_archive *a)
+{
+	return a->count + a->head_count;
+}
+
+size_t measure_archive_size(const struct measure_archive *a)
+{
+	return sizeof(*a) + a->size;
+}
+
+static bool load_block(const struct measure_block *b,
+		       struct measure_archive_cursor *cur)
+{
+	struct bit_reader r;
+	struct xor_state s;
+	int64_t t, delta;
+	int i, n;
+
+	r.data = b->data;
+	r.size = b->size;
+	r.bits = 0;
+	memset(&s, 0, sizeof(s));
+
+	n = b->count;
+	if (n > MEASURE_BLOCK_SIZE)
+		n = MEASURE_BLOCK_SIZE;
+
+	t = b->first_time;
+	delta = 0;
+	for (i = 0; i < n; i++) {
+		delta += read_dod(&r);
+		t += delta;
+
+		cur->times[i] = t;
+		cur->values[i] = read_value(&r, &s);
+	}
+
+	cur->seq = b->seq;
+	cur->block = b;
+	cur->count = n;
+
+	return true;
+}
+
+static bool load_head(const struct measure_archive *a,
+		      struct measure_archive_cursor *cur)
+{
+	int n;
+
+	n = a->head_count;
+	if (n < 0 || n > MEASURE_BLOCK_SIZE)
+		n = 0;
+
+	memcpy(cur->times, a->head_times, n * sizeof(int64_t));
+	memcpy(cur->values, a->head_values, n * sizeof(double));
+
+	cur->seq = a->head_seq;
+	cur->block = NULL;
+	cur->count = n;
+
+	return n > 0;
+}
+
+bool measure_archive_first(const struct measure_archive *a,
+			   struct measure_archive_cursor *cur)
+{
+	const struct measure_block *b;
+
+	b = __atomic_load_n(&a->first, __ATOMIC_SEQ_CST);
+	if (b)
+		return load_block(b, cur);
+
+	return load_head(a, cur);
+}
+
+bool measure_archive_last(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur)
+{
+	const struct measure_block *b;
+
+	if (a->head_count)
+		return load_head(a, cur);
+
+	b = __atomic_load_n(&a->last, __ATOMIC_ACQUIRE);
+	if (b)
+		return load_block(b, cur);
+
+	return false;
+}
+
+bool measure_archive_next(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur)
+{
+	const struct measure_block *b;
+
+	/* the head block is the newest one */
+	if (!cur->block)
+		return false;
+
+	/* the block of the cursor has been evicted */
+	b = __atomic_load_n(&a->first, __ATOMIC_SEQ_CST);
+	if (!b || (int32_t)(b->seq - cur->seq) > 0)
+		return measure_archive_first(a, cur);
+
+	b = __atomic_load_n(&cur->block->next, __ATOMIC_ACQUIRE);
+	if (b)
+		return load_block(b, cur);
+
+	if (a->head_seq == cur->seq + 1)
+		return load_head(a, cur);
+
+	return false;
+}
+
+bool measure_archive_prev(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur)
+{
+	const struct measure_block *b;
+	uint32_t seq;
+
+	seq = cur->seq - 1;
+
+	b = __atomic_load_n(&a->last, __ATOMIC_ACQUIRE);
+	if (b && b->seq == seq)
+		return load_block(b, cur);
+
+	b = __atomic_load_n(&a->first, __ATOMIC_ACQUIRE);
+	while (b && (int32_t)(seq - b->seq) > 0)
+		b = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
+
+	if (b && b->seq == seq)
+		return load_block(b, cur);
+
+	return false;
+}
+
+int measure_archive_seek(const struct measure_archive *a,
+			 int i,
+			 struct measure_archive_cursor *cur)
+{
+	const struct measure_block *b;
+
+	if (i < 0)
+		return -1;
+
+	b = __atomic_load_n(&a->first, __ATOMIC_ACQUIRE);
+	while (b) {
+		if (i < b->count) {
+			load_block(b, cur);
+			return i < cur->count ? i : -1;
+		}
+
+		i -= b->count;
+		b = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
+	}
+
+	if (load_head(a, cur) && i < cur->count)
+		return i;
+
+	return -1;
+}
+
+void measure_archive_cursor_get(const struct measure_archive_cursor *cur,
+				int i,
+				struct measure *m)
+{
+	m->value = cur->values[i];
+	m->time.tv_sec = cur->times[i] / 1000;
+	m->time.tv_usec = (cur->times[i] % 1000) * 1000;
+}
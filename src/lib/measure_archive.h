@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_MEASURE_ARCHIVE_H_
+#define _PSENSOR_MEASURE_ARCHIVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <bool.h>
+#include <measure.h>
+
+/*
+ * Compressed full resolution history of the measures of the last
+ * 'duration' seconds.
+ *
+ * The measures are appended to an uncompressed head block.  Once
+ * full, the head block is sealed: its timestamps are encoded as
+ * delta-of-delta and its values XORed with the previous ones, as
+ * done by the Gorilla time series database.  Slowly changing values
+ * at a regular period take a couple of bytes per measure.
+ *
+ * A single thread appends the measures, the other threads read them
+ * through a measure_archive_cursor while the owner of the archive
+ * ensures that the sealed blocks are not freed meanwhile, see
+ * measure_archive_release().  The oldest block is unlinked with a
+ * sequentially consistent store, so that the owner can rely on a
+ * readers counter incremented before loading a cursor.
+ */
+
+/* Number of measures of a block */
+#define MEASURE_BLOCK_SIZE 128
+
+/* Sealed block, immutable once published. */
+struct measure_block {
+	/* Sequence number of the block in the archive */
+	uint32_t seq;
+
+	/* Number of measures */
+	int count;
+
+	/* Time of the first and last measures, in ms since the Epoch */
+	int64_t first_time;
+	int64_t last_time;
+
+	/* Next newer block, NULL for the newest one */
+	struct measure_block *next;
+
+	/* Next evicted block waiting to be freed */
+	struct measure_block *retired_next;
+
+	/* Size of 'data' in bytes */
+	size_t size;
+
+	/* Encoded measures */
+	uint8_t data[];
+};
+
+struct measure_archive {
+	/* Duration in seconds of the history kept */
+	int duration;
+
+	/* Oldest and newest sealed blocks, NULL if none */
+	struct measure_block *first;
+	struct measure_block *last;
+
+	/* Evicted blocks which may still be read by a cursor */
+	struct measure_block *retired;
+
+	/* Sequence number of the head block */
+	uint32_t head_seq;
+
+	/* Uncompressed measures of the head block */
+	int head_count;
+	int64_t head_times[MEASURE_BLOCK_SIZE];
+	double head_values[MEASURE_BLOCK_SIZE];
+
+	/* Number of measures and bytes of the sealed blocks */
+	int count;
+	size_t size;
+};
+
+/* Decoded copy of a block of an archive. */
+struct measure_archive_cursor {
+	/* Sequence number of the block */
+	uint32_t seq;
+
+	/* Sealed block, NULL for the head block */
+	const struct measure_block *block;
+
+	int count;
+	int64_t times[MEASURE_BLOCK_SIZE];
+	double values[MEASURE_BLOCK_SIZE];
+};
+
+void measure_archive_init(struct measure_archive *a, int duration);
+
+void measure_archive_free(struct measure_archive *a);
+
+/* Appends a measure, evicting the blocks older than the duration. */
+void measure_archive_push(struct measure_archive *a,
+			  double value,
+			  struct timeval tv);
+
+/*
+ * Frees the evicted blocks.  Must only be called when no cursor is
+ * being loaded.
+ */
+void measure_archive_release(struct measure_archive *a);
+
+/*
+ * Removes all the measures, the sealed blocks are evicted and freed
+ * by measure_archive_release().
+ */
+void measure_archive_clear(struct measure_archive *a);
+
+/* Number of measures of the archive. */
+int measure_archive_length(const struct measure_archive *a);
+
+/* Memory used by the archive in bytes. */
+size_t measure_archive_size(const struct measure_archive *a);
+
+/*
+ * The following functions decode a block of 'a' into 'cur' and
+ * return false if there is no such block.  The block of 'cur' may
+ * have been evicted since it has been loaded, the oldest block is
+ * then loaded instead by measure_archive_next().
+ *
+ * Their result must be discarded if 'a' has been modified while
+ * they were running, the evicted blocks must not be freed meanwhile.
+ */
+
+/* Loads the oldest (resp. newest) block. */
+bool measure_archive_first(const struct measure_archive *a,
+			   struct measure_archive_cursor *cur);
+bool measure_archive_last(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur);
+
+/* Loads the block following (resp. preceding) the one of 'cur'. */
+bool measure_archive_next(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur);
+bool measure_archive_prev(const struct measure_archive *a,
+			  struct measure_archive_cursor *cur);
+
+/*
+ * Loads the block containing the i-th measure, 0 being the oldest
+ * one, and returns the position of the measure in the block or -1.
+ * Walks through the blocks, a cursor should be preferred for reading
+ * consecutive measures.
+ */
+int measure_archive_seek(const struct measure_archive *a,
+			 int i,
+			 struct measure_archive_cursor *cur);
+
+/* Copies into 'm' the measure at position 'i' of 'cur'. */
+void measure_archive_cursor_get(const struct measure_archive_cursor *cur,
+				int i,
+				struct measure *m);
+
+#endif
@@ -227,11 +227,13 @@ static double get_value(int id, int type)
 	}
 }
 
-static void update(struct psensor *sensor)
+static void update(struct psensor_batch *b, int i)
 {
+	struct psensor *sensor;
 	double v;
 	int id;
 
+	sensor = b->sensors[i];
 	id = get_nvidia_id(sensor);
 
 	v = get_value(id, sensor->type);
@@ -242,7 +244,7 @@ static void update(struct psensor *sensor)
 			PROVIDER_NAME,
 			sensor->type,
 			id);
-	psensor_set_current_value(sensor, v);
+	psensor_batch_set(b, i, v);
 }
 
 static int check_sensor(int id, int type)
@@ -330,30 +332,28 @@ static int init(void)
 
 void nvidia_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor *s;
+	struct psensor_batch b;
+	int i;
 
-	while (*sensors) {
-		s = *sensors;
+	psensor_batch_begin(&b, sensors);
 
-		if (!(s->type & SENSOR_TYPE_REMOTE)
-		    && s->type & SENSOR_TYPE_NVCTRL)
-			update(s);
+	for (i = 0; sensors[i]; i++)
+		update(&b, i);
 
-		sensors++;
-	}
+	psensor_batch_commit(&b);
 }
 
-static void add(struct psensor ***sensors, int id, int type, int values_len)
+static void add(struct psensor_registry *r, int id, int type, int values_len)
 {
 	struct psensor *s;
 
 	s = create_nvidia_sensor(id, type, values_len);
 
 	if (s)
-		psensor_list_append(sensors, s);
+		psensor_registry_add(r, s);
 }
 
-void nvidia_psensor_list_append(struct psensor ***ss, int values_len)
+void nvidia_psensor_list_append(struct psensor_registry *r, int values_len)
 {
 	int i, n, utype;
 	Bool ret;
@@ -364,17 +364,17 @@ void nvidia_psensor_list_append(struct psensor ***ss, int values_len)
 	ret = XNVCTRLQueryTargetCount(display, NV_CTRL_TARGET_TYPE_GPU, &n);
 	if (ret == True) {
 		for (i = 0; i < n; i++) {
-			add(ss,
+			add(r,
 			    i,
 			    SENSOR_TYPE_GPU | SENSOR_TYPE_TEMP,
 			    values_len);
 
 			utype = SENSOR_TYPE_GPU | SENSOR_TYPE_PERCENT;
-			add(ss, i, utype | SENSOR_TYPE_AMBIENT, values_len);
-			add(ss, i, utype | SENSOR_TYPE_GRAPHICS, values_len);
-			add(ss, i, utype | SENSOR_TYPE_VIDEO, values_len);
-			add(ss, i, utype | SENSOR_TYPE_MEMORY, values_len);
-			add(ss, i, utype | SENSOR_TYPE_PCIE, values_len);
+			add(r, i, utype | SENSOR_TYPE_AMBIENT, values_len);
+			add(r, i, utype | SENSOR_TYPE_GRAPHICS, values_len);
+			add(r, i, utype | SENSOR_TYPE_VIDEO, values_len);
+			add(r, i, utype | SENSOR_TYPE_MEMORY, values_len);
+			add(r, i, utype | SENSOR_TYPE_PCIE, values_len);
 		}
 	}
 
@@ -384,11 +384,11 @@ void nvidia_psensor_list_append(struct psensor ***ss, int values_len)
 		for (i = 0; i < n; i++) {
 			utype = SENSOR_TYPE_FAN | SENSOR_TYPE_RPM;
 			if (check_sensor(i, utype))
-				add(ss, i, utype, values_len);
+				add(r, i, utype, values_len);
 
 			utype = SENSOR_TYPE_FAN | SENSOR_TYPE_PERCENT;
 			if (check_sensor(i, utype))
-				add(ss, i, utype, values_len);
+				add(r, i, utype, values_len);
 		}
 	} else {
 		log_err(_("%s: Failed to retrieve number of fans."),
@@ -20,6 +20,7 @@
 #define _PSENSOR_NVIDIA_H_
 
 #include <bool.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 
@@ -28,7 +29,7 @@
 static inline bool nvidia_is_supported(void) { return true; }
 
 void nvidia_psensor_list_update(struct psensor **);
-void nvidia_psensor_list_append(struct psensor ***, int);
+void nvidia_psensor_list_append(struct psensor_registry *, int);
 void nvidia_cleanup(void);
 
 #else
@@ -36,7 +37,8 @@ void nvidia_cleanup(void);
 static inline bool nvidia_is_supported(void) { return false; }
 
 static inline void nvidia_psensor_list_update(struct psensor **s) {}
-static inline void nvidia_psensor_list_append(struct psensor ***s, int n) {}
+static inline void
+nvidia_psensor_list_append(struct psensor_registry *r, int n) {}
 static inline void nvidia_cleanup(void) {}
 
 #endif
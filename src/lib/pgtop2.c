@@ -28,17 +28,19 @@
 
 #include <pgtop2.h>
 #include <plog.h>
+#include <stats.h>
 #include <sys/time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static float last_used;
-static float last_total;
+/* Counters of the previous update, 64 bits like the ones of glibtop */
+static guint64 last_used;
+static guint64 last_total;
 
 /* CPU spike detection: track average and only log spikes */
 #define CPU_AVG_SAMPLES 60  /* Track last 60 samples for average */
-static double cpu_samples[CPU_AVG_SAMPLES];
+static measure_value_t cpu_samples[CPU_AVG_SAMPLES];
 static int cpu_sample_idx = 0;
 static int cpu_samples_count = 0;
 static double cpu_avg = 0.0;
@@ -83,7 +85,7 @@ static struct psensor *create_mem_free_sensor(int measures_len)
 static double get_usage(void)
 {
 	glibtop_cpu cpu;
-	unsigned long int used, dt;
+	guint64 used, dt;
 	double cpu_rate;
 
 	glibtop_get_cpu(&cpu);
@@ -92,7 +94,7 @@ static double get_usage(void)
 
 	dt = cpu.total - last_total;
 
-	if (dt)
+	if (cpu.total > last_total && used >= last_used)
 		cpu_rate = 100.0 * (used - last_used) / dt;
 	else
 		cpu_rate = UNKNOWN_DBL_VALUE;
@@ -114,10 +116,10 @@ static double get_mem_free(void)
 	return v;
 }
 
-void gtop2_psensor_list_append(struct psensor ***sensors, int measures_len)
+void gtop2_psensor_list_append(struct psensor_registry *r, int measures_len)
 {
-	psensor_list_append(sensors, create_cpu_usage_sensor(measures_len));
-	psensor_list_append(sensors, create_mem_free_sensor(measures_len));
+	psensor_registry_add(r, create_cpu_usage_sensor(measures_len));
+	psensor_registry_add(r, create_mem_free_sensor(measures_len));
 }
 
 /* Structure to hold process CPU info */
@@ -145,7 +147,7 @@ static struct {
 	unsigned long utime;
 	unsigned long stime;
 	char comm[32];
-	double cpu_samples[PROC_AVG_SAMPLES];
+	measure_value_t cpu_samples[PROC_AVG_SAMPLES];
 	int cpu_sample_idx;
 	int cpu_samples_count;
 	double cpu_avg;
@@ -331,12 +333,9 @@ static void log_top_cpu_processes_sync(int during_spike)
 									proc_times[proc_idx].cpu_samples_count++;
 
 								/* Calculate per-process average */
-								double sum = 0.0;
-								for (int j = 0; j < proc_times[proc_idx].cpu_samples_count; j++) {
-									sum += proc_times[proc_idx].cpu_samples[j];
-								}
 								proc_times[proc_idx].cpu_avg =
-									sum / proc_times[proc_idx].cpu_samples_count;
+									stats_mean(proc_times[proc_idx].cpu_samples,
+										   proc_times[proc_idx].cpu_samples_count);
 
 								/* Check if process should be shown */
 								int should_show = 0;
@@ -402,7 +401,8 @@ static void log_top_cpu_processes_sync(int during_spike)
 	if (procs) free(procs);
 }
 
-void cpu_usage_sensor_update(struct psensor *s)
+/* Returns the CPU usage and tracks the processes during the spikes. */
+static double update_cpu_usage(void)
 {
 	double v;
 	static int update_count = 0;
@@ -410,8 +410,6 @@ void cpu_usage_sensor_update(struct psensor *s)
 	v = get_usage();
 
 	if (v != UNKNOWN_DBL_VALUE) {
-		psensor_set_current_value(s, v);
-
 		/* Update running average */
 		cpu_samples[cpu_sample_idx] = v;
 		cpu_sample_idx = (cpu_sample_idx + 1) % CPU_AVG_SAMPLES;
@@ -419,11 +417,7 @@ void cpu_usage_sensor_update(struct psensor *s)
 			cpu_samples_count++;
 
 		/* Calculate average */
-		double sum = 0.0;
-		for (int i = 0; i < cpu_samples_count; i++) {
-			sum += cpu_samples[i];
-		}
-		cpu_avg = sum / cpu_samples_count;
+		cpu_avg = stats_mean(cpu_samples, cpu_samples_count);
 
 		/* Update process tracking every 10 samples to keep data fresh */
 		/* This ensures we have recent data when a spike occurs */
@@ -439,13 +433,15 @@ void cpu_usage_sensor_update(struct psensor *s)
 			log_top_cpu_processes_sync(1);  /* During spike: also show new processes */
 		}
 	}
+
+	return v;
 }
 
-static void mem_free_sensor_update(struct psensor *s)
+void cpu_usage_sensor_update(struct psensor *s)
 {
 	double v;
 
-	v = get_mem_free();
+	v = update_cpu_usage();
 
 	if (v != UNKNOWN_DBL_VALUE)
 		psensor_set_current_value(s, v);
@@ -453,19 +449,26 @@ static void mem_free_sensor_update(struct psensor *s)
 
 void gtop2_psensor_list_update(struct psensor **sensors)
 {
+	struct psensor_batch b;
 	struct psensor *s;
+	double v;
+	int i;
 
-	while (*sensors) {
-		s = *sensors;
+	psensor_batch_begin(&b, sensors);
 
-		if (!(s->type & SENSOR_TYPE_REMOTE)
-			&& s->type & SENSOR_TYPE_GTOP) {
-			if (s->type & SENSOR_TYPE_CPU)
-				cpu_usage_sensor_update(s);
-			else if (s->type & SENSOR_TYPE_MEMORY)
-				mem_free_sensor_update(s);
-		}
+	for (i = 0; sensors[i]; i++) {
+		s = sensors[i];
+
+		if (s->type & SENSOR_TYPE_CPU)
+			v = update_cpu_usage();
+		else if (s->type & SENSOR_TYPE_MEMORY)
+			v = get_mem_free();
+		else
+			v = UNKNOWN_DBL_VALUE;
 
-		sensors++;
+		if (v != UNKNOWN_DBL_VALUE)
+			psensor_batch_set(&b, i, v);
 	}
+
+	psensor_batch_commit(&b);
 }
@@ -20,6 +20,7 @@
 #define _PSENSOR_PGTOP2_H_
 
 #include <bool.h>
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_GTOP) && HAVE_GTOP
@@ -30,7 +31,7 @@ struct psensor *create_cpu_usage_sensor(int);
 void cpu_usage_sensor_update(struct psensor *);
 
 void gtop2_psensor_list_update(struct psensor **);
-void gtop2_psensor_list_append(struct psensor ***, int);
+void gtop2_psensor_list_append(struct psensor_registry *, int);
 
 #else
 
@@ -40,7 +41,8 @@ static inline struct psensor *create_cpu_usage_sensor(int n) { return NULL; }
 static inline void cpu_usage_sensor_update(struct psensor *s) {}
 
 static inline void gtop2_psensor_list_update(struct psensor **s) {}
-static inline void gtop2_psensor_list_append(struct psensor ***s, int n) {}
+static inline void
+gtop2_psensor_list_append(struct psensor_registry *r, int n) {}
 
 #endif
 
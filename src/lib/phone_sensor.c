@@ -165,7 +165,7 @@ static struct psensor *create_phone_temp_sensor(int values_max_length)
 	if (phone_sensor_available() == 0)
 		return NULL;
 
-	t = SENSOR_TYPE_TEMP;
+	t = SENSOR_TYPE_TEMP | SENSOR_TYPE_PHONE;
 	id = strdup("phone-sensor-temperature");
 	name = strdup(_("Phone Temperature"));
 
@@ -191,7 +191,7 @@ static struct psensor *create_phone_battery_sensor(int values_max_length)
 		return NULL;
 	fclose(f);
 
-	t = SENSOR_TYPE_PERCENT;
+	t = SENSOR_TYPE_PERCENT | SENSOR_TYPE_PHONE;
 	id = strdup("phone-sensor-battery-level");
 	name = strdup(_("Phone Battery Level"));
 
@@ -199,46 +199,50 @@ static struct psensor *create_phone_battery_sensor(int values_max_length)
 	return phone_battery_sensor;
 }
 
-void phone_sensor_psensor_list_append(struct psensor ***sensors, int values_length)
+void phone_sensor_psensor_list_append(struct psensor_registry *r, int values_length)
 {
 	struct psensor *s;
 
 	/* Try to create phone temperature sensor */
 	s = create_phone_temp_sensor(values_length);
 	if (s) {
-		psensor_list_append(sensors, s);
+		psensor_registry_add(r, s);
 	}
 
 	/* Try to create phone battery level sensor */
 	s = create_phone_battery_sensor(values_length);
 	if (s) {
-		psensor_list_append(sensors, s);
+		psensor_registry_add(r, s);
 	}
 }
 
 void phone_sensor_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor **sensor_cur;
-	double temp, battery;
+	struct psensor_batch b;
+	const char *id;
+	double v;
+	int i;
 
 	if (!sensors)
 		return;
 
+	psensor_batch_begin(&b, sensors);
+
 	/* Update phone sensors in list */
-	sensor_cur = sensors;
-	while (*sensor_cur) {
-		if (strcmp((*sensor_cur)->id, "phone-sensor-temperature") == 0) {
-			temp = read_phone_temperature();
-			if (temp != UNKNOWN_DBL_VALUE) {
-				psensor_set_current_value(*sensor_cur, temp);
-			}
-		} else if (strcmp((*sensor_cur)->id, "phone-sensor-battery-level") == 0) {
-			battery = read_phone_battery();
-			if (battery != UNKNOWN_DBL_VALUE) {
-				psensor_set_current_value(*sensor_cur, battery);
-			}
-		}
-		sensor_cur++;
+	for (i = 0; sensors[i]; i++) {
+		id = sensors[i]->id;
+
+		if (!strcmp(id, "phone-sensor-temperature"))
+			v = read_phone_temperature();
+		else if (!strcmp(id, "phone-sensor-battery-level"))
+			v = read_phone_battery();
+		else
+			v = UNKNOWN_DBL_VALUE;
+
+		if (v != UNKNOWN_DBL_VALUE)
+			psensor_batch_set(&b, i, v);
 	}
+
+	psensor_batch_commit(&b);
 }
 
@@ -13,9 +13,11 @@
 #define _PSENSOR_PHONE_SENSOR_H_
 
 #include <bool.h>
+#include <pregistry.h>
 #include <psensor.h>
 
-void phone_sensor_psensor_list_append(struct psensor ***sensors, int values_length);
+void phone_sensor_psensor_list_append(struct psensor_registry *r,
+				      int values_length);
 void phone_sensor_psensor_list_update(struct psensor **sensors);
 
 #endif
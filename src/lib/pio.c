@@ -19,12 +19,19 @@
 #define _LARGEFILE_SOURCE 1
 #include "config.h"
 
+#include <locale.h>
+#include <libintl.h>
+#define _(str) gettext(str)
+
 #include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <plog.h>
 #include <pio.h>
@@ -342,3 +349,111 @@ file_copy_print_error(int code, const char *src, const char *dst)
 		printf("File copy error: unknown error %d.\n", code);
 	}
 }
+
+bool sysfs_read(const char *dir, const char *name, char *buf, size_t size)
+{
+	char path[PATH_MAX];
+	ssize_t n;
+	int fd;
+
+	if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= PATH_MAX)
+		return false;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	n = read(fd, buf, size - 1);
+	close(fd);
+
+	if (n <= 0)
+		return false;
+
+	if (buf[n - 1] == '\n')
+		n--;
+	buf[n] = '\0';
+
+	return true;
+}
+
+/* Parses the digits of 'buf', which cannot exceed 'max'. */
+static bool
+parse_digits(const char *buf, size_t n, uint64_t max, uint64_t *v)
+{
+	const char *p, *end;
+	unsigned int d;
+	uint64_t r;
+
+	end = buf + n;
+	if (n && end[-1] == '\n')
+		end--;
+
+	if (buf == end)
+		return false;
+
+	r = 0;
+	for (p = buf; p < end; p++) {
+		if (*p < '0' || *p > '9')
+			return false;
+
+		d = *p - '0';
+		if (r > (max - d) / 10)
+			return false;
+
+		r = r * 10 + d;
+	}
+
+	*v = r;
+
+	return true;
+}
+
+bool sysfs_parse_long(const char *buf, size_t n, long *v)
+{
+	uint64_t r;
+
+	if (n && *buf == '-') {
+		if (!parse_digits(buf + 1, n - 1, LONG_MAX, &r))
+			return false;
+
+		*v = -(long)r;
+	} else {
+		if (!parse_digits(buf, n, LONG_MAX, &r))
+			return false;
+
+		*v = r;
+	}
+
+	return true;
+}
+
+bool sysfs_parse_u64(const char *buf, size_t n, uint64_t *v)
+{
+	return parse_digits(buf, n, UINT64_MAX, v);
+}
+
+bool sysfs_read_long(const char *dir, const char *name, long *v)
+{
+	char buf[32];
+
+	return sysfs_read(dir, name, buf, sizeof(buf))
+		&& sysfs_parse_long(buf, strlen(buf), v);
+}
+
+bool sysfs_read_u64(const char *dir, const char *name, uint64_t *v)
+{
+	char buf[32];
+
+	return sysfs_read(dir, name, buf, sizeof(buf))
+		&& sysfs_parse_u64(buf, strlen(buf), v);
+}
+
+bool log_read(bool *failed, bool ok, const char *provider, const char *src)
+{
+	if (!ok && !*failed)
+		log_err(_("%s: Cannot read %s."), provider, src);
+
+	*failed = !ok;
+
+	return ok;
+}
@@ -20,7 +20,12 @@
 #ifndef _P_IO_H
 #define _P_IO_H
 
-#define P_IO_VER 6
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <bool.h>
+
+#define P_IO_VER 7
 
 /* Returns '1' if a given 'path' denotates a directory else returns
  * 0
@@ -76,4 +81,37 @@ int dir_rcopy(const char *, const char *);
 
 void mkdirs(const char *dirs, mode_t mode);
 
+/*
+ * Copies into 'buf' the content of the file 'name' of the directory
+ * 'dir', without the trailing newline: a sysfs attribute such as
+ * 'hwmon0/temp1_label'.
+ *
+ * Returns false if the file cannot be read or is empty.
+ */
+bool sysfs_read(const char *dir, const char *name, char *buf, size_t size);
+
+/*
+ * Parses the 'n' bytes of 'buf', which is not NUL terminated: a
+ * decimal integer with an optional trailing newline.
+ *
+ * Returns false if 'buf' is not such an integer or if it overflows.
+ */
+bool sysfs_parse_long(const char *buf, size_t n, long *v);
+bool sysfs_parse_u64(const char *buf, size_t n, uint64_t *v);
+
+/* Reads and parses the integer of the file 'name' of 'dir'. */
+bool sysfs_read_long(const char *dir, const char *name, long *v);
+bool sysfs_read_u64(const char *dir, const char *name, uint64_t *v);
+
+/*
+ * Logs the result of a read of 'src' by 'provider', a file which is
+ * read at each update.  A failure is logged only if the previous
+ * read succeeded: '*failed' holds whether it failed, false for the
+ * first read.  The reads of a source must not be concurrent, which
+ * holds for the updates of a provider.
+ *
+ * Returns 'ok'.
+ */
+bool log_read(bool *failed, bool ok, const char *provider, const char *src);
+
 #endif
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <locale.h>
+#include <libintl.h>
+#define _(str) gettext(str)
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pio.h>
+#include <powercap.h>
+#include <preader.h>
+#include <ptime.h>
+
+static const char *PROVIDER_NAME = "powercap";
+
+/* Reads of the counters of an update */
+static struct preader reader;
+
+struct powercap_data {
+	/* 'energy_uj' file, kept open */
+	int fd;
+
+	/* Content of the counter file read by the last update */
+	char buf[32];
+
+	/* Value of 'max_energy_range_uj', 0 if unknown */
+	uint64_t range;
+
+	/* Counter and monotonic time in us of the previous update */
+	uint64_t energy;
+	int64_t time;
+
+	/* See log_read() */
+	bool failed;
+};
+
+double powercap_get_power(uint64_t last,
+			  uint64_t cur,
+			  uint64_t range,
+			  int64_t us)
+{
+	uint64_t uj;
+
+	if (us <= 0)
+		return UNKNOWN_DBL_VALUE;
+
+	if (cur >= last)
+		uj = cur - last;
+	else if (range && last <= range)
+		uj = range - last + cur;
+	else
+		return UNKNOWN_DBL_VALUE;
+
+	/* microjoules per microsecond */
+	return (double)uj / us;
+}
+
+static void powercap_data_free(void *data)
+{
+	close(((struct powercap_data *)data)->fd);
+	free(data);
+}
+
+/*
+ * Returns the label of a zone: its name, prefixed by the name of its
+ * parent for the subzones, 'intel-rapl:0:1' is 'package-0 uncore'.
+ */
+static void get_label(const char *root,
+		      const char *zone,
+		      const char *name,
+		      char *label,
+		      size_t size)
+{
+	char dir[PATH_MAX], parent[64];
+	const char *sep;
+
+	sep = strrchr(zone, ':');
+
+	if (sep && strchr(zone, ':') != sep) {
+		snprintf(dir,
+			 sizeof(dir),
+			 "%s/%.*s",
+			 root,
+			 (int)(sep - zone),
+			 zone);
+
+		if (sysfs_read(dir, "name", parent, sizeof(parent))) {
+			snprintf(label, size, "%s %s", parent, name);
+			return;
+		}
+	}
+
+	snprintf(label, size, "%s", name);
+}
+
+/*
+ * Creates the sensor of the zone 'zone'.
+ *
+ * Returns NULL if the zone has no energy counter or if it cannot be
+ * read.
+ */
+static struct psensor *create_sensor(const char *root,
+				     const char *zone,
+				     int values_max_length)
+{
+	char dir[PATH_MAX], path[PATH_MAX], name[64], label[128];
+	char *id;
+	int fd;
+	uint64_t v;
+	struct powercap_data *data;
+	struct psensor *s;
+
+	if (snprintf(dir, sizeof(dir), "%s/%s", root, zone) >= PATH_MAX)
+		return NULL;
+
+	if (snprintf(path, sizeof(path), "%s/energy_uj", dir) >= PATH_MAX)
+		return NULL;
+
+	/* the control types, 'intel-rapl'... have no counter */
+	if (access(path, F_OK))
+		return NULL;
+
+	/* the counters are readable only by root on most systems */
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		log_debug("%s: Cannot open %s.", PROVIDER_NAME, path);
+		return NULL;
+	}
+
+	if (!sysfs_read(dir, "name", name, sizeof(name)))
+		snprintf(name, sizeof(name), "%s", zone);
+
+	get_label(root, zone, name, label, sizeof(label));
+
+	id = malloc(strlen(PROVIDER_NAME)
+		    + 1
+		    + strlen(zone)
+		    + 1
+		    + strlen(label)
+		    + 1);
+	sprintf(id, "%s %s %s", PROVIDER_NAME, zone, label);
+
+	s = psensor_create(id,
+			   strdup(label),
+			   strdup(_("RAPL")),
+			   SENSOR_TYPE_POWERCAP | SENSOR_TYPE_POWER,
+			   values_max_length);
+
+	/* long term power limit */
+	if (sysfs_read_u64(dir, "constraint_0_max_power_uw", &v) && v)
+		s->max = v / 1000000.0;
+
+	data = malloc(sizeof(struct powercap_data));
+	data->fd = fd;
+	data->time = 0;
+	data->failed = false;
+
+	if (!sysfs_read_u64(dir, "max_energy_range_uj", &data->range))
+		data->range = 0;
+
+	s->provider_data = data;
+	s->provider_data_free_fct = powercap_data_free;
+
+	return s;
+}
+
+static int is_zone(const struct dirent *e)
+{
+	return e->d_name[0] != '.';
+}
+
+void powercap_psensor_list_append(struct psensor_registry *r,
+				  const char *root,
+				  int values_max_length)
+{
+	struct dirent **zones;
+	struct psensor *s;
+	int i, n;
+
+	n = scandir(root, &zones, is_zone, alphasort);
+	if (n == -1) {
+		log_debug("%s: Cannot list %s.", PROVIDER_NAME, root);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		s = create_sensor(root, zones[i]->d_name, values_max_length);
+
+		if (s)
+			psensor_registry_add(r, s);
+
+		free(zones[i]);
+	}
+
+	free(zones);
+}
+
+void powercap_psensor_list_update(struct psensor **sensors)
+{
+	struct psensor_batch b;
+	struct powercap_data *data;
+	ssize_t n;
+	bool ok;
+	uint64_t energy;
+	int64_t now;
+	double w;
+	int i;
+
+	if (!sensors)
+		return;
+
+	preader_clear(&reader);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		preader_add(&reader, data->fd, data->buf, sizeof(data->buf));
+	}
+
+	preader_run(&reader);
+
+	now = get_monotonic_time_us();
+
+	psensor_batch_begin(&b, sensors);
+
+	for (i = 0; sensors[i]; i++) {
+		data = sensors[i]->provider_data;
+		n = reader.reqs[i].ret;
+
+		ok = n > 0 && sysfs_parse_u64(data->buf, n, &energy);
+		if (!log_read(&data->failed,
+			      ok,
+			      PROVIDER_NAME,
+			      sensors[i]->id)) {
+			/* the next power is computed from a new origin */
+			data->time = 0;
+			continue;
+		}
+
+		if (data->time) {
+			w = powercap_get_power(data->energy,
+					       energy,
+					       data->range,
+					       now - data->time);
+
+			if (w != UNKNOWN_DBL_VALUE)
+				psensor_batch_set(&b, i, w);
+		}
+
+		data->energy = energy;
+		data->time = now;
+	}
+
+	psensor_batch_commit(&b);
+}
+
+void powercap_cleanup(void)
+{
+	preader_free(&reader);
+}
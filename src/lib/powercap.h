@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_POWERCAP_H_
+#define _PSENSOR_POWERCAP_H_
+
+#include <stdint.h>
+
+#include <pregistry.h>
+#include <psensor.h>
+
+/* Directory of the powercap zones exposed by the kernel */
+#define POWERCAP_SYSFS_ROOT "/sys/class/powercap"
+
+/*
+ * Adds a power sensor for each zone of the directory 'root', usually
+ * POWERCAP_SYSFS_ROOT, having an 'energy_uj' counter: the RAPL
+ * domains of the Intel CPUs and of the AMD CPUs supported by the
+ * intel-rapl driver, package, core, uncore, dram...
+ *
+ * The counters are readable only by root on most of the kernels, the
+ * zones which cannot be read are skipped.
+ */
+void powercap_psensor_list_append(struct psensor_registry *r,
+				  const char *root,
+				  int values_max_length);
+
+/*
+ * Reads the energy counters of 'sensors' and sets their average
+ * power since the previous update, nothing is set by the first one.
+ */
+void powercap_psensor_list_update(struct psensor **sensors);
+
+/*
+ * Returns the average power in watts of a zone whose counter went
+ * from 'last' to 'cur' microjoules in 'us' microseconds.  The counter
+ * wraps to 0 after 'range', a single wraparound is assumed.
+ *
+ * Returns UNKNOWN_DBL_VALUE if the counter went backward and
+ * 'range' is unknown (0).
+ */
+double powercap_get_power(uint64_t last,
+			  uint64_t cur,
+			  uint64_t range,
+			  int64_t us);
+
+void powercap_cleanup(void);
+
+#endif
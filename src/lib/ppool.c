@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <plog.h>
+#include <ppool.h>
+
+void ppool_job_init(struct ppool_job *j, void (*run)(void *), void *data)
+{
+	j->run = run;
+	j->data = data;
+	j->state = PPOOL_JOB_IDLE;
+	j->next = NULL;
+}
+
+static void *worker(void *data)
+{
+	struct ppool *p;
+	struct ppool_job *j;
+
+	p = (struct ppool *)data;
+
+	pthread_mutex_lock(&p->mutex);
+
+	while (1) {
+		while (!p->head && !p->stopped)
+			pthread_cond_wait(&p->queued, &p->mutex);
+
+		if (!p->head)
+			break;
+
+		j = p->head;
+		p->head = j->next;
+		if (!p->head)
+			p->tail = NULL;
+
+		j->state = PPOOL_JOB_RUNNING;
+
+		pthread_mutex_unlock(&p->mutex);
+
+		j->run(j->data);
+
+		pthread_mutex_lock(&p->mutex);
+
+		j->state = PPOOL_JOB_IDLE;
+		p->pending--;
+
+		pthread_cond_broadcast(&p->done);
+	}
+
+	pthread_mutex_unlock(&p->mutex);
+
+	return NULL;
+}
+
+bool ppool_init(struct ppool *p, int n)
+{
+	pthread_condattr_t attr;
+	int i;
+
+	pthread_mutex_init(&p->mutex, NULL);
+	pthread_cond_init(&p->queued, NULL);
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&p->done, &attr);
+	pthread_condattr_destroy(&attr);
+
+	p->head = NULL;
+	p->tail = NULL;
+	p->pending = 0;
+	p->stopped = false;
+
+	p->threads = malloc(n * sizeof(pthread_t));
+	p->threads_count = 0;
+
+	for (i = 0; i < n; i++) {
+		if (pthread_create(&p->threads[i], NULL, worker, p)) {
+			log_err("ppool: failed to create thread %d", i);
+			break;
+		}
+
+		p->threads_count++;
+	}
+
+	if (!p->threads_count) {
+		ppool_free(p);
+		return false;
+	}
+
+	return true;
+}
+
+void ppool_free(struct ppool *p)
+{
+	int i;
+
+	pthread_mutex_lock(&p->mutex);
+	p->stopped = true;
+	pthread_cond_broadcast(&p->queued);
+	pthread_mutex_unlock(&p->mutex);
+
+	for (i = 0; i < p->threads_count; i++)
+		pthread_join(p->threads[i], NULL);
+
+	free(p->threads);
+	p->threads = NULL;
+	p->threads_count = 0;
+
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->queued);
+	pthread_mutex_destroy(&p->mutex);
+}
+
+bool ppool_submit(struct ppool *p, struct ppool_job *j)
+{
+	bool ret;
+
+	pthread_mutex_lock(&p->mutex);
+
+	if (j->state == PPOOL_JOB_IDLE) {
+		j->state = PPOOL_JOB_QUEUED;
+		j->next = NULL;
+
+		if (p->tail)
+			p->tail->next = j;
+		else
+			p->head = j;
+		p->tail = j;
+
+		p->pending++;
+
+		pthread_cond_signal(&p->queued);
+
+		ret = true;
+	} else {
+		ret = false;
+	}
+
+	pthread_mutex_unlock(&p->mutex);
+
+	return ret;
+}
+
+int ppool_wait(struct ppool *p, int64_t deadline)
+{
+	struct timespec ts;
+	int pending;
+
+	ts.tv_sec = deadline / 1000;
+	ts.tv_nsec = (deadline % 1000) * 1000000;
+
+	pthread_mutex_lock(&p->mutex);
+
+	while (p->pending) {
+		if (deadline == -1)
+			pthread_cond_wait(&p->done, &p->mutex);
+		else if (pthread_cond_timedwait(&p->done, &p->mutex, &ts)
+			 == ETIMEDOUT)
+			break;
+	}
+
+	pending = p->pending;
+
+	pthread_mutex_unlock(&p->mutex);
+
+	return pending;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_PPOOL_H_
+#define _PSENSOR_PPOOL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <bool.h>
+
+/*
+ * Pool of threads running jobs submitted by a single thread, used for
+ * updating the sensors of the different providers concurrently.
+ *
+ * A job is submitted again only once its previous run is done, so a
+ * blocked job never runs twice at the same time.
+ */
+
+enum ppool_job_state {
+	PPOOL_JOB_IDLE,
+	PPOOL_JOB_QUEUED,
+	PPOOL_JOB_RUNNING
+};
+
+struct ppool_job {
+	void (*run)(void *data);
+	void *data;
+
+	/* Protected by the mutex of the pool */
+	enum ppool_job_state state;
+	struct ppool_job *next;
+};
+
+struct ppool {
+	pthread_mutex_t mutex;
+
+	/* Signaled when a job is queued or the pool is stopped */
+	pthread_cond_t queued;
+
+	/* Signaled when a job is done, based on CLOCK_MONOTONIC */
+	pthread_cond_t done;
+
+	/* FIFO of the queued jobs */
+	struct ppool_job *head;
+	struct ppool_job *tail;
+
+	/* Number of jobs queued or running */
+	int pending;
+
+	bool stopped;
+
+	pthread_t *threads;
+	int threads_count;
+};
+
+void ppool_job_init(struct ppool_job *j, void (*run)(void *), void *data);
+
+/* Starts 'n' threads, returns false on failure. */
+bool ppool_init(struct ppool *p, int n);
+
+/* Waits for the pending jobs and stops the threads. */
+void ppool_free(struct ppool *p);
+
+/*
+ * Queues a job.  Returns false if it is still queued or running since
+ * a previous submission.
+ */
+bool ppool_submit(struct ppool *p, struct ppool_job *j);
+
+/*
+ * Waits until all the submitted jobs are done or 'deadline' is
+ * reached, in milliseconds of CLOCK_MONOTONIC, -1 for no deadline.
+ *
+ * Returns the number of jobs still pending.
+ */
+int ppool_wait(struct ppool *p, int64_t deadline);
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include "config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(HAVE_LIBURING) && HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <plog.h>
+#include <preader.h>
+
+/* Initial capacity of the reads */
+static const int MIN_CAPACITY = 16;
+
+void preader_init(struct preader *r)
+{
+	r->reqs = NULL;
+	r->count = 0;
+	r->capacity = 0;
+	r->ring = NULL;
+	r->ring_failed = false;
+}
+
+#if defined(HAVE_LIBURING) && HAVE_LIBURING
+static void destroy_ring(struct preader *r)
+{
+	if (!r->ring)
+		return;
+
+	io_uring_queue_exit(r->ring);
+	free(r->ring);
+	r->ring = NULL;
+}
+
+static bool create_ring(struct preader *r)
+{
+	int err;
+
+	if (r->ring)
+		return true;
+
+	if (r->ring_failed)
+		return false;
+
+	r->ring = malloc(sizeof(struct io_uring));
+
+	err = io_uring_queue_init(PREADER_RING_SIZE, r->ring, 0);
+	if (err) {
+		log_debug("preader: io_uring not available: %s",
+			  strerror(-err));
+
+		free(r->ring);
+		r->ring = NULL;
+		r->ring_failed = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+/* Disables the ring after an unexpected error. */
+static void fail_ring(struct preader *r, int err)
+{
+	log_err("preader: io_uring failure: %s", strerror(-err));
+
+	destroy_ring(r);
+	r->ring_failed = true;
+}
+
+/*
+ * Reaps the completions of 'n' submitted reads.
+ *
+ * Returns false on failure.
+ */
+static bool reap(struct preader *r, int n)
+{
+	struct io_uring_cqe *cqes[PREADER_RING_SIZE], *cqe;
+	struct preader_req *q;
+	int i, k, err;
+
+	while (n > 0) {
+		/* no system call if the reads are already completed */
+		err = io_uring_wait_cqe_nr(r->ring, &cqe, n);
+		if (err == -EINTR)
+			continue;
+
+		if (err) {
+			fail_ring(r, err);
+			return false;
+		}
+
+		k = io_uring_peek_batch_cqe(r->ring, cqes, n);
+		for (i = 0; i < k; i++) {
+			q = io_uring_cqe_get_data(cqes[i]);
+			q->ret = cqes[i]->res;
+		}
+
+		io_uring_cq_advance(r->ring, k);
+
+		n -= k;
+	}
+
+	return true;
+}
+
+/*
+ * Does the reads with the ring.
+ *
+ * Returns the number of reads done, the following ones have to be
+ * done with pread().
+ */
+static int run_ring(struct preader *r)
+{
+	struct io_uring_sqe *sqe;
+	struct preader_req *q;
+	int i, n, done, submitted;
+
+	for (done = 0; done < r->count; done += n) {
+		n = r->count - done;
+		if (n > PREADER_RING_SIZE)
+			n = PREADER_RING_SIZE;
+
+		for (i = 0; i < n; i++) {
+			q = &r->reqs[done + i];
+
+			sqe = io_uring_get_sqe(r->ring);
+			io_uring_prep_read(sqe, q->fd, q->buf, q->size, 0);
+			io_uring_sqe_set_data(sqe, q);
+		}
+
+		submitted = io_uring_submit(r->ring);
+		if (submitted < 0) {
+			fail_ring(r, submitted);
+			return done;
+		}
+
+		if (!reap(r, submitted))
+			return done;
+
+		/* the submission stopped at a failed read */
+		if (submitted < n) {
+			fail_ring(r, -EIO);
+			return done + submitted;
+		}
+	}
+
+	return done;
+}
+#endif
+
+void preader_free(struct preader *r)
+{
+#if defined(HAVE_LIBURING) && HAVE_LIBURING
+	destroy_ring(r);
+#endif
+	free(r->reqs);
+
+	preader_init(r);
+}
+
+void preader_clear(struct preader *r)
+{
+	r->count = 0;
+}
+
+int preader_add(struct preader *r, int fd, char *buf, size_t size)
+{
+	struct preader_req *q;
+
+	if (r->count == r->capacity) {
+		if (r->capacity)
+			r->capacity *= 2;
+		else
+			r->capacity = MIN_CAPACITY;
+
+		r->reqs = realloc(r->reqs,
+				  r->capacity * sizeof(struct preader_req));
+	}
+
+	q = &r->reqs[r->count];
+	q->fd = fd;
+	q->buf = buf;
+	q->size = size;
+	q->ret = 0;
+
+	return r->count++;
+}
+
+void preader_run(struct preader *r)
+{
+	struct preader_req *q;
+	int i;
+
+	i = 0;
+
+#if defined(HAVE_LIBURING) && HAVE_LIBURING
+	/* a single read does not need the ring */
+	if (r->count > 1 && create_ring(r))
+		i = run_ring(r);
+#endif
+
+	for (; i < r->count; i++) {
+		q = &r->reqs[i];
+
+		q->ret = pread(q->fd, q->buf, q->size, 0);
+		if (q->ret == -1)
+			q->ret = -errno;
+	}
+}
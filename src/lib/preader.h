@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_PREADER_H_
+#define _PSENSOR_PREADER_H_
+
+#include <sys/types.h>
+
+#include <bool.h>
+
+/*
+ * Batch of reads of files kept open, such as the sysfs inputs of the
+ * sensors, each one read from its beginning.
+ *
+ * When psensor is built with liburing, a run submits all the reads
+ * to an io_uring and reaps their completions together: a system call
+ * for PREADER_RING_SIZE reads instead of one per read.  The files are
+ * read one by one with pread() if the kernel does not allow the
+ * creation of the ring.
+ *
+ * A struct preader must not be run concurrently: each provider owns
+ * the one of its updates, which are serialized by the sampler.
+ */
+
+/* Number of reads submitted together */
+#define PREADER_RING_SIZE 64
+
+struct preader_req {
+	int fd;
+	char *buf;
+	size_t size;
+
+	/* Number of bytes read or -errno, set by preader_run() */
+	ssize_t ret;
+};
+
+struct io_uring;
+
+struct preader {
+	struct preader_req *reqs;
+	int count;
+	int capacity;
+
+	/* Created by the first run, NULL if not available */
+	struct io_uring *ring;
+	bool ring_failed;
+};
+
+/* A zeroed struct preader is also initialized. */
+void preader_init(struct preader *r);
+
+void preader_free(struct preader *r);
+
+/* Removes all the reads, the ring is kept. */
+void preader_clear(struct preader *r);
+
+/*
+ * Adds the read of at most 'size' bytes of 'fd' into 'buf', 'buf'
+ * must remain valid until the end of the next run.
+ *
+ * Returns the index of the read in 'reqs'.
+ */
+int preader_add(struct preader *r, int fd, char *buf, size_t size);
+
+/* Does all the reads, their results are then in 'reqs'. */
+void preader_run(struct preader *r);
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <pregistry.h>
+
+/* SENSOR_TYPE_* flag of each provider, see enum psensor_provider */
+static const unsigned int PROVIDER_TYPES[PSENSOR_PROVIDERS_COUNT] = {
+	SENSOR_TYPE_REMOTE,
+	SENSOR_TYPE_LMSENSOR,
+	SENSOR_TYPE_NVCTRL,
+	SENSOR_TYPE_GTOP,
+	SENSOR_TYPE_ATIADL,
+	SENSOR_TYPE_ATASMART,
+	SENSOR_TYPE_HDDTEMP,
+	SENSOR_TYPE_UDISKS2,
+	SENSOR_TYPE_PHONE,
+	SENSOR_TYPE_HWMON,
+	SENSOR_TYPE_POWERCAP,
+	SENSOR_TYPE_CPUFREQ,
+	SENSOR_TYPE_CPUSTAT
+};
+
+static const char *PROVIDER_NAMES[PSENSOR_PROVIDERS_COUNT] = {
+	"remote",
+	"lmsensor",
+	"nvctrl",
+	"gtop2",
+	"atiadl",
+	"atasmart",
+	"hddtemp",
+	"udisks2",
+	"phone",
+	"hwmon",
+	"powercap",
+	"cpufreq",
+	"cpustat"
+};
+
+/* SENSOR_TYPE_* flag of each value type, see enum psensor_value_type */
+static const unsigned int VALUE_TYPES[PSENSOR_VALUE_TYPES_COUNT] = {
+	SENSOR_TYPE_TEMP,
+	SENSOR_TYPE_RPM,
+	SENSOR_TYPE_PERCENT,
+	SENSOR_TYPE_POWER,
+	SENSOR_TYPE_FREQ,
+	SENSOR_TYPE_RATE
+};
+
+/* Initial capacity of an array */
+static const int ARRAY_MIN_CAPACITY = 8;
+
+static void array_init(struct psensor_array *a)
+{
+	a->size = 0;
+	a->capacity = ARRAY_MIN_CAPACITY;
+	a->sensors = malloc((a->capacity + 1) * sizeof(struct psensor *));
+	a->sensors[0] = NULL;
+}
+
+static void array_add(struct psensor_array *a, struct psensor *s)
+{
+	if (a->size == a->capacity) {
+		a->capacity *= 2;
+		a->sensors = realloc(a->sensors,
+				     (a->capacity + 1)
+				     * sizeof(struct psensor *));
+	}
+
+	a->sensors[a->size] = s;
+	a->size++;
+	a->sensors[a->size] = NULL;
+}
+
+static void array_free(struct psensor_array *a)
+{
+	free(a->sensors);
+
+	a->sensors = NULL;
+	a->size = 0;
+	a->capacity = 0;
+}
+
+const char *psensor_provider_get_name(enum psensor_provider p)
+{
+	return PROVIDER_NAMES[p];
+}
+
+void psensor_registry_init(struct psensor_registry *r)
+{
+	int i;
+
+	array_init(&r->all);
+
+	for (i = 0; i < PSENSOR_PROVIDERS_COUNT; i++)
+		array_init(&r->providers[i]);
+
+	for (i = 0; i < PSENSOR_VALUE_TYPES_COUNT; i++)
+		array_init(&r->types[i]);
+}
+
+void psensor_registry_free(struct psensor_registry *r)
+{
+	int i;
+
+	for (i = 0; i < r->all.size; i++)
+		psensor_free(r->all.sensors[i]);
+
+	array_free(&r->all);
+
+	for (i = 0; i < PSENSOR_PROVIDERS_COUNT; i++)
+		array_free(&r->providers[i]);
+
+	for (i = 0; i < PSENSOR_VALUE_TYPES_COUNT; i++)
+		array_free(&r->types[i]);
+}
+
+void psensor_registry_add(struct psensor_registry *r, struct psensor *s)
+{
+	int i;
+
+	if (!s)
+		return;
+
+	array_add(&r->all, s);
+
+	for (i = 0; i < PSENSOR_PROVIDERS_COUNT; i++)
+		if (s->type & PROVIDER_TYPES[i]) {
+			array_add(&r->providers[i], s);
+			break;
+		}
+
+	for (i = 0; i < PSENSOR_VALUE_TYPES_COUNT; i++)
+		if (s->type & VALUE_TYPES[i])
+			array_add(&r->types[i], s);
+
+	psensor_index_add(s);
+}
+
+/* Returns true if the list 'sensors' is the copy of the cache. */
+static bool is_same_list(const struct psensor_list_extrema *e,
+			 struct psensor **sensors)
+{
+	int i;
+
+	for (i = 0; i < e->size && sensors[i]; i++)
+		if (sensors[i] != e->sensors[i])
+			return false;
+
+	return i == e->size && !sensors[i];
+}
+
+static void copy_list(struct psensor_list_extrema *e,
+		      struct psensor **sensors)
+{
+	int n;
+
+	n = psensor_list_size(sensors);
+
+	e->sensors = realloc(e->sensors, (n + 1) * sizeof(struct psensor *));
+	memcpy(e->sensors, sensors, (n + 1) * sizeof(struct psensor *));
+	e->size = n;
+}
+
+static void update_extremum(double *m, double v, bool is_min)
+{
+	if (v == UNKNOWN_DBL_VALUE)
+		return;
+
+	if (*m == UNKNOWN_DBL_VALUE || (is_min ? v < *m : v > *m))
+		*m = v;
+}
+
+void psensor_list_extrema_update(struct psensor_list_extrema *e,
+				 struct psensor **sensors,
+				 int span)
+{
+	struct psensor **cur;
+	unsigned int generation;
+	double min, max;
+	bool same_list;
+	int i;
+
+	/* loaded first: a later commit makes the next update read again */
+	generation = psensor_get_measures_generation();
+
+	same_list = e->valid && is_same_list(e, sensors);
+
+	if (same_list && e->generation == generation && e->span == span)
+		return;
+
+	for (i = 0; i < PSENSOR_VALUE_TYPES_COUNT; i++) {
+		e->min[i] = UNKNOWN_DBL_VALUE;
+		e->max[i] = UNKNOWN_DBL_VALUE;
+	}
+
+	for (cur = sensors; *cur; cur++) {
+		psensor_get_extrema(*cur, span, &min, &max);
+
+		for (i = 0; i < PSENSOR_VALUE_TYPES_COUNT; i++)
+			if ((*cur)->type & VALUE_TYPES[i]) {
+				update_extremum(&e->min[i], min, true);
+				update_extremum(&e->max[i], max, false);
+			}
+	}
+
+	if (!same_list)
+		copy_list(e, sensors);
+
+	e->span = span;
+	e->generation = generation;
+	e->valid = true;
+}
+
+void psensor_list_extrema_free(struct psensor_list_extrema *e)
+{
+	free(e->sensors);
+
+	e->sensors = NULL;
+	e->size = 0;
+	e->valid = false;
+}
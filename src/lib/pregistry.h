@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_PREGISTRY_H_
+#define _PSENSOR_PREGISTRY_H_
+
+#include <psensor.h>
+
+/*
+ * Providers of sensors, each one corresponds to a SENSOR_TYPE_* flag
+ * of the library used for retrieving the measures.  The remote
+ * sensors belong to PSENSOR_PROVIDER_REMOTE whatever the library
+ * used by the remote server.
+ */
+enum psensor_provider {
+	PSENSOR_PROVIDER_REMOTE,
+	PSENSOR_PROVIDER_LMSENSOR,
+	PSENSOR_PROVIDER_NVCTRL,
+	PSENSOR_PROVIDER_GTOP,
+	PSENSOR_PROVIDER_ATIADL,
+	PSENSOR_PROVIDER_ATASMART,
+	PSENSOR_PROVIDER_HDDTEMP,
+	PSENSOR_PROVIDER_UDISKS2,
+	PSENSOR_PROVIDER_PHONE,
+	PSENSOR_PROVIDER_HWMON,
+	PSENSOR_PROVIDER_POWERCAP,
+	PSENSOR_PROVIDER_CPUFREQ,
+	PSENSOR_PROVIDER_CPUSTAT,
+
+	PSENSOR_PROVIDERS_COUNT
+};
+
+/* Returns the name of a provider, for logging. */
+const char *psensor_provider_get_name(enum psensor_provider p);
+
+/* Types of values, each one has its sublist in the registry. */
+enum psensor_value_type {
+	PSENSOR_VALUE_TEMP,
+	PSENSOR_VALUE_RPM,
+	PSENSOR_VALUE_PERCENT,
+	PSENSOR_VALUE_POWER,
+	PSENSOR_VALUE_FREQ,
+	PSENSOR_VALUE_RATE,
+
+	PSENSOR_VALUE_TYPES_COUNT
+};
+
+/* Growable NULL terminated array of sensors. */
+struct psensor_array {
+	struct psensor **sensors;
+	int size;
+	int capacity;
+};
+
+/*
+ * Registry of the sensors.
+ *
+ * The position of a sensor in the registry never changes, the
+ * sublists by provider and by type of values are filled when the
+ * sensor is added.
+ */
+struct psensor_registry {
+	struct psensor_array all;
+	struct psensor_array providers[PSENSOR_PROVIDERS_COUNT];
+	struct psensor_array types[PSENSOR_VALUE_TYPES_COUNT];
+};
+
+void psensor_registry_init(struct psensor_registry *r);
+
+/* Frees the registry and all its sensors. */
+void psensor_registry_free(struct psensor_registry *r);
+
+/*
+ * Adds a sensor at the end of the registry, in amortized constant
+ * time.  The sensor is freed with the registry.  Does nothing if 's'
+ * is NULL.
+ */
+void psensor_registry_add(struct psensor_registry *r, struct psensor *s);
+
+static inline int psensor_registry_size(const struct psensor_registry *r)
+{
+	return r->all.size;
+}
+
+/* Returns the sensor at position 'i'. */
+static inline struct psensor *
+psensor_registry_get(const struct psensor_registry *r, int i)
+{
+	return r->all.sensors[i];
+}
+
+/*
+ * Returns the NULL terminated list of all the sensors.  It remains
+ * valid until the next call of psensor_registry_add().
+ */
+static inline struct psensor **
+psensor_registry_list(const struct psensor_registry *r)
+{
+	return r->all.sensors;
+}
+
+/* Returns the NULL terminated list of the sensors of a provider. */
+static inline struct psensor **
+psensor_registry_get_provider(const struct psensor_registry *r,
+			      enum psensor_provider p)
+{
+	return r->providers[p].sensors;
+}
+
+/* Returns the NULL terminated list of the sensors of a value type. */
+static inline struct psensor **
+psensor_registry_get_type(const struct psensor_registry *r,
+			  enum psensor_value_type t)
+{
+	return r->types[t].sensors;
+}
+
+/*
+ * Extrema of the measures of a list of sensors by type of values.  A
+ * zeroed structure is an empty cache.
+ */
+struct psensor_list_extrema {
+	/* copy of the list the extrema have been computed for */
+	struct psensor **sensors;
+	int size;
+
+	int span;
+	unsigned int generation;
+	bool valid;
+
+	double min[PSENSOR_VALUE_TYPES_COUNT];
+	double max[PSENSOR_VALUE_TYPES_COUNT];
+};
+
+/*
+ * Updates the extrema of the NULL terminated list 'sensors' during
+ * the last 'span' seconds, see psensor_get_extrema().
+ *
+ * The measures are read in a single pass over the list, and only if
+ * a measure has been added or a history resized since the previous
+ * update, or if the list or the span has changed.  Otherwise, the
+ * update only compares the list with its copy.
+ */
+void psensor_list_extrema_update(struct psensor_list_extrema *e,
+				 struct psensor **sensors,
+				 int span);
+
+void psensor_list_extrema_free(struct psensor_list_extrema *e);
+
+#endif
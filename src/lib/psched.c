@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <psched.h>
+
+/* Initial capacity of the heap */
+static const int HEAP_MIN_CAPACITY = 16;
+
+static void swap(struct psched_task **heap, int i, int j)
+{
+	struct psched_task *t;
+
+	t = heap[i];
+	heap[i] = heap[j];
+	heap[j] = t;
+}
+
+static void sift_up(struct psched_task **heap, int i)
+{
+	int parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+
+		if (heap[parent]->deadline <= heap[i]->deadline)
+			break;
+
+		swap(heap, i, parent);
+		i = parent;
+	}
+}
+
+static void sift_down(struct psched_task **heap, int size, int i)
+{
+	int child;
+
+	while (1) {
+		child = 2 * i + 1;
+
+		if (child >= size)
+			break;
+
+		if (child + 1 < size
+		    && heap[child + 1]->deadline < heap[child]->deadline)
+			child++;
+
+		if (heap[i]->deadline <= heap[child]->deadline)
+			break;
+
+		swap(heap, i, child);
+		i = child;
+	}
+}
+
+void psched_init(struct psched *s)
+{
+	s->size = 0;
+	s->capacity = HEAP_MIN_CAPACITY;
+	s->heap = malloc(s->capacity * sizeof(struct psched_task *));
+}
+
+void psched_free(struct psched *s)
+{
+	int i;
+
+	for (i = 0; i < s->size; i++)
+		free(s->heap[i]);
+
+	free(s->heap);
+
+	s->heap = NULL;
+	s->size = 0;
+	s->capacity = 0;
+}
+
+struct psched_task *psched_add(struct psched *s,
+			       int interval,
+			       void (*run)(void *),
+			       void *data,
+			       int64_t start)
+{
+	struct psched_task *t;
+
+	if (s->size == s->capacity) {
+		s->capacity *= 2;
+		s->heap = realloc(s->heap,
+				  s->capacity * sizeof(struct psched_task *));
+	}
+
+	t = malloc(sizeof(*t));
+	t->deadline = start;
+	t->overruns = 0;
+	t->run = run;
+	t->data = data;
+	psched_task_set_interval(t, interval);
+
+	s->heap[s->size] = t;
+	sift_up(s->heap, s->size);
+	s->size++;
+
+	return t;
+}
+
+void psched_task_set_interval(struct psched_task *t, int interval)
+{
+	if (interval < 1)
+		interval = 1;
+
+	t->interval = interval;
+}
+
+int64_t psched_get_next_deadline(const struct psched *s)
+{
+	if (!s->size)
+		return -1;
+
+	return s->heap[0]->deadline;
+}
+
+int psched_run_due(struct psched *s, int64_t now)
+{
+	struct psched_task *t;
+	int64_t missed;
+	int n;
+
+	n = 0;
+	while (s->size && s->heap[0]->deadline <= now) {
+		t = s->heap[0];
+
+		t->run(t->data);
+		n++;
+
+		t->deadline += t->interval;
+		if (t->deadline <= now) {
+			missed = (now - t->deadline) / t->interval + 1;
+			t->overruns += missed;
+			t->deadline += missed * t->interval;
+		}
+
+		sift_down(s->heap, s->size, 0);
+	}
+
+	return n;
+}
+
+int64_t psched_get_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void psched_sleep_until(int64_t deadline)
+{
+	struct timespec ts;
+
+	ts.tv_sec = deadline / 1000;
+	ts.tv_nsec = (deadline % 1000) * 1000000;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+	       == EINTR)
+		;
+}
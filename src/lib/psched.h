@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_PSCHED_H_
+#define _PSENSOR_PSCHED_H_
+
+#include <stdint.h>
+
+/*
+ * Scheduler of periodic tasks, typically the update of the sensors
+ * of a provider.
+ *
+ * The tasks are kept in a binary min-heap ordered by deadline, the
+ * caller sleeps until the earliest deadline and runs the due tasks.
+ * Times are in milliseconds of CLOCK_MONOTONIC.
+ */
+
+struct psched_task {
+	/* Time of the next run */
+	int64_t deadline;
+
+	/* Period in milliseconds, at least 1 */
+	int interval;
+
+	/* Number of runs missed because the task was late */
+	unsigned int overruns;
+
+	void (*run)(void *data);
+	void *data;
+};
+
+struct psched {
+	/* Binary min-heap of the tasks ordered by deadline */
+	struct psched_task **heap;
+	int size;
+	int capacity;
+};
+
+void psched_init(struct psched *s);
+
+/* Frees the scheduler and its tasks. */
+void psched_free(struct psched *s);
+
+/*
+ * Adds a task running 'run' every 'interval' milliseconds, the first
+ * run being due at 'start'.
+ */
+struct psched_task *psched_add(struct psched *s,
+			       int interval,
+			       void (*run)(void *),
+			       void *data,
+			       int64_t start);
+
+/* Changes the period of a task, applied from its next run. */
+void psched_task_set_interval(struct psched_task *t, int interval);
+
+/* Returns the earliest deadline or -1 if there is no task. */
+int64_t psched_get_next_deadline(const struct psched *s);
+
+/*
+ * Runs the tasks whose deadline is not after 'now' and schedules
+ * their next run one interval after their deadline, so that the
+ * period does not drift with the time taken by the runs.  The runs
+ * missed because a task is late are skipped and counted in its
+ * overruns.
+ *
+ * Returns the number of tasks run.
+ */
+int psched_run_due(struct psched *s, int64_t now);
+
+/* Returns the current time of CLOCK_MONOTONIC in milliseconds. */
+int64_t psched_get_time(void);
+
+/* Sleeps until 'deadline' in milliseconds of CLOCK_MONOTONIC. */
+void psched_sleep_until(int64_t deadline);
+
+#endif
@@ -16,8 +16,11 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
  * 02110-1301 USA
  */
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <locale.h>
 #include <libintl.h>
@@ -29,6 +32,268 @@
 #include <psensor.h>
 #include <temperature.h>
 
+/*
+ * Index of the sensors by identifier: hash table whose buckets are
+ * chained through psensor->index_next.  The number of buckets is a
+ * power of 2.
+ */
+static struct psensor **index_buckets;
+static unsigned int index_size;
+static unsigned int index_count;
+
+/* Initial number of buckets of the index */
+static const unsigned int INDEX_MIN_SIZE = 64;
+
+/* FNV-1a hash of a sensor identifier */
+static unsigned int id_hash(const char *id)
+{
+	unsigned int h;
+
+	h = 2166136261u;
+	while (*id) {
+		h ^= (unsigned char)*id;
+		h *= 16777619u;
+		id++;
+	}
+
+	return h;
+}
+
+static void index_resize(unsigned int size)
+{
+	struct psensor **buckets, *s, *next;
+	unsigned int i, h;
+
+	buckets = calloc(size, sizeof(struct psensor *));
+
+	for (i = 0; i < index_size; i++)
+		for (s = index_buckets[i]; s; s = next) {
+			next = s->index_next;
+
+			h = id_hash(s->id) & (size - 1);
+			s->index_next = buckets[h];
+			buckets[h] = s;
+		}
+
+	free(index_buckets);
+
+	index_buckets = buckets;
+	index_size = size;
+}
+
+static struct psensor *index_lookup(const char *id)
+{
+	struct psensor *s;
+
+	if (!index_count)
+		return NULL;
+
+	s = index_buckets[id_hash(id) & (index_size - 1)];
+	while (s && strcmp(s->id, id))
+		s = s->index_next;
+
+	return s;
+}
+
+void psensor_index_add(struct psensor *s)
+{
+	struct psensor *cur;
+	unsigned int h;
+
+	if (index_count) {
+		h = id_hash(s->id) & (index_size - 1);
+		for (cur = index_buckets[h]; cur; cur = cur->index_next)
+			if (cur == s)
+				return;
+	}
+
+	/* keeps a load factor lower than 1 */
+	if (index_count >= index_size)
+		index_resize(index_size ? 2 * index_size : INDEX_MIN_SIZE);
+
+	h = id_hash(s->id) & (index_size - 1);
+	s->index_next = index_buckets[h];
+	index_buckets[h] = s;
+
+	index_count++;
+}
+
+static void index_remove(struct psensor *s)
+{
+	struct psensor **cur;
+
+	if (!index_count)
+		return;
+
+	cur = &index_buckets[id_hash(s->id) & (index_size - 1)];
+	while (*cur) {
+		if (*cur == s) {
+			*cur = s->index_next;
+			s->index_next = NULL;
+			index_count--;
+			break;
+		}
+		cur = &(*cur)->index_next;
+	}
+
+	if (!index_count) {
+		free(index_buckets);
+		index_buckets = NULL;
+		index_size = 0;
+	}
+}
+
+/*
+ * Lock free reading of the measures.
+ *
+ * 'seq' is incremented before and after each update of the
+ * measures by the writer thread, so it is odd while an update is in
+ * progress.  Readers copy what they need and start again if 'seq'
+ * was odd or has changed meanwhile.
+ *
+ * The full resolution history is not reallocated on resize: a new
+ * one is published as an update and the previous one is freed by the
+ * writer once 'readers' is back to 0.  A reader increments 'readers'
+ * before loading 'measures', so either the writer sees it or the
+ * reader gets the new history.  'measures' is loaded again at each
+ * attempt, a reader still using the previous history would otherwise
+ * miss the measures added since the resize.  The rollup tiers are
+ * allocated and freed the same way when the history is enabled or
+ * disabled.
+ */
+static void read_enter(const struct psensor *s)
+{
+	struct psensor *w = (struct psensor *)s;
+
+	__atomic_add_fetch(&w->readers, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Returns the full resolution history, between read_enter/exit(). */
+static const struct measure_columns *get_measures(const struct psensor *s)
+{
+	return __atomic_load_n(&s->measures, __ATOMIC_SEQ_CST);
+}
+
+/* Returns the rollup tiers or NULL, between read_enter/exit(). */
+static const struct measure_tier *get_tiers(const struct psensor *s)
+{
+	return __atomic_load_n(&s->tiers, __ATOMIC_SEQ_CST);
+}
+
+static void read_exit(const struct psensor *s)
+{
+	struct psensor *w = (struct psensor *)s;
+
+	__atomic_sub_fetch(&w->readers, 1, __ATOMIC_RELEASE);
+}
+
+static unsigned int read_begin(const struct psensor *s)
+{
+	return __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+}
+
+/* Returns true if the data read since read_begin() must be discarded. */
+static bool read_retry(const struct psensor *s, unsigned int seq)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return (seq & 1) || __atomic_load_n(&s->seq, __ATOMIC_RELAXED) != seq;
+}
+
+static void write_begin(struct psensor *s)
+{
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(struct psensor *s)
+{
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+static void free_tiers(struct measure_tier *tiers)
+{
+	int i;
+
+	if (!tiers)
+		return;
+
+	for (i = 0; i < PSENSOR_TIERS_COUNT; i++)
+		measure_tier_free(&tiers[i]);
+
+	free(tiers);
+}
+
+/*
+ * Frees the history replaced by the last resize if no reader may
+ * use it anymore.
+ *
+ * Returns false if it is still in use.
+ */
+static bool release_retired_measures(struct psensor *s)
+{
+	if (!s->retired_measures)
+		return true;
+
+	if (__atomic_load_n(&s->readers, __ATOMIC_SEQ_CST))
+		return false;
+
+	measure_columns_free(s->retired_measures);
+	free(s->retired_measures);
+	s->retired_measures = NULL;
+
+	free_tiers(s->retired_tiers);
+	s->retired_tiers = NULL;
+
+	return true;
+}
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+/*
+ * Frees the blocks evicted from the compressed history if no reader
+ * may use them anymore.  The blocks are loaded with the same
+ * protocol as the full resolution history.
+ */
+static void release_retired_blocks(struct psensor *s)
+{
+	if (s->archive->retired
+	    && !__atomic_load_n(&s->readers, __ATOMIC_SEQ_CST))
+		measure_archive_release(s->archive);
+}
+#endif
+
+/* Durations and numbers of the periods of the rollup tiers */
+static const struct {
+	int step;
+	int size;
+} TIERS[PSENSOR_TIERS_COUNT] = {
+	{10, 360},	/* 1 hour */
+	{60, 360},	/* 6 hours */
+	{600, 432}	/* 3 days */
+};
+
+static struct measure_tier *create_tiers(void)
+{
+	struct measure_tier *tiers;
+	int i;
+
+	tiers = malloc(PSENSOR_TIERS_COUNT * sizeof(struct measure_tier));
+
+	for (i = 0; i < PSENSOR_TIERS_COUNT; i++)
+		measure_tier_init(&tiers[i], TIERS[i].step, TIERS[i].size);
+
+	return tiers;
+}
+
+/* Returns the number of measures of the full resolution history. */
+static int get_measures_length(int values_max_length, bool history)
+{
+	if (history || values_max_length < PSENSOR_CURRENT_LENGTH)
+		return values_max_length;
+
+	return PSENSOR_CURRENT_LENGTH;
+}
+
 struct psensor *psensor_create(char *id,
 			       char *name,
 			       char *chip,
@@ -56,7 +321,19 @@ struct psensor *psensor_create(char *id,
 	psensor->type = type;
 
 	psensor->values_max_length = values_max_length;
-	psensor->measures = measures_dbl_create(values_max_length);
+	psensor->history_enabled = false;
+	psensor->measures = malloc(sizeof(struct measure_columns));
+	measure_columns_init(psensor->measures,
+			     get_measures_length(values_max_length, false));
+	psensor->retired_measures = NULL;
+
+	psensor->tiers = NULL;
+	psensor->retired_tiers = NULL;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	psensor->archive = malloc(sizeof(struct measure_archive));
+	measure_archive_init(psensor->archive, PSENSOR_ARCHIVE_DURATION);
+#endif
 
 	psensor->alarm_high_threshold = 0;
 	psensor->alarm_low_threshold = 0;
@@ -65,33 +342,101 @@ struct psensor *psensor_create(char *id,
 	psensor->cb_alarm_raised_data = NULL;
 	psensor->alarm_raised = 0;
 
+	psensor->batch_pending = false;
+	psensor->batch_raised = false;
+
 	psensor->provider_data = NULL;
+	psensor->index_next = NULL;
 	psensor->provider_data_free_fct = &free;
 
+	psensor->seq = 0;
+	psensor->readers = 0;
+
 	return psensor;
 }
 
+/* Incremented after each change of a history, see psensor.h */
+static unsigned int measures_generation;
+
+unsigned int psensor_get_measures_generation(void)
+{
+	return __atomic_load_n(&measures_generation, __ATOMIC_ACQUIRE);
+}
+
 void psensor_values_resize(struct psensor *s, int new_size)
 {
-	struct measure *new_ms, *cur_ms;
-	int cur_size;
+	struct measure_columns *c;
 
-	cur_size = s->values_max_length;
-	cur_ms = s->measures;
-	new_ms = measures_dbl_create(new_size);
+	if (!release_retired_measures(s))
+		return;
 
-	if (cur_ms) {
-		int i;
+	c = malloc(sizeof(struct measure_columns));
+	measure_columns_copy(c,
+			     s->measures,
+			     get_measures_length(new_size, s->tiers != NULL));
 
-		for (i = 0; i < new_size - 1 && i < cur_size - 1; i++)
-			measure_copy(&cur_ms[cur_size - i - 1],
-				     &new_ms[new_size - i - 1]);
+	write_begin(s);
 
-		measures_free(s->measures);
-	}
+	s->retired_measures = s->measures;
+	__atomic_store_n(&s->measures, c, __ATOMIC_SEQ_CST);
 
 	s->values_max_length = new_size;
-	s->measures = new_ms;
+
+	write_end(s);
+
+	__atomic_add_fetch(&measures_generation, 1, __ATOMIC_RELEASE);
+
+	release_retired_measures(s);
+}
+
+void psensor_set_history_enabled(struct psensor *s, bool enabled)
+{
+	__atomic_store_n(&s->history_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+/*
+ * Allocates or frees the history if it has been enabled or disabled
+ * since the last measure.  Does nothing while the history replaced
+ * by a previous change is still read.
+ */
+static void update_history(struct psensor *s)
+{
+	struct measure_columns *c;
+	struct measure_tier *tiers;
+	bool enabled;
+
+	enabled = __atomic_load_n(&s->history_enabled, __ATOMIC_RELAXED);
+
+	if (enabled == (s->tiers != NULL) || !release_retired_measures(s))
+		return;
+
+	c = malloc(sizeof(struct measure_columns));
+	measure_columns_copy(c,
+			     s->measures,
+			     get_measures_length(s->values_max_length,
+						 enabled));
+
+	if (enabled)
+		tiers = create_tiers();
+	else
+		tiers = NULL;
+
+	write_begin(s);
+
+	s->retired_measures = s->measures;
+	__atomic_store_n(&s->measures, c, __ATOMIC_SEQ_CST);
+
+	s->retired_tiers = s->tiers;
+	__atomic_store_n(&s->tiers, tiers, __ATOMIC_SEQ_CST);
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (!enabled)
+		measure_archive_clear(s->archive);
+#endif
+
+	write_end(s);
+
+	release_retired_measures(s);
 }
 
 void psensor_free(struct psensor *s)
@@ -101,13 +446,29 @@ void psensor_free(struct psensor *s)
 
 	log_debug("Cleanup %s", s->id);
 
+	index_remove(s);
+
 	free(s->name);
 	free(s->id);
 
 	if (s->chip)
 		free(s->chip);
 
-	measures_free(s->measures);
+	measure_columns_free(s->measures);
+	free(s->measures);
+
+	if (s->retired_measures) {
+		measure_columns_free(s->retired_measures);
+		free(s->retired_measures);
+	}
+
+	free_tiers(s->tiers);
+	free_tiers(s->retired_tiers);
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	measure_archive_free(s->archive);
+	free(s->archive);
+#endif
 
 	if (s->provider_data && s->provider_data_free_fct)
 		s->provider_data_free_fct(s->provider_data);
@@ -168,6 +529,9 @@ struct psensor **psensor_list_add(struct psensor **sensors,
 	result[size] = sensor;
 	result[size + 1] = NULL;
 
+	if (sensor)
+		psensor_index_add(sensor);
+
 	return result;
 }
 
@@ -189,8 +553,16 @@ void psensor_list_append(struct psensor ***sensors, struct psensor *sensor)
 
 struct psensor *psensor_list_get_by_id(struct psensor **sensors, const char *id)
 {
-	struct psensor **sensors_cur = sensors;
+	struct psensor **sensors_cur, *s;
+
+	s = index_lookup(id);
+	if (s)
+		return s;
+
+	if (!sensors)
+		return NULL;
 
+	sensors_cur = sensors;
 	while (*sensors_cur) {
 		if (!strcmp((*sensors_cur)->id, id))
 			return *sensors_cur;
@@ -206,26 +578,41 @@ int is_temp_type(unsigned int type)
 	return type & SENSOR_TYPE_TEMP;
 }
 
-char *
-psensor_value_to_str(unsigned int type, double value, int use_celsius)
+char *psensor_value_to_buf(unsigned int type,
+			   double value,
+			   int use_celsius,
+			   char *buf,
+			   size_t size)
 {
-	char *str;
 	const char *unit;
 
-	/*
-	 * should not be possible to exceed 20 characters with temp or
-	 * rpm values the .x part is never displayed
-	 */
-	str = malloc(20);
-
 	unit = psensor_type_to_unit_str(type, use_celsius);
 
 	if (is_temp_type(type) && !use_celsius)
 		value = celsius_to_fahrenheit(value);
 
-	sprintf(str, "%.0f%s", value, unit);
+	/*
+	 * the power of a CPU core is often a few watts and the rates of
+	 * events below one per second
+	 */
+	if (type & (SENSOR_TYPE_POWER | SENSOR_TYPE_RATE))
+		snprintf(buf, size, "%.1f%s", value, unit);
+	else
+		snprintf(buf, size, "%.0f%s", value, unit);
+
+	return buf;
+}
+
+char *
+psensor_value_to_str(unsigned int type, double value, int use_celsius)
+{
+	char buf[PSENSOR_VALUE_STR_SIZE];
 
-	return str;
+	return strdup(psensor_value_to_buf(type,
+					   value,
+					   use_celsius,
+					   buf,
+					   sizeof(buf)));
 }
 
 char *
@@ -246,14 +633,36 @@ void psensor_set_current_value(struct psensor *sensor, double value)
 	psensor_set_current_measure(sensor, value, tv);
 }
 
-void psensor_set_current_measure(struct psensor *s, double v, struct timeval tv)
+/*
+ * Adds a measure to the histories and updates the session extrema
+ * and the alarm.
+ *
+ * Returns true if the alarm callback has to be called.
+ */
+static bool add_measure(struct psensor *s, double v, struct timeval tv)
 {
-	memmove(s->measures,
-		&s->measures[1],
-		(s->values_max_length - 1) * sizeof(struct measure));
+	int i;
+	bool raised;
+
+	update_history(s);
+
+	release_retired_measures(s);
+#ifdef ENABLE_COMPRESSED_HISTORY
+	release_retired_blocks(s);
+#endif
 
-	s->measures[s->values_max_length - 1].value = v;
-	s->measures[s->values_max_length - 1].time = tv;
+	write_begin(s);
+
+	measure_columns_push(s->measures, v, tv);
+
+	if (s->tiers) {
+		for (i = 0; i < PSENSOR_TIERS_COUNT; i++)
+			measure_tier_push(&s->tiers[i], v, tv);
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+		measure_archive_push(s->archive, v, tv);
+#endif
+	}
 
 	if (s->sess_lowest == UNKNOWN_DBL_VALUE || v < s->sess_lowest)
 		s->sess_lowest = v;
@@ -261,51 +670,659 @@ void psensor_set_current_measure(struct psensor *s, double v, struct timeval tv)
 	if (s->sess_highest == UNKNOWN_DBL_VALUE || v > s->sess_highest)
 		s->sess_highest = v;
 
+	raised = false;
 	if (v > s->alarm_high_threshold || v < s->alarm_low_threshold) {
 		if (!s->alarm_raised && s->cb_alarm_raised) {
 			s->alarm_raised = true;
-			s->cb_alarm_raised(s, s->cb_alarm_raised_data);
+			raised = true;
 		}
 	} else {
 		s->alarm_raised = false;
 	}
+
+	write_end(s);
+
+	return raised;
+}
+
+void psensor_set_current_measure(struct psensor *s, double v, struct timeval tv)
+{
+	bool raised;
+
+	raised = add_measure(s, v, tv);
+
+	__atomic_add_fetch(&measures_generation, 1, __ATOMIC_RELEASE);
+
+	if (raised)
+		s->cb_alarm_raised(s, s->cb_alarm_raised_data);
+}
+
+void psensor_raise_alarm(struct psensor *s)
+{
+	if (s->alarm_raised || !s->cb_alarm_raised)
+		return;
+
+	write_begin(s);
+	s->alarm_raised = true;
+	write_end(s);
+
+	s->cb_alarm_raised(s, s->cb_alarm_raised_data);
+}
+
+static struct {
+	void (*cb)(void *);
+	void *data;
+} cycle_listeners[PSENSOR_CYCLE_LISTENERS_MAX];
+
+/* Published after the listener, read without lock by the cycle ends */
+static int cycle_listeners_count;
+static pthread_mutex_t cycle_listeners_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Number of measures committed since the end of the last cycle */
+static unsigned int cycle_measures;
+
+bool psensor_cycle_add_listener(void (*cb)(void *), void *data)
+{
+	bool ret;
+	int n;
+
+	pthread_mutex_lock(&cycle_listeners_mutex);
+
+	n = cycle_listeners_count;
+	if (n < PSENSOR_CYCLE_LISTENERS_MAX) {
+		cycle_listeners[n].cb = cb;
+		cycle_listeners[n].data = data;
+
+		n++;
+		__atomic_store_n(&cycle_listeners_count, n, __ATOMIC_RELEASE);
+
+		ret = true;
+	} else {
+		ret = false;
+	}
+
+	pthread_mutex_unlock(&cycle_listeners_mutex);
+
+	return ret;
+}
+
+void psensor_cycle_end(void)
+{
+	int i, listeners;
+
+	if (!__atomic_exchange_n(&cycle_measures, 0, __ATOMIC_ACQ_REL))
+		return;
+
+	listeners = __atomic_load_n(&cycle_listeners_count, __ATOMIC_ACQUIRE);
+	for (i = 0; i < listeners; i++)
+		cycle_listeners[i].cb(cycle_listeners[i].data);
+}
+
+void psensor_batch_begin(struct psensor_batch *b, struct psensor **sensors)
+{
+	struct timespec ts;
+
+	b->sensors = sensors;
+
+	if (gettimeofday(&b->time, NULL) != 0)
+		timerclear(&b->time);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	b->monotonic_time = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void psensor_batch_set_measure(struct psensor_batch *b,
+			       int i,
+			       double v,
+			       struct timeval tv)
+{
+	struct psensor *s;
+
+	s = b->sensors[i];
+
+	s->batch_measure.value = v;
+	s->batch_measure.time = tv;
+	s->batch_pending = true;
+}
+
+void psensor_batch_set(struct psensor_batch *b, int i, double v)
+{
+	psensor_batch_set_measure(b, i, v, b->time);
+}
+
+int psensor_batch_commit(struct psensor_batch *b)
+{
+	struct psensor **cur, *s;
+	int n, raised;
+
+	n = 0;
+	raised = 0;
+	for (cur = b->sensors; *cur; cur++) {
+		s = *cur;
+
+		if (!s->batch_pending)
+			continue;
+
+		s->batch_pending = false;
+		s->batch_raised = add_measure(s,
+					      s->batch_measure.value,
+					      s->batch_measure.time);
+
+		if (s->batch_raised)
+			raised++;
+
+		n++;
+	}
+
+	for (cur = b->sensors; raised && *cur; cur++) {
+		s = *cur;
+
+		if (s->batch_raised) {
+			s->batch_raised = false;
+			s->cb_alarm_raised(s, s->cb_alarm_raised_data);
+			raised--;
+		}
+	}
+
+	if (n) {
+		__atomic_add_fetch(&measures_generation, 1, __ATOMIC_RELEASE);
+		__atomic_add_fetch(&cycle_measures, n, __ATOMIC_RELEASE);
+	}
+
+	return n;
 }
 
 double psensor_get_current_value(const struct psensor *sensor)
 {
-	return sensor->measures[sensor->values_max_length - 1].value;
+	struct measure m;
+
+	psensor_get_current_measure(sensor, &m);
+
+	return m.value;
+}
+
+void psensor_get_current_measure(const struct psensor *s, struct measure *m)
+{
+	const struct measure_columns *c;
+	unsigned int seq;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		c = get_measures(s);
+		measure_columns_get(c, c->size - 1, m);
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+}
+
+void psensor_get_snapshot(const struct psensor *s,
+			  struct psensor_snapshot *snapshot)
+{
+	const struct measure_columns *c;
+	unsigned int seq;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		c = get_measures(s);
+
+		measure_columns_get(c, c->size - 1, &snapshot->current);
+		snapshot->sess_highest = s->sess_highest;
+		snapshot->sess_lowest = s->sess_lowest;
+		snapshot->alarm_raised = s->alarm_raised;
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+}
+
+void psensor_get_measure(const struct psensor *s, int i, struct measure *m)
+{
+	const struct measure_columns *c;
+	unsigned int seq;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		c = get_measures(s);
+
+		/* the history may have been resized since 'i' was computed */
+		if (i < c->size) {
+			measure_columns_get(c, i, m);
+		} else {
+			m->value = UNKNOWN_DBL_VALUE;
+			timerclear(&m->time);
+		}
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+}
+
+/* Returns the first rollup tier covering 'span' or the last one. */
+static int get_rollup_tier(int span)
+{
+	int i;
+
+	for (i = 0; i < PSENSOR_TIERS_COUNT - 1; i++)
+		if (TIERS[i].step * TIERS[i].size >= span)
+			return i;
+
+	return PSENSOR_TIERS_COUNT - 1;
+}
+
+int psensor_get_tier(const struct psensor *s, int span)
+{
+	struct measure oldest, newest;
+
+	if (span <= 0 || !__atomic_load_n(&s->tiers, __ATOMIC_RELAXED))
+		return PSENSOR_TIER_FULL;
+
+	psensor_get_measure(s, 0, &oldest);
+	psensor_get_current_measure(s, &newest);
+
+	if (!oldest.time.tv_sec
+	    || newest.time.tv_sec - oldest.time.tv_sec >= span)
+		return PSENSOR_TIER_FULL;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (s->archive->duration >= span)
+		return PSENSOR_TIER_ARCHIVE;
+#endif
+
+	return get_rollup_tier(span);
+}
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+static int get_archive_length(const struct psensor *s)
+{
+	unsigned int seq;
+	int n;
+
+	do {
+		seq = read_begin(s);
+		n = measure_archive_length(s->archive);
+	} while (read_retry(s, seq));
+
+	return n;
+}
+
+/* Copies into 'm' the i-th measure of the compressed history. */
+static void get_archive_measure(const struct psensor *s,
+				int i,
+				struct measure *m)
+{
+	struct measure_archive_cursor cur;
+	unsigned int seq;
+	int j;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		j = measure_archive_seek(s->archive, i, &cur);
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+
+	if (j >= 0) {
+		measure_archive_cursor_get(&cur, j, m);
+	} else {
+		m->value = UNKNOWN_DBL_VALUE;
+		timerclear(&m->time);
+	}
+}
+#endif
+
+int psensor_get_tier_length(const struct psensor *s, int tier)
+{
+	const struct measure_tier *tiers;
+	unsigned int seq;
+	int n;
+
+	if (tier == PSENSOR_TIER_FULL) {
+		read_enter(s);
+		n = get_measures(s)->size;
+		read_exit(s);
+
+		return n;
+	}
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (tier == PSENSOR_TIER_ARCHIVE)
+		return get_archive_length(s);
+#endif
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		tiers = get_tiers(s);
+
+		if (tiers)
+			n = measure_tier_length(&tiers[tier]);
+		else
+			n = 0;
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+
+	return n;
+}
+
+void psensor_get_rollup(const struct psensor *s,
+			int tier,
+			int i,
+			struct measure_rollup *r)
+{
+	const struct measure_tier *tiers;
+	struct measure m;
+	unsigned int seq;
+
+	if (tier < 0) {
+		psensor_get_tier_measure(s, tier, i, &m);
+		r->min = r->avg = r->max = m.value;
+		r->time = m.time;
+		return;
+	}
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+		tiers = get_tiers(s);
+
+		if (tiers) {
+			measure_tier_get(&tiers[tier], i, r);
+		} else {
+			r->min = r->avg = r->max = UNKNOWN_DBL_VALUE;
+			timerclear(&r->time);
+		}
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+}
+
+void psensor_get_tier_measure(const struct psensor *s,
+			      int tier,
+			      int i,
+			      struct measure *m)
+{
+	struct measure_rollup r;
+
+	if (tier == PSENSOR_TIER_FULL) {
+		psensor_get_measure(s, i, m);
+#ifdef ENABLE_COMPRESSED_HISTORY
+	} else if (tier == PSENSOR_TIER_ARCHIVE) {
+		get_archive_measure(s, i, m);
+#endif
+	} else {
+		psensor_get_rollup(s, tier, i, &r);
+		m->value = r.avg;
+		m->time = r.time;
+	}
+}
+
+void psensor_measure_iter_init(struct psensor_measure_iter *it,
+			       const struct psensor *s,
+			       bool newest_first)
+{
+	psensor_measure_iter_init_tier(it, s, PSENSOR_TIER_FULL, newest_first);
+}
+
+void psensor_measure_iter_init_tier(struct psensor_measure_iter *it,
+				    const struct psensor *s,
+				    int tier,
+				    bool newest_first)
+{
+	it->sensor = s;
+	it->tier = tier;
+	it->chunk_pos = 0;
+	it->chunk_count = 0;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (tier == PSENSOR_TIER_ARCHIVE) {
+		it->pos = -1;
+		it->step = newest_first ? -1 : 1;
+		it->cursor_loaded = false;
+		return;
+	}
+#endif
+
+	/* the position of the newest measure is known by the first load */
+	if (newest_first) {
+		it->pos = INT_MAX;
+		it->step = -1;
+	} else {
+		it->pos = 0;
+		it->step = 1;
+	}
 }
 
-struct measure *psensor_get_current_measure(struct psensor *sensor)
+#ifdef ENABLE_COMPRESSED_HISTORY
+/* Loads the next block of the compressed history to iterate. */
+static bool archive_iter_load(struct psensor_measure_iter *it)
 {
-	return &sensor->measures[sensor->values_max_length - 1];
+	const struct psensor *s = it->sensor;
+	const struct measure_archive *a = s->archive;
+	struct measure_archive_cursor *cur = &it->cursor;
+	const struct measure_block *block;
+	unsigned int seq;
+	uint32_t block_seq;
+	bool ok;
+
+	block = cur->block;
+	block_seq = cur->seq;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+
+		/* restores the position overwritten by a discarded load */
+		cur->block = block;
+		cur->seq = block_seq;
+
+		if (!it->cursor_loaded && it->step > 0)
+			ok = measure_archive_first(a, cur);
+		else if (!it->cursor_loaded)
+			ok = measure_archive_last(a, cur);
+		else if (it->step > 0)
+			ok = measure_archive_next(a, cur);
+		else
+			ok = measure_archive_prev(a, cur);
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+
+	it->cursor_loaded = true;
+
+	if (!ok || !cur->count) {
+		it->step = 0;
+		return false;
+	}
+
+	if (it->step > 0)
+		it->pos = 0;
+	else
+		it->pos = cur->count - 1;
+
+	return true;
 }
 
+static bool archive_iter_next(struct psensor_measure_iter *it,
+			      struct measure *m)
+{
+	if (!it->step)
+		return false;
+
+	if ((it->pos < 0 || it->pos >= it->cursor.count)
+	    && !archive_iter_load(it))
+		return false;
+
+	measure_archive_cursor_get(&it->cursor, it->pos, m);
+
+	it->pos += it->step;
+
+	return true;
+}
+#endif
+
 /*
- * Returns the minimal value of a given 'type' (SENSOR_TYPE_TEMP or
- * SENSOR_TYPE_FAN)
+ * Copies into 'chunk' the measures of the full resolution history or
+ * of a rollup tier from 'it->pos' in the direction of the iteration,
+ * within a single read of the history.
+ *
+ * Returns false if there is no measure at 'it->pos'.
  */
-static double get_min_value(struct psensor **sensors, int type)
+static bool iter_load(struct psensor_measure_iter *it)
+{
+	const struct psensor *s = it->sensor;
+	const struct measure_columns *c;
+	const struct measure_tier *t;
+	struct measure_rollup r;
+	struct measure *m;
+	unsigned int seq;
+	int i, pos, first, n, length;
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+
+		c = NULL;
+		t = NULL;
+		if (it->tier == PSENSOR_TIER_FULL) {
+			c = get_measures(s);
+			length = c->size;
+		} else if (get_tiers(s)) {
+			t = &get_tiers(s)[it->tier];
+			length = measure_tier_length(t);
+		} else {
+			length = 0;
+		}
+
+		pos = it->pos;
+		if (it->step < 0 && pos >= length)
+			pos = length - 1;
+
+		if (it->step > 0) {
+			first = pos;
+			n = length - first;
+		} else {
+			first = pos - PSENSOR_MEASURE_ITER_CHUNK + 1;
+			if (first < 0)
+				first = 0;
+			n = pos - first + 1;
+		}
+
+		if (n > PSENSOR_MEASURE_ITER_CHUNK)
+			n = PSENSOR_MEASURE_ITER_CHUNK;
+
+		for (i = 0; i < n; i++) {
+			m = &it->chunk[i];
+
+			if (c) {
+				measure_columns_get(c, first + i, m);
+			} else {
+				measure_tier_get(t, first + i, &r);
+				m->value = r.avg;
+				m->time = r.time;
+			}
+		}
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+
+	if (n <= 0)
+		return false;
+
+	it->pos = pos;
+	it->chunk_pos = first;
+	it->chunk_count = n;
+
+	return true;
+}
+
+bool psensor_measure_iter_next(struct psensor_measure_iter *it,
+			       struct measure *m)
+{
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (it->tier == PSENSOR_TIER_ARCHIVE)
+		return archive_iter_next(it, m);
+#endif
+
+	if (it->pos < 0)
+		return false;
+
+	if ((it->pos < it->chunk_pos
+	     || it->pos >= it->chunk_pos + it->chunk_count)
+	    && !iter_load(it))
+		return false;
+
+	*m = it->chunk[it->pos - it->chunk_pos];
+
+	it->pos += it->step;
+
+	return true;
+}
+
+void psensor_get_extrema(const struct psensor *s,
+			 int span,
+			 double *min,
+			 double *max)
 {
-	double m = UNKNOWN_DBL_VALUE;
+	const struct measure_tier *tiers;
+	const struct measure_columns *c;
+	unsigned int seq;
+	int tier;
+
+	tier = psensor_get_tier(s, span);
+
+	/* the compressed history does not maintain its extrema */
+	if (tier == PSENSOR_TIER_ARCHIVE)
+		tier = get_rollup_tier(span);
+
+	read_enter(s);
+
+	do {
+		seq = read_begin(s);
+
+		tiers = get_tiers(s);
+
+		if (tier == PSENSOR_TIER_FULL) {
+			c = get_measures(s);
+			*min = measure_columns_get_min(c);
+			*max = measure_columns_get_max(c);
+		} else if (tiers) {
+			*min = measure_tier_get_min(&tiers[tier]);
+			*max = measure_tier_get_max(&tiers[tier]);
+		} else {
+			*min = UNKNOWN_DBL_VALUE;
+			*max = UNKNOWN_DBL_VALUE;
+		}
+	} while (read_retry(s, seq));
+
+	read_exit(s);
+}
+
+double psensor_list_get_min(struct psensor **sensors, int type, int span)
+{
+	double m, t, unused;
 	struct psensor **s = sensors;
 
+	m = UNKNOWN_DBL_VALUE;
 	while (*s) {
 		struct psensor *sensor = *s;
 
 		if (sensor->type & type) {
-			int i;
-			double t;
+			psensor_get_extrema(sensor, span, &t, &unused);
 
-			for (i = 0; i < sensor->values_max_length; i++) {
-				t = sensor->measures[i].value;
-
-				if (t == UNKNOWN_DBL_VALUE)
-					continue;
-
-				if (m == UNKNOWN_DBL_VALUE || t < m)
-					m = t;
-			}
+			if (t != UNKNOWN_DBL_VALUE
+			    && (m == UNKNOWN_DBL_VALUE || t < m))
+				m = t;
 		}
 		s++;
 	}
@@ -313,31 +1330,21 @@ static double get_min_value(struct psensor **sensors, int type)
 	return m;
 }
 
-/*
- * Returns the maximal value of a given 'type' (SENSOR_TYPE_TEMP or
- * SENSOR_TYPE_FAN)
- */
-double get_max_value(struct psensor **sensors, int type)
+double psensor_list_get_max(struct psensor **sensors, int type, int span)
 {
-	double m = UNKNOWN_DBL_VALUE;
+	double m, t, unused;
 	struct psensor **s = sensors;
 
+	m = UNKNOWN_DBL_VALUE;
 	while (*s) {
 		struct psensor *sensor = *s;
 
 		if (sensor->type & type) {
-			int i;
-			double t;
-
-			for (i = 0; i < sensor->values_max_length; i++) {
-				t = sensor->measures[i].value;
-
-				if (t == UNKNOWN_DBL_VALUE)
-					continue;
+			psensor_get_extrema(sensor, span, &unused, &t);
 
-				if (m == UNKNOWN_DBL_VALUE || t > m)
-					m = t;
-			}
+			if (t != UNKNOWN_DBL_VALUE
+			    && (m == UNKNOWN_DBL_VALUE || t > m))
+				m = t;
 		}
 		s++;
 	}
@@ -345,6 +1352,24 @@ double get_max_value(struct psensor **sensors, int type)
 	return m;
 }
 
+/*
+ * Returns the minimal value of a given 'type' (SENSOR_TYPE_TEMP or
+ * SENSOR_TYPE_FAN)
+ */
+static double get_min_value(struct psensor **sensors, int type)
+{
+	return psensor_list_get_min(sensors, type, 0);
+}
+
+/*
+ * Returns the maximal value of a given 'type' (SENSOR_TYPE_TEMP or
+ * SENSOR_TYPE_FAN)
+ */
+double get_max_value(struct psensor **sensors, int type)
+{
+	return psensor_list_get_max(sensors, type, 0);
+}
+
 double get_min_temp(struct psensor **sensors)
 {
 	return get_min_value(sensors, SENSOR_TYPE_TEMP);
@@ -397,6 +1422,15 @@ const char *psensor_type_to_str(unsigned int type)
 	if ((type & SENSOR_TYPE_CPU_USAGE) == SENSOR_TYPE_CPU_USAGE)
 		return "CPU Usage";
 
+	if (type & SENSOR_TYPE_POWER)
+		return "Power";
+
+	if (type & SENSOR_TYPE_FREQ)
+		return "Frequency";
+
+	if (type & SENSOR_TYPE_RATE)
+		return "Throttling";
+
 	if (type & SENSOR_TYPE_TEMP)
 		return "Temperature";
 
@@ -416,18 +1450,47 @@ const char *psensor_type_to_str(unsigned int type)
 }
 
 
+/* Translated units, looked up once instead of at each formatting. */
+static pthread_once_t units_once = PTHREAD_ONCE_INIT;
+static const char *unit_rpm;
+static const char *unit_percent;
+static const char *unit_power;
+static const char *unit_freq;
+static const char *unit_rate;
+static const char *unit_unknown;
+
+static void units_init(void)
+{
+	unit_rpm = _("RPM");
+	unit_percent = _("%");
+	unit_power = _("W");
+	unit_freq = _("MHz");
+	unit_rate = _("/s");
+	unit_unknown = _("N/A");
+}
+
 const char *psensor_type_to_unit_str(unsigned int type, int use_celsius)
 {
 	if (is_temp_type(type)) {
 		if (use_celsius)
 			return "\302\260C";
 		return "\302\260F";
-	} else if (type & SENSOR_TYPE_RPM) {
-		return _("RPM");
-	} else if (type & SENSOR_TYPE_PERCENT) {
-		return _("%");
 	}
-	return _("N/A");
+
+	pthread_once(&units_once, units_init);
+
+	if (type & SENSOR_TYPE_RPM)
+		return unit_rpm;
+	else if (type & SENSOR_TYPE_PERCENT)
+		return unit_percent;
+	else if (type & SENSOR_TYPE_POWER)
+		return unit_power;
+	else if (type & SENSOR_TYPE_FREQ)
+		return unit_freq;
+	else if (type & SENSOR_TYPE_RATE)
+		return unit_rate;
+
+	return unit_unknown;
 }
 
 void psensor_log_measures(struct psensor **sensors)
@@ -467,3 +1530,15 @@ psensor_current_value_to_str(const struct psensor *s, unsigned int use_celsius)
 				    psensor_get_current_value(s),
 				    use_celsius);
 }
+
+char *psensor_current_value_to_buf(const struct psensor *s,
+				   unsigned int use_celsius,
+				   char *buf,
+				   size_t size)
+{
+	return psensor_value_to_buf(s->type,
+				    psensor_get_current_value(s),
+				    use_celsius,
+				    buf,
+				    size);
+}
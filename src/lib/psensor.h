@@ -21,15 +21,28 @@
 
 #include <config.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <bool.h>
 #include <measure.h>
 #include <plog.h>
 
+#ifdef ENABLE_COMPRESSED_HISTORY
+#include <measure_archive.h>
+#endif
+
 enum psensor_type {
 	/* type of sensor values */
 	SENSOR_TYPE_TEMP = 0x00001,
 	SENSOR_TYPE_RPM = 0x00002,
 	SENSOR_TYPE_PERCENT = 0x00004,
+	/* Watts */
+	SENSOR_TYPE_POWER = 0x00010,
+	/* MHz */
+	SENSOR_TYPE_FREQ = 0x00020,
+	/* Events per second */
+	SENSOR_TYPE_RATE = 0x00040,
 
 	/* Whether the sensor is remote */
 	SENSOR_TYPE_REMOTE = 0x00008,
@@ -42,6 +55,11 @@ enum psensor_type {
 	SENSOR_TYPE_ATASMART = 0x01000,
 	SENSOR_TYPE_HDDTEMP = 0x02000,
 	SENSOR_TYPE_UDISKS2 = 0x800000,
+	SENSOR_TYPE_PHONE = 0x1000000,
+	SENSOR_TYPE_HWMON = 0x2000000,
+	SENSOR_TYPE_POWERCAP = 0x4000000,
+	SENSOR_TYPE_CPUFREQ = 0x8000000,
+	SENSOR_TYPE_CPUSTAT = 0x10000000,
 
 	/* Type of HW component */
 	SENSOR_TYPE_HDD = 0x04000,
@@ -60,6 +78,27 @@ enum psensor_type {
 	SENSOR_TYPE_CPU_USAGE = (SENSOR_TYPE_CPU | SENSOR_TYPE_PERCENT)
 };
 
+/* Number of rollup tiers of the history of a sensor. */
+#define PSENSOR_TIERS_COUNT 3
+
+/* Denotes the full resolution history, see psensor_get_tier(). */
+#define PSENSOR_TIER_FULL (-1)
+
+/*
+ * Denotes the compressed full resolution history, only available
+ * when configured with --enable-compressed-history.
+ */
+#define PSENSOR_TIER_ARCHIVE (-2)
+
+/* Duration in seconds of the compressed history */
+#define PSENSOR_ARCHIVE_DURATION (3 * 24 * 3600)
+
+/*
+ * Number of measures kept while the history is disabled: the current
+ * one and the previous one, used by the adaptive sampling.
+ */
+#define PSENSOR_CURRENT_LENGTH 2
+
 struct psensor {
 	/* Human readable name of the sensor.  It may not be uniq. */
 	char *name;
@@ -70,14 +109,42 @@ struct psensor {
 	/* Name of the chip. */
 	char *chip;
 
-	/* Maximum length of 'values' */
+	/* Maximum number of measures kept in 'measures' */
 	int values_max_length;
 
 	/*
-	 * Last registered measures of the sensor.  Index 0 for the
-	 * oldest measure.
+	 * Whether the history is kept, see
+	 * psensor_set_history_enabled().  Without history, 'measures'
+	 * only keeps the last PSENSOR_CURRENT_LENGTH measures and
+	 * 'tiers' is NULL.
+	 */
+	bool history_enabled;
+
+	/*
+	 * Last registered measures of the sensor.  Use
+	 * psensor_get_measure() or a psensor_measure_iter for reading
+	 * them.  Replaced by a new history when resized.
+	 */
+	struct measure_columns *measures;
+
+	/* History replaced by a resize, freed once no longer read */
+	struct measure_columns *retired_measures;
+
+	/*
+	 * Rollups of the measures over periods of increasing
+	 * durations, used for showing durations longer than the one
+	 * covered by 'measures'.  Array of PSENSOR_TIERS_COUNT tiers,
+	 * NULL while the history is disabled.
 	 */
-	struct measure *measures;
+	struct measure_tier *tiers;
+
+	/* Tiers replaced with the history, freed once no longer read */
+	struct measure_tier *retired_tiers;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	/* All the measures of the last PSENSOR_ARCHIVE_DURATION seconds */
+	struct measure_archive *archive;
+#endif
 
 	/* see psensor_type */
 	unsigned int type;
@@ -101,6 +168,13 @@ struct psensor {
 	void (*cb_alarm_raised)(struct psensor *, void *);
 	void *cb_alarm_raised_data;
 
+	/* Measure set in the current batch, see psensor_batch_set() */
+	struct measure batch_measure;
+	bool batch_pending;
+
+	/* Whether the current batch raised the alarm */
+	bool batch_raised;
+
 #ifdef HAVE_LIBATIADL
 	/* AMD id for the aticonfig */
 	int amd_id;
@@ -108,6 +182,38 @@ struct psensor {
 
 	void *provider_data;
 	void (*provider_data_free_fct)(void *);
+
+	/* Next sensor of the same bucket of the index by identifier */
+	struct psensor *index_next;
+
+	/*
+	 * Counter of the updates of the measures, odd while an update
+	 * is in progress.
+	 */
+	unsigned int seq;
+
+	/* Number of threads reading the measures */
+	unsigned int readers;
+};
+
+/*
+ * The measures of a sensor are updated by a single thread at a time
+ * with psensor_set_current_measure() and psensor_values_resize():
+ * their callers serialize the writers of a sensor.  Other
+ * threads read them without lock through the psensor_get_*()
+ * functions, psensor_measure_iter and psensor_list_get_min/max():
+ * each returned measure is consistent but two successive calls may
+ * see different states of the history.
+ */
+
+/* Consistent copy of the current state of a sensor. */
+struct psensor_snapshot {
+	struct measure current;
+
+	double sess_highest;
+	double sess_lowest;
+
+	bool alarm_raised;
 };
 
 struct psensor *psensor_create(char *id,
@@ -116,16 +222,48 @@ struct psensor *psensor_create(char *id,
 			       unsigned int type,
 			       int values_max_length);
 
+/*
+ * Changes the number of measures of the full resolution history.
+ *
+ * Does nothing while the history replaced by a previous resize is
+ * still read by another thread, psensor_values_resize() has then to
+ * be called again later.
+ */
 void psensor_values_resize(struct psensor *s, int new_size);
 
+/*
+ * Enables or disables the history of a sensor, it is disabled when
+ * the sensor is created: only the current measure and the session
+ * extrema are kept until the measures are graphed or served.
+ *
+ * Can be called by any thread, the history is allocated or freed by
+ * the next psensor_set_current_measure() or psensor_batch_commit().
+ * Enabling it keeps the last measures, disabling it frees all the
+ * older ones.
+ */
+void psensor_set_history_enabled(struct psensor *s, bool enabled);
+
 void psensor_free(struct psensor *sensor);
 
 void psensor_list_free(struct psensor **sensors);
 int psensor_list_size(struct psensor **sensors);
 
+/*
+ * Returns the sensor of a list having the given identifier, or NULL.
+ *
+ * The sensors added to a list with psensor_list_add() or
+ * psensor_list_append(), or to a registry, are indexed by identifier
+ * until they are freed, they are found in constant time.  The list
+ * is scanned only for the identifiers which are not indexed.
+ * Identifiers are expected to be unique: for a sublist, the indexed
+ * sensor is returned even if it is not part of the sublist.
+ */
 struct psensor *psensor_list_get_by_id(struct psensor **sensors,
 				       const char *id);
 
+/* Adds a sensor to the index used by psensor_list_get_by_id(). */
+void psensor_index_add(struct psensor *s);
+
 int is_temp_type(unsigned int type);
 
 double get_min_temp(struct psensor **sensors);
@@ -134,11 +272,32 @@ double get_max_temp(struct psensor **sensors);
 double get_min_rpm(struct psensor **sensors);
 double get_max_rpm(struct psensor **sensors);
 
+/*
+ * Size of a buffer large enough for any value formatted by
+ * psensor_value_to_buf.
+ */
+#define PSENSOR_VALUE_STR_SIZE 32
+
+/*
+ * Formats the value of a sensor with its unit into 'buf' of 'size'
+ * bytes, without any allocation.
+ *
+ * Returns 'buf'.
+ */
+char *psensor_value_to_buf(unsigned int type,
+			   double value,
+			   int use_celsius,
+			   char *buf,
+			   size_t size);
+
 /*
  * Converts the value of a sensor to a string.
  *
  * parameter 'type' is SENSOR_TYPE_LMSENSOR_TEMP, SENSOR_TYPE_NVIDIA,
  * or SENSOR_TYPE_LMSENSOR_FAN
+ *
+ * The returned string must be freed, psensor_value_to_buf should be
+ * preferred in the refresh paths.
  */
 char *psensor_value_to_str(unsigned int type,
 			   double value,
@@ -159,9 +318,192 @@ void psensor_set_current_value(struct psensor *sensor, double value);
 void psensor_set_current_measure(struct psensor *sensor, double value,
 				 struct timeval tv);
 
+/*
+ * Raises the alarm of a sensor whatever its current measure, for the
+ * alarms signaled by the hardware.  Calls the alarm callback if the
+ * alarm was not already raised, the next measure within the
+ * thresholds clears it.
+ *
+ * Must be called by the thread updating the measures of the sensor.
+ */
+void psensor_raise_alarm(struct psensor *s);
+
+/*
+ * Batch of the measures of a sampling cycle.
+ *
+ * A provider updating a list of sensors sets their values by index
+ * between psensor_batch_begin() and psensor_batch_commit().  All the
+ * measures get the time of the beginning of the cycle, the session
+ * extrema and the alarms are updated while the measures are added
+ * and the alarm callbacks are called once all of them are added.
+ *
+ * A sensor belongs to a single batch at a time.
+ */
+struct psensor_batch {
+	/* NULL terminated list of the sensors of the cycle */
+	struct psensor **sensors;
+
+	/* Wall clock time of the cycle */
+	struct timeval time;
+
+	/* Time of the cycle in milliseconds of CLOCK_MONOTONIC */
+	int64_t monotonic_time;
+};
+
+/* Starts a cycle updating 'sensors' and takes its time. */
+void psensor_batch_begin(struct psensor_batch *b, struct psensor **sensors);
+
+/* Sets the value of the i-th sensor of the cycle. */
+void psensor_batch_set(struct psensor_batch *b, int i, double v);
+
+/*
+ * Sets the value of the i-th sensor with its own time, for the
+ * measures taken by another computer.
+ */
+void psensor_batch_set_measure(struct psensor_batch *b,
+			       int i,
+			       double v,
+			       struct timeval tv);
+
+/*
+ * Adds the measures set since psensor_batch_begin() to the sensors
+ * and calls the alarm callbacks.  The cycle listeners are notified
+ * by psensor_cycle_end().
+ *
+ * Returns the number of measures added.
+ */
+int psensor_batch_commit(struct psensor_batch *b);
+
+/* Maximal number of cycle listeners */
+#define PSENSOR_CYCLE_LISTENERS_MAX 8
+
+/*
+ * Adds a function called by psensor_cycle_end() at the end of each
+ * sampling cycle adding measures.  Listeners cannot be removed.
+ *
+ * Returns false if there are already PSENSOR_CYCLE_LISTENERS_MAX
+ * listeners.
+ */
+bool psensor_cycle_add_listener(void (*cb)(void *), void *data);
+
+/*
+ * Ends a sampling cycle, called by the sampler once the batches of
+ * all the providers are committed: calls the cycle listeners if
+ * measures were added since the end of the previous cycle.  The
+ * measures of a provider committing after the end of the cycle are
+ * notified with the next one.
+ */
+void psensor_cycle_end(void);
+
 double psensor_get_current_value(const struct psensor *);
 
-struct measure *psensor_get_current_measure(struct psensor *sensor);
+void psensor_get_current_measure(const struct psensor *s, struct measure *m);
+
+void psensor_get_snapshot(const struct psensor *s,
+			  struct psensor_snapshot *snapshot);
+
+/*
+ * Copies into 'm' the measure at position 'i' of the history of the
+ * sensor, 0 being the oldest measure and
+ * psensor_get_tier_length(s, PSENSOR_TIER_FULL) - 1 the most recent
+ * one.
+ */
+void psensor_get_measure(const struct psensor *s, int i, struct measure *m);
+
+/*
+ * Returns the tier to use for showing the measures of the last
+ * 'span' seconds: PSENSOR_TIER_FULL if they are all in the full
+ * resolution history, then PSENSOR_TIER_ARCHIVE if the compressed
+ * history covers 'span', otherwise the first tier covering 'span' or
+ * the last one.  Always PSENSOR_TIER_FULL if the history is disabled.
+ */
+int psensor_get_tier(const struct psensor *s, int span);
+
+/* Returns the number of measures of a tier. */
+int psensor_get_tier_length(const struct psensor *s, int tier);
+
+/*
+ * Copies into 'r' the rollup at position 'i' of a tier, 0 being the
+ * oldest one.  For PSENSOR_TIER_FULL and PSENSOR_TIER_ARCHIVE, the
+ * minimum, the average and the maximum are the value of the i-th
+ * measure.
+ */
+void psensor_get_rollup(const struct psensor *s,
+			int tier,
+			int i,
+			struct measure_rollup *r);
+
+/*
+ * Copies into 'm' the measure at position 'i' of a tier.  For a
+ * rollup tier, the value is the average of the period.
+ */
+void psensor_get_tier_measure(const struct psensor *s,
+			      int tier,
+			      int i,
+			      struct measure *m);
+
+/* Number of measures copied together by a psensor_measure_iter */
+#define PSENSOR_MEASURE_ITER_CHUNK 64
+
+/*
+ * Iterates over the history of a sensor.  The measures are copied
+ * by chunks, each one read with a single access to the history.
+ */
+struct psensor_measure_iter {
+	const struct psensor *sensor;
+	/* see psensor_get_tier() */
+	int tier;
+	/* Position of the next measure, see psensor_get_measure() */
+	int pos;
+	/*
+	 * 1 for oldest to newest, -1 for newest to oldest, 0 once all
+	 * the measures of PSENSOR_TIER_ARCHIVE have been visited.
+	 */
+	int step;
+
+	/* The 'count' measures from the position 'chunk_pos' */
+	struct measure chunk[PSENSOR_MEASURE_ITER_CHUNK];
+	int chunk_pos;
+	int chunk_count;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	/*
+	 * Decoded block of PSENSOR_TIER_ARCHIVE, 'pos' being the
+	 * position in the block.
+	 */
+	struct measure_archive_cursor cursor;
+	bool cursor_loaded;
+#endif
+};
+
+/*
+ * Initializes an iterator over the measures of a sensor, from the
+ * oldest to the newest one, or from the newest to the oldest one if
+ * 'newest_first' is true.
+ */
+void psensor_measure_iter_init(struct psensor_measure_iter *it,
+			       const struct psensor *s,
+			       bool newest_first);
+
+/*
+ * Initializes an iterator over the measures of a tier.  For a
+ * rollup tier, the value of a measure is the average of its period.
+ *
+ * The measures of PSENSOR_TIER_ARCHIVE are decoded block by block,
+ * iterating is much cheaper than calling psensor_get_tier_measure().
+ */
+void psensor_measure_iter_init_tier(struct psensor_measure_iter *it,
+				    const struct psensor *s,
+				    int tier,
+				    bool newest_first);
+
+/*
+ * Copies the next measure into 'm'.
+ *
+ * Returns false when all the measures have been visited.
+ */
+bool psensor_measure_iter_next(struct psensor_measure_iter *it,
+			       struct measure *m);
 
 /* Returns a string representation of a psensor type. */
 const char *psensor_type_to_str(unsigned int type);
@@ -170,8 +512,41 @@ const char *psensor_type_to_unit_str(unsigned int type, int use_celsius);
 
 double get_max_value(struct psensor **sensors, int type);
 
+/*
+ * Copies the minimal and maximal values of a sensor during the last
+ * 'span' seconds, 0 for the whole full resolution history, in
+ * constant time.
+ */
+void psensor_get_extrema(const struct psensor *s,
+			 int span,
+			 double *min,
+			 double *max);
+
+/*
+ * Returns a counter incremented after each measure commit and each
+ * resize of a history: extrema computed when it had the same value
+ * are still up to date.
+ */
+unsigned int psensor_get_measures_generation(void);
+
+/*
+ * Returns the minimal (resp. maximal) value of the sensors of a
+ * given 'type' during the last 'span' seconds, 0 for the whole full
+ * resolution history.
+ *
+ * Each call visits all the sensors, psensor_list_extrema (see
+ * pregistry.h) caches the extrema of all the types of values.
+ */
+double psensor_list_get_min(struct psensor **sensors, int type, int span);
+double psensor_list_get_max(struct psensor **sensors, int type, int span);
+
 char *psensor_current_value_to_str(const struct psensor *, unsigned int);
 
+char *psensor_current_value_to_buf(const struct psensor *,
+				   unsigned int use_celsius,
+				   char *buf,
+				   size_t size);
+
 void psensor_log_measures(struct psensor **sensors);
 
 #endif
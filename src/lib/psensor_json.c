@@ -33,6 +33,21 @@
 #define ATT_SENSOR_MEASURES "measures"
 #define ATT_MEASURE_VALUE "value"
 #define ATT_MEASURE_TIME "time"
+#define ATT_MEASURE_TIME_MS "time_ms"
+#define ATT_MEASURE_MIN "min"
+#define ATT_MEASURE_MAX "max"
+
+/*
+ * Adds the time of a measure in seconds, for the clients of the
+ * previous versions, and in milliseconds.
+ */
+static void add_time(json_object *o, struct measure *m)
+{
+	json_object_object_add(o, ATT_MEASURE_TIME,
+			       json_object_new_int((m->time).tv_sec));
+	json_object_object_add(o, ATT_MEASURE_TIME_MS,
+			       json_object_new_int64(measure_get_time_ms(m)));
+}
 
 static json_object *
 measure_to_json_object(struct measure *m)
@@ -42,32 +57,79 @@ measure_to_json_object(struct measure *m)
 	json_object_object_add(o,
 			       ATT_MEASURE_VALUE,
 			       json_object_new_double(m->value));
-	json_object_object_add(o, ATT_MEASURE_TIME,
-			       json_object_new_int((m->time).tv_sec));
+	add_time(o, m);
+	return o;
+}
+
+static json_object *
+rollup_to_json_object(struct measure_rollup *r)
+{
+	json_object *o = json_object_new_object();
+	struct measure m;
+
+	m.value = r->avg;
+	m.time = r->time;
+
+	json_object_object_add(o,
+			       ATT_MEASURE_VALUE,
+			       json_object_new_double(r->avg));
+	json_object_object_add(o,
+			       ATT_MEASURE_MIN,
+			       json_object_new_double(r->min));
+	json_object_object_add(o,
+			       ATT_MEASURE_MAX,
+			       json_object_new_double(r->max));
+	add_time(o, &m);
 	return o;
 }
 
+/*
+ * Returns the measures covering the last 'span' seconds, taken from
+ * the tier returned by psensor_get_tier().  The measures of a rollup
+ * tier have the additional 'min' and 'max' attributes.
+ */
 static json_object *
-measures_to_json_object(struct psensor *s)
+measures_to_json_object(struct psensor *s, int span)
 {
 	json_object *o;
-	int i;
+	struct measure_rollup r;
+	struct psensor_measure_iter it;
+	struct measure m;
+	int i, n, tier;
 
 	o = json_object_new_array();
 
-	for (i = 0; i < s->values_max_length; i++)
-		if (s->measures[i].time.tv_sec)
-			json_object_array_add
-				(o, measure_to_json_object(&s->measures[i]));
+	tier = psensor_get_tier(s, span);
+
+	/* the full resolution histories are iterated, no rollups */
+	if (tier < 0) {
+		psensor_measure_iter_init_tier(&it, s, tier, false);
+		while (psensor_measure_iter_next(&it, &m))
+			if (m.time.tv_sec)
+				json_object_array_add
+					(o, measure_to_json_object(&m));
 
+		return o;
+	}
+
+	n = psensor_get_tier_length(s, tier);
+
+	for (i = 0; i < n; i++) {
+		psensor_get_rollup(s, tier, i, &r);
+
+		if (r.time.tv_sec)
+			json_object_array_add(o, rollup_to_json_object(&r));
+	}
 
 	return o;
 }
 
-static json_object *sensor_to_json(struct psensor *s)
+static json_object *sensor_to_json(struct psensor *s, int span)
 {
 	json_object *mo, *obj;
-	struct measure *m;
+	struct psensor_snapshot snapshot;
+
+	psensor_get_snapshot(s, &snapshot);
 
 	obj = json_object_new_object();
 
@@ -81,30 +143,28 @@ static json_object *sensor_to_json(struct psensor *s)
 			       ATT_SENSOR_TYPE, json_object_new_int(s->type));
 	json_object_object_add(obj,
 			       ATT_SENSOR_MIN,
-			       json_object_new_double(s->sess_lowest));
+			       json_object_new_double(snapshot.sess_lowest));
 	json_object_object_add(obj,
 			       ATT_SENSOR_MAX,
-			       json_object_new_double(s->sess_highest));
+			       json_object_new_double(snapshot.sess_highest));
 	json_object_object_add(obj,
 			       ATT_SENSOR_MEASURES,
-			       measures_to_json_object(s));
+			       measures_to_json_object(s, span));
 
-	m = psensor_get_current_measure(s);
 	mo = json_object_new_object();
 	json_object_object_add(mo,
 			       ATT_MEASURE_VALUE,
-			       json_object_new_double(m->value));
-	json_object_object_add(mo, ATT_MEASURE_TIME,
-			       json_object_new_int((m->time).tv_sec));
+			       json_object_new_double(snapshot.current.value));
+	add_time(mo, &snapshot.current);
 	json_object_object_add(obj, ATT_SENSOR_LAST_MEASURE, mo);
 
 	return obj;
 }
 
-char *sensor_to_json_string(struct psensor *s)
+char *sensor_to_json_string(struct psensor *s, int span)
 {
 	char *str;
-	json_object *obj = sensor_to_json(s);
+	json_object *obj = sensor_to_json(s, span);
 
 	str = strdup(json_object_to_json_string(obj));
 
@@ -125,7 +185,7 @@ char *sensors_to_json_string(struct psensor **sensors)
 		while (*sensors_cur) {
 			struct psensor *s = *sensors_cur;
 
-			json_object_array_add(obj, sensor_to_json(s));
+			json_object_array_add(obj, sensor_to_json(s, 0));
 
 			sensors_cur++;
 		}
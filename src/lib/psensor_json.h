@@ -29,7 +29,11 @@
 
 #include "psensor.h"
 
-char *sensor_to_json_string(struct psensor *s);
+/*
+ * Returns the json representation of a sensor with its measures of
+ * the last 'span' seconds, 0 for the full resolution history.
+ */
+char *sensor_to_json_string(struct psensor *s, int span);
 char *sensors_to_json_string(struct psensor **sensors);
 
 /*
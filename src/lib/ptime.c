@@ -21,7 +21,7 @@
 
 #include <ptime.h>
 
-const int P_TIME_VER = 3;
+const int P_TIME_VER = 4;
 
 static const int ISO8601_TIME_LENGTH = 19; /* YYYY-MM-DDThh:mm:ss */
 static const int ISO8601_DATE_LENGTH = 10; /* YYYY-MM-DD */
@@ -81,3 +81,12 @@ char *get_current_ISO8601_time(void)
 	t = time(NULL);
 	return time_to_ISO8601_time(&t);
 }
+
+int64_t get_monotonic_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
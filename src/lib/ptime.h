@@ -19,6 +19,7 @@
 #ifndef _P_TIME_H
 #define _P_TIME_H
 
+#include <stdint.h>
 #include <time.h>
 
 extern const int P_TIME_VER;
@@ -31,4 +32,7 @@ char *time_to_ISO8601_date(time_t *);
 char *tm_to_ISO8601_date(struct tm *);
 char *tm_to_ISO8601_time(struct tm *);
 
+/* Returns the time of the monotonic clock in microseconds. */
+int64_t get_monotonic_time_us(void);
+
 #endif
@@ -88,41 +88,41 @@ static void smart_update(struct psensor *s, UDisksDriveAta *ata)
 
 void udisks2_psensor_list_update(struct psensor **sensors)
 {
+	struct psensor_batch b;
 	struct psensor *s;
 	GDBusObject *o;
 	UDisksDriveAta *drive_ata;
 	double v;
 	struct udisks_data *data;
+	int i;
 
-	for (; *sensors; sensors++) {
-		s = *sensors;
+	psensor_batch_begin(&b, sensors);
 
-		if (s->type & SENSOR_TYPE_REMOTE)
-			continue;
+	for (i = 0; sensors[i]; i++) {
+		s = sensors[i];
 
-		if (s->type & SENSOR_TYPE_UDISKS2) {
-			data = (struct udisks_data *)s->provider_data;
+		data = (struct udisks_data *)s->provider_data;
 
-			o = g_dbus_object_manager_get_object(manager,
-							     data->path);
+		o = g_dbus_object_manager_get_object(manager, data->path);
 
-			if (!o)
-				continue;
+		if (!o)
+			continue;
 
-			g_object_get(o, "drive-ata", &drive_ata, NULL);
+		g_object_get(o, "drive-ata", &drive_ata, NULL);
 
-			smart_update(s, drive_ata);
+		smart_update(s, drive_ata);
 
-			v = udisks_drive_ata_get_smart_temperature(drive_ata);
+		v = udisks_drive_ata_get_smart_temperature(drive_ata);
 
-			psensor_set_current_value(s, kelvin_to_celsius(v));
+		psensor_batch_set(&b, i, kelvin_to_celsius(v));
 
-			g_object_unref(G_OBJECT(o));
-		}
+		g_object_unref(G_OBJECT(o));
 	}
+
+	psensor_batch_commit(&b);
 }
 
-void udisks2_psensor_list_append(struct psensor ***sensors, int values_length)
+void udisks2_psensor_list_append(struct psensor_registry *r, int values_length)
 {
 	UDisksClient *client;
 	GList *objects, *cur;
@@ -205,7 +205,7 @@ void udisks2_psensor_list_append(struct psensor ***sensors, int values_length)
 		s->provider_data = data;
 		s->provider_data_free_fct = &udisks_data_free;
 
-		psensor_list_append(sensors, s);
+		psensor_registry_add(r, s);
 
 		g_object_unref(G_OBJECT(cur->data));
 	}
@@ -19,13 +19,14 @@
 #ifndef _PSENSOR_UDISKS2_H_
 #define _PSENSOR_UDISKS2_H_
 
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_LIBUDISKS2) && HAVE_LIBUDISKS2
 
 static inline bool udisks2_is_supported(void) { return true; }
 
-void udisks2_psensor_list_append(struct psensor ***, int);
+void udisks2_psensor_list_append(struct psensor_registry *, int);
 void udisks2_psensor_list_update(struct psensor **);
 
 #else
@@ -33,7 +34,7 @@ void udisks2_psensor_list_update(struct psensor **);
 static inline bool udisks2_is_supported(void) { return false; }
 
 static inline void
-udisks2_psensor_list_append(struct psensor ***s, int n) {}
+udisks2_psensor_list_append(struct psensor_registry *r, int n) {}
 
 static inline void
 udisks2_psensor_list_update(struct psensor **s) {}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <math.h>
+
+#include <sampling.h>
+
+/*
+ * Distance to a threshold, in number of resolutions of the sensor,
+ * below which the sensor is sampled at the highest rate.
+ */
+static const double PROXIMITY = 3;
+
+/* Minimal number of measures before a threshold is reached */
+static const double MEASURES_BEFORE_THRESHOLD = 4;
+
+/* Change of value considered significant between two measures. */
+static double get_resolution(unsigned int type)
+{
+	if (type & SENSOR_TYPE_TEMP)
+		return 1;
+
+	if (type & SENSOR_TYPE_RPM)
+		return 100;
+
+	if (type & SENSOR_TYPE_PERCENT)
+		return 5;
+
+	if (type & SENSOR_TYPE_POWER)
+		return 1;
+
+	if (type & SENSOR_TYPE_FREQ)
+		return 100;
+
+	if (type & SENSOR_TYPE_RATE)
+		return 1;
+
+	return 1;
+}
+
+static int64_t tv_to_ms(struct timeval tv)
+{
+	return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+int sampling_next_interval(const struct psensor *s,
+			   int interval,
+			   int min,
+			   int max)
+{
+	struct measure last, prev;
+	double res, rate, dist;
+	int64_t dt;
+	bool thresholds;
+	int n;
+
+	n = psensor_get_tier_length(s, PSENSOR_TIER_FULL);
+
+	if (s->alarm_raised || n < 2)
+		return min;
+
+	psensor_get_measure(s, n - 1, &last);
+	psensor_get_measure(s, n - 2, &prev);
+
+	if (last.value == UNKNOWN_DBL_VALUE || prev.value == UNKNOWN_DBL_VALUE)
+		return min;
+
+	dt = tv_to_ms(last.time) - tv_to_ms(prev.time);
+	if (dt <= 0)
+		return min;
+
+	res = get_resolution(s->type);
+
+	/* Change of value per millisecond */
+	rate = (last.value - prev.value) / dt;
+
+	thresholds = s->alarm_high_threshold > s->alarm_low_threshold;
+	if (thresholds) {
+		dist = s->alarm_high_threshold - last.value;
+		if (last.value - s->alarm_low_threshold < dist)
+			dist = last.value - s->alarm_low_threshold;
+
+		if (dist < PROXIMITY * res)
+			return min;
+	}
+
+	if (fabs(rate) * interval > res)
+		interval /= 2;
+	else if (fabs(rate) * interval < res / 4)
+		interval += interval / 2;
+
+	if (thresholds && rate) {
+		if (rate > 0)
+			dist = s->alarm_high_threshold - last.value;
+		else
+			dist = last.value - s->alarm_low_threshold;
+
+		dist /= fabs(rate) * MEASURES_BEFORE_THRESHOLD;
+
+		if (dist < interval)
+			interval = dist;
+	}
+
+	if (interval < min)
+		return min;
+
+	if (interval > max)
+		return max;
+
+	return interval;
+}
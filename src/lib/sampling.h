@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_SAMPLING_H_
+#define _PSENSOR_SAMPLING_H_
+
+#include <psensor.h>
+
+/*
+ * Adaptive sampling: the interval of a sensor shrinks when its value
+ * changes quickly or gets close to an alarm threshold and grows back
+ * when it is stable.
+ */
+
+/*
+ * Returns the interval in milliseconds until the next measure of
+ * 's', between 'min' and 'max', 'interval' being the current one.
+ *
+ * The decision is based on the last two measures of the history and
+ * on the alarm thresholds:
+ * - 'min' if the alarm is raised, a measure is unknown or the value
+ *   is close to a threshold,
+ * - halved if the expected change during the interval is
+ *   significant for the type of the sensor, increased by half if it
+ *   is negligible,
+ * - short enough to take several measures before a threshold is
+ *   reached at the current rate of change.
+ */
+int sampling_next_interval(const struct psensor *s,
+			   int interval,
+			   int min,
+			   int max);
+
+#endif
@@ -34,7 +34,6 @@
 #include "bool.h"
 #include "config.h"
 #include <plog.h>
-#include <pmutex.h>
 #include "ptime.h"
 #include "slog.h"
 
@@ -42,10 +41,19 @@ static FILE *file;
 static double *last_values;
 static int period;
 static struct psensor **sensors;
-static pthread_mutex_t *sensors_mutex;
+/* number of sensors, the list does not change once logging started */
+static int sensors_count;
 static pthread_t thread;
 static time_t st;
 
+/*
+ * Number of sampling cycles and its value at the last write, nothing
+ * is written if it is unchanged.
+ */
+static bool listening;
+static unsigned int cycles;
+static unsigned int logged_cycles;
+
 static const char *DEFAULT_FILENAME = "sensors.log";
 
 static char *time_to_str(time_t *t)
@@ -125,21 +133,33 @@ static bool slog_open(const char *path, struct psensor **sensors)
 	return 1;
 }
 
+static void on_cycle_end(void *data)
+{
+	__atomic_add_fetch(&cycles, 1, __ATOMIC_RELAXED);
+}
+
 static void slog_write_sensors(struct psensor **sensors)
 {
 	int count, i;
 	double v;
 	struct timeval tv;
+	long int ms;
 	bool first_call;
+	unsigned int n;
 
 	if (!file) {
 		log_debug(_("Sensor log file not open."));
 		return;
 	}
 
+	n = __atomic_load_n(&cycles, __ATOMIC_RELAXED);
+	if (listening && last_values && n == logged_cycles)
+		return;
+	logged_cycles = n;
+
 	gettimeofday(&tv, NULL);
 
-	count = psensor_list_size(sensors);
+	count = sensors_count;
 
 	if (last_values) {
 		first_call = 0;
@@ -148,7 +168,10 @@ static void slog_write_sensors(struct psensor **sensors)
 		last_values = malloc(count * sizeof(double));
 	}
 
-	fprintf(file, "%ld", (long int)(tv.tv_sec - st));
+	/* milliseconds elapsed since the start of the log */
+	ms = (long int)(tv.tv_sec - st) * 1000 + tv.tv_usec / 1000;
+
+	fprintf(file, "%ld.%03ld", ms / 1000, ms % 1000);
 	for (i = 0; i < count; i++) {
 		v = psensor_get_current_value(sensors[i]);
 
@@ -169,9 +192,7 @@ static void *slog_routine(void *data)
 {
 	while (1) {
 		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-		pmutex_lock(sensors_mutex);
 		slog_write_sensors(sensors);
-		pmutex_unlock(sensors_mutex);
 		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 		sleep(period);
 	}
@@ -193,20 +214,18 @@ void slog_close(void)
 	}
 }
 
-bool slog_activate(const char *path,
-		   struct psensor **ss,
-		   pthread_mutex_t *mutex,
-		   int p)
+bool slog_activate(const char *path, struct psensor **ss, int p)
 {
 	bool ret;
 
 	sensors = ss;
-	sensors_mutex = mutex;
+	sensors_count = psensor_list_size(ss);
 	period = p;
 
-	pthread_mutex_lock(mutex);
+	if (!listening)
+		listening = psensor_cycle_add_listener(on_cycle_end, NULL);
+
 	ret = slog_open(path, sensors);
-	pthread_mutex_unlock(mutex);
 
 	if (ret)
 		pthread_create(&thread, NULL, slog_routine, NULL);
@@ -23,7 +23,11 @@
 
 #include "psensor.h"
 
-bool slog_activate(const char *, struct psensor **, pthread_mutex_t *, int s);
+/*
+ * Starts logging the measures of 'sensors' every 'period' seconds.
+ * The measures are read without lock, see psensor_get_snapshot().
+ */
+bool slog_activate(const char *path, struct psensor **sensors, int period);
 void slog_close(void);
 
 #endif
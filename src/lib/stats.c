@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <math.h>
+#include <pthread.h>
+
+#include <stats.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#endif
+
+struct kernels {
+	double (*min)(const measure_value_t *values, int n);
+	double (*max)(const measure_value_t *values, int n);
+	double (*sum)(const measure_value_t *values, int n, int *count);
+};
+
+static double from_column_value(measure_value_t v)
+{
+	if (v == UNKNOWN_MEASURE_VALUE)
+		return UNKNOWN_DBL_VALUE;
+
+	return v;
+}
+
+static double scalar_min(const measure_value_t *values, int n)
+{
+	measure_value_t v, m;
+	int i;
+
+	m = UNKNOWN_MEASURE_VALUE;
+	for (i = 0; i < n; i++) {
+		v = values[i];
+
+		if (v != UNKNOWN_MEASURE_VALUE
+		    && (m == UNKNOWN_MEASURE_VALUE || v < m))
+			m = v;
+	}
+
+	return from_column_value(m);
+}
+
+static double scalar_max(const measure_value_t *values, int n)
+{
+	measure_value_t v, m;
+	int i;
+
+	m = UNKNOWN_MEASURE_VALUE;
+	for (i = 0; i < n; i++) {
+		v = values[i];
+
+		if (v != UNKNOWN_MEASURE_VALUE
+		    && (m == UNKNOWN_MEASURE_VALUE || v > m))
+			m = v;
+	}
+
+	return from_column_value(m);
+}
+
+static double scalar_sum(const measure_value_t *values, int n, int *count)
+{
+	double s;
+	int i;
+
+	s = 0;
+	*count = 0;
+	for (i = 0; i < n; i++)
+		if (values[i] != UNKNOWN_MEASURE_VALUE) {
+			s += values[i];
+			(*count)++;
+		}
+
+	return s;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * The kernels are instantiated from stats_kernels.h for SSE2 with
+ * vectors of 16 bytes and for AVX2 with vectors of 32 bytes.
+ */
+#include <immintrin.h>
+
+#ifdef ENABLE_FLOAT_MEASURES
+
+#define vec_t __m128
+#define LANES 4
+#define VLOAD _mm_loadu_ps
+#define VSTORE _mm_storeu_ps
+#define VSET1 _mm_set1_ps
+#define VNEQ _mm_cmpneq_ps
+#define VAND _mm_and_ps
+#define VANDNOT _mm_andnot_ps
+#define VOR _mm_or_ps
+#define VMIN _mm_min_ps
+#define VMAX _mm_max_ps
+
+#define svec_t __m128d
+#define SLANES 2
+#define SLOAD(p) \
+	_mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)(p))))
+
+#else
+
+#define vec_t __m128d
+#define LANES 2
+#define VLOAD _mm_loadu_pd
+#define VSTORE _mm_storeu_pd
+#define VSET1 _mm_set1_pd
+#define VNEQ _mm_cmpneq_pd
+#define VAND _mm_and_pd
+#define VANDNOT _mm_andnot_pd
+#define VOR _mm_or_pd
+#define VMIN _mm_min_pd
+#define VMAX _mm_max_pd
+
+#define svec_t __m128d
+#define SLANES 2
+#define SLOAD _mm_loadu_pd
+
+#endif
+
+#define SSTORE _mm_storeu_pd
+#define SSET1 _mm_set1_pd
+#define SNEQ _mm_cmpneq_pd
+#define SAND _mm_and_pd
+#define SADD _mm_add_pd
+
+#define TARGET "sse2"
+#define KERNEL(name) sse2_##name
+#include <stats_kernels.h>
+
+#undef vec_t
+#undef LANES
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VNEQ
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VMIN
+#undef VMAX
+#undef svec_t
+#undef SLANES
+#undef SLOAD
+#undef SSTORE
+#undef SSET1
+#undef SNEQ
+#undef SAND
+#undef SADD
+#undef TARGET
+#undef KERNEL
+
+#ifdef ENABLE_FLOAT_MEASURES
+
+#define vec_t __m256
+#define LANES 8
+#define VLOAD _mm256_loadu_ps
+#define VSTORE _mm256_storeu_ps
+#define VSET1 _mm256_set1_ps
+#define VNEQ(a, b) _mm256_cmp_ps((a), (b), _CMP_NEQ_UQ)
+#define VAND _mm256_and_ps
+#define VANDNOT _mm256_andnot_ps
+#define VOR _mm256_or_ps
+#define VMIN _mm256_min_ps
+#define VMAX _mm256_max_ps
+
+#define svec_t __m256d
+#define SLANES 4
+#define SLOAD(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+
+#else
+
+#define vec_t __m256d
+#define LANES 4
+#define VLOAD _mm256_loadu_pd
+#define VSTORE _mm256_storeu_pd
+#define VSET1 _mm256_set1_pd
+#define VNEQ(a, b) _mm256_cmp_pd((a), (b), _CMP_NEQ_UQ)
+#define VAND _mm256_and_pd
+#define VANDNOT _mm256_andnot_pd
+#define VOR _mm256_or_pd
+#define VMIN _mm256_min_pd
+#define VMAX _mm256_max_pd
+
+#define svec_t __m256d
+#define SLANES 4
+#define SLOAD _mm256_loadu_pd
+
+#endif
+
+#define SSTORE _mm256_storeu_pd
+#define SSET1 _mm256_set1_pd
+#define SNEQ(a, b) _mm256_cmp_pd((a), (b), _CMP_NEQ_UQ)
+#define SAND _mm256_and_pd
+#define SADD _mm256_add_pd
+
+#define TARGET "avx2"
+#define KERNEL(name) avx2_##name
+#include <stats_kernels.h>
+
+#endif
+
+static const struct kernels KERNELS[] = {
+	[STATS_ISA_SCALAR] = {scalar_min, scalar_max, scalar_sum},
+#ifdef HAVE_X86_KERNELS
+	[STATS_ISA_SSE2] = {sse2_min, sse2_max, sse2_sum},
+	[STATS_ISA_AVX2] = {avx2_min, avx2_max, avx2_sum},
+#endif
+};
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static enum stats_isa kernels_isa;
+
+static bool is_isa_supported(enum stats_isa isa)
+{
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init();
+
+	switch (isa) {
+	case STATS_ISA_SCALAR:
+		return true;
+	case STATS_ISA_SSE2:
+		return !!__builtin_cpu_supports("sse2");
+	case STATS_ISA_AVX2:
+		return !!__builtin_cpu_supports("avx2");
+	}
+
+	return false;
+#else
+	return isa == STATS_ISA_SCALAR;
+#endif
+}
+
+static bool set_isa(enum stats_isa isa)
+{
+	if (!is_isa_supported(isa))
+		return false;
+
+	__atomic_store_n(&kernels_isa, isa, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+static void kernels_init(void)
+{
+	if (!set_isa(STATS_ISA_AVX2) && !set_isa(STATS_ISA_SSE2))
+		set_isa(STATS_ISA_SCALAR);
+}
+
+static const struct kernels *get_kernels(void)
+{
+	pthread_once(&kernels_once, kernels_init);
+
+	return &KERNELS[__atomic_load_n(&kernels_isa, __ATOMIC_RELAXED)];
+}
+
+bool stats_select_isa(enum stats_isa isa)
+{
+	pthread_once(&kernels_once, kernels_init);
+
+	return set_isa(isa);
+}
+
+enum stats_isa stats_get_isa(void)
+{
+	pthread_once(&kernels_once, kernels_init);
+
+	return __atomic_load_n(&kernels_isa, __ATOMIC_RELAXED);
+}
+
+double stats_min(const measure_value_t *values, int n)
+{
+	return get_kernels()->min(values, n);
+}
+
+double stats_max(const measure_value_t *values, int n)
+{
+	return get_kernels()->max(values, n);
+}
+
+double stats_sum(const measure_value_t *values, int n, int *count)
+{
+	return get_kernels()->sum(values, n, count);
+}
+
+double stats_mean(const measure_value_t *values, int n)
+{
+	double s;
+	int count;
+
+	s = stats_sum(values, n, &count);
+
+	if (!count)
+		return UNKNOWN_DBL_VALUE;
+
+	return s / count;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_STATS_H_
+#define _PSENSOR_STATS_H_
+
+#include <bool.h>
+#include <measure.h>
+
+/*
+ * Statistics over columns of measure values, UNKNOWN_MEASURE_VALUE
+ * values being ignored.
+ *
+ * The kernels are vectorized for SSE2 and AVX2 on x86, the best one
+ * supported by the CPU is selected at the first call.
+ */
+
+enum stats_isa {
+	STATS_ISA_SCALAR,
+	STATS_ISA_SSE2,
+	STATS_ISA_AVX2
+};
+
+/*
+ * Selects the kernels to use, mostly for testing and benchmarking.
+ *
+ * Returns false if 'isa' is not supported by the CPU.
+ */
+bool stats_select_isa(enum stats_isa isa);
+
+/* Returns the kernels in use. */
+enum stats_isa stats_get_isa(void);
+
+/*
+ * Returns the minimal (resp. maximal) known value of 'values' or
+ * UNKNOWN_DBL_VALUE if there is none.
+ */
+double stats_min(const measure_value_t *values, int n);
+double stats_max(const measure_value_t *values, int n);
+
+/*
+ * Returns the sum of the known values of 'values' and sets 'count'
+ * to their number.
+ */
+double stats_sum(const measure_value_t *values, int n, int *count);
+
+/* Returns the mean of the known values or UNKNOWN_DBL_VALUE. */
+double stats_mean(const measure_value_t *values, int n);
+
+#endif
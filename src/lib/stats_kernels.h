@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * Vectorized kernels of stats.c, included once for each instruction
+ * set with the following macros defined:
+ *
+ * KERNEL(name): name of the kernel for the instruction set
+ * TARGET: GCC target of the instruction set
+ * vec_t, LANES: type of the vectors and their number of values
+ * VLOAD(p), VSTORE(p, v): unaligned load and store
+ * VSET1(x): vector whose values are all 'x'
+ * VNEQ(a, b): mask of the lanes where 'a' and 'b' differ
+ * VAND, VANDNOT, VOR: bitwise operations, VANDNOT(a, b) is ~a & b
+ * VMIN, VMAX: arithmetic operations
+ *
+ * The sums are accumulated in vectors of doubles, as in scalar_sum(),
+ * whatever the type of the measures:
+ *
+ * svec_t, SLANES: type of these vectors and their number of values
+ * SLOAD(p): load of SLANES measures, converted to doubles
+ * SSTORE, SSET1, SNEQ, SAND: as their V* counterparts
+ * SADD: addition
+ *
+ * The lanes of the unknown values are replaced through a mask by a
+ * neutral value instead of being tested one by one.  Two vectors are
+ * processed at each iteration to shorten the dependency chains.
+ */
+
+/* Lanes of 'a' where 'm' is set, lanes of 'b' elsewhere */
+#define VSELECT(m, a, b) VOR(VAND((m), (a)), VANDNOT((m), (b)))
+
+__attribute__((target(TARGET)))
+static double KERNEL(min)(const measure_value_t *values, int n)
+{
+	vec_t acc0, acc1, v0, v1, unknown, inf;
+	measure_value_t lanes[LANES], m;
+	int i;
+
+	unknown = VSET1(UNKNOWN_MEASURE_VALUE);
+	inf = VSET1((measure_value_t)HUGE_VAL);
+	acc0 = inf;
+	acc1 = inf;
+
+	for (i = 0; i + 2 * LANES <= n; i += 2 * LANES) {
+		v0 = VLOAD(values + i);
+		v1 = VLOAD(values + i + LANES);
+
+		acc0 = VMIN(VSELECT(VNEQ(v0, unknown), v0, inf), acc0);
+		acc1 = VMIN(VSELECT(VNEQ(v1, unknown), v1, inf), acc1);
+	}
+
+	VSTORE(lanes, VMIN(acc0, acc1));
+
+	m = HUGE_VAL;
+	for (n -= i, values += i, i = 0; i < LANES; i++)
+		if (lanes[i] < m)
+			m = lanes[i];
+
+	for (i = 0; i < n; i++)
+		if (values[i] != UNKNOWN_MEASURE_VALUE && values[i] < m)
+			m = values[i];
+
+	if (m == (measure_value_t)HUGE_VAL)
+		return UNKNOWN_DBL_VALUE;
+
+	return m;
+}
+
+__attribute__((target(TARGET)))
+static double KERNEL(max)(const measure_value_t *values, int n)
+{
+	vec_t acc0, acc1, v0, v1, unknown, inf;
+	measure_value_t lanes[LANES], m;
+	int i;
+
+	unknown = VSET1(UNKNOWN_MEASURE_VALUE);
+	inf = VSET1(-(measure_value_t)HUGE_VAL);
+	acc0 = inf;
+	acc1 = inf;
+
+	for (i = 0; i + 2 * LANES <= n; i += 2 * LANES) {
+		v0 = VLOAD(values + i);
+		v1 = VLOAD(values + i + LANES);
+
+		acc0 = VMAX(VSELECT(VNEQ(v0, unknown), v0, inf), acc0);
+		acc1 = VMAX(VSELECT(VNEQ(v1, unknown), v1, inf), acc1);
+	}
+
+	VSTORE(lanes, VMAX(acc0, acc1));
+
+	m = -HUGE_VAL;
+	for (n -= i, values += i, i = 0; i < LANES; i++)
+		if (lanes[i] > m)
+			m = lanes[i];
+
+	for (i = 0; i < n; i++)
+		if (values[i] != UNKNOWN_MEASURE_VALUE && values[i] > m)
+			m = values[i];
+
+	if (m == -(measure_value_t)HUGE_VAL)
+		return UNKNOWN_DBL_VALUE;
+
+	return m;
+}
+
+__attribute__((target(TARGET)))
+static double KERNEL(sum)(const measure_value_t *values, int n, int *count)
+{
+	svec_t sum0, sum1, cnt0, cnt1, v0, v1, k0, k1, unknown, one, zero;
+	double sums[SLANES], cnts[SLANES], s;
+	int i;
+
+	unknown = SSET1(UNKNOWN_MEASURE_VALUE);
+	one = SSET1(1);
+	zero = SSET1(0);
+	sum0 = zero;
+	sum1 = zero;
+	cnt0 = zero;
+	cnt1 = zero;
+
+	for (i = 0; i + 2 * SLANES <= n; i += 2 * SLANES) {
+		v0 = SLOAD(values + i);
+		v1 = SLOAD(values + i + SLANES);
+		k0 = SNEQ(v0, unknown);
+		k1 = SNEQ(v1, unknown);
+
+		sum0 = SADD(sum0, SAND(k0, v0));
+		sum1 = SADD(sum1, SAND(k1, v1));
+		cnt0 = SADD(cnt0, SAND(k0, one));
+		cnt1 = SADD(cnt1, SAND(k1, one));
+	}
+
+	SSTORE(sums, SADD(sum0, sum1));
+	SSTORE(cnts, SADD(cnt0, cnt1));
+
+	s = 0;
+	*count = 0;
+	for (n -= i, values += i, i = 0; i < SLANES; i++) {
+		s += sums[i];
+		*count += cnts[i];
+	}
+
+	for (i = 0; i < n; i++)
+		if (values[i] != UNKNOWN_MEASURE_VALUE) {
+			s += values[i];
+			(*count)++;
+		}
+
+	return s;
+}
+
+#undef VSELECT
@@ -32,17 +32,24 @@
 
 #include <amd.h>
 #include <cfg.h>
+#include <cpufreq.h>
+#include <cpustat.h>
 #include <graph.h>
 #include <hdd.h>
+#include <hwmon.h>
 #include <lmsensor.h>
 #include <notify_cmd.h>
 #include <nvidia.h>
 #include <pgtop2.h>
 #include <phone_sensor.h>
 #include <pmutex.h>
+#include <powercap.h>
+#include <ppool.h>
+#include <psched.h>
 #include <psensor.h>
 #include <pudisks2.h>
 #include <rsensor.h>
+#include <sampling.h>
 #include <slog.h>
 #include <ui.h>
 #include <ui_appindicator.h>
@@ -99,30 +106,486 @@ static void print_help(void)
 	printf(_("%s home page: <%s>\n"), PACKAGE_NAME, PACKAGE_URL);
 }
 
+/* Update function of each provider, see enum psensor_provider */
+static void (*const PROVIDER_UPDATES[PSENSOR_PROVIDERS_COUNT])
+	(struct psensor **) = {
+	[PSENSOR_PROVIDER_REMOTE] = remote_psensor_list_update,
+	[PSENSOR_PROVIDER_LMSENSOR] = lmsensor_psensor_list_update,
+	[PSENSOR_PROVIDER_NVCTRL] = nvidia_psensor_list_update,
+	[PSENSOR_PROVIDER_GTOP] = gtop2_psensor_list_update,
+	[PSENSOR_PROVIDER_ATIADL] = amd_psensor_list_update,
+	[PSENSOR_PROVIDER_ATASMART] = atasmart_psensor_list_update,
+	[PSENSOR_PROVIDER_HDDTEMP] = hddtemp_psensor_list_update,
+	[PSENSOR_PROVIDER_UDISKS2] = udisks2_psensor_list_update,
+	[PSENSOR_PROVIDER_PHONE] = phone_sensor_psensor_list_update,
+	[PSENSOR_PROVIDER_HWMON] = hwmon_psensor_list_update,
+	[PSENSOR_PROVIDER_POWERCAP] = powercap_psensor_list_update,
+	[PSENSOR_PROVIDER_CPUFREQ] = cpufreq_psensor_list_update,
+	[PSENSOR_PROVIDER_CPUSTAT] = cpustat_psensor_list_update
+};
+
+/* Adaptive sampling state of a sensor, see sampling.h */
+struct sampling_state {
+	/* Interval in milliseconds */
+	int interval;
+
+	/* Time of the next measure */
+	int64_t deadline;
+
+	/* Number of measures since the last report */
+	unsigned int samples;
+
+	/* Whether it is updated by the current run of the job */
+	bool due;
+};
+
+/* Sensors of a provider updated together at the same interval. */
+struct sampling_job {
+	enum psensor_provider provider;
+
+	/* NULL terminated list of the sensors */
+	struct psensor **sensors;
+
+	/* Interval in milliseconds, 0 for sensor_update_interval */
+	int interval;
+
+	struct psched_task *task;
+
+	/* Run of the update by a thread of the pool */
+	struct ppool_job work;
+
+	/* Number of missed deadlines already logged */
+	unsigned int overruns;
+
+	/*
+	 * Active set: whether each sensor is enabled in the preferences,
+	 * changed by the main thread.  The disabled sensors are not
+	 * updated.
+	 */
+	bool *enabled;
+
+	/* State of each sensor if the adaptive sampling is enabled */
+	struct sampling_state *states;
+
+	/* Buffer of the NULL terminated list of the sensors to update */
+	struct psensor **due;
+
+	/*
+	 * Deadline and interval of the task at the last submission, the
+	 * shortest adaptive interval.  Atomic because a submission may
+	 * fail while the job is running.
+	 */
+	int64_t tick;
+	int min_interval;
+
+	/* Time of the last report of the adaptive sampling rates */
+	int64_t report_time;
+};
+
+/* Longest adaptive interval in milliseconds */
+static int adaptive_max_interval;
+
+/* Period of the reports of the adaptive sampling rates, 5 minutes */
+#define SAMPLING_REPORT_INTERVAL 300000
+
+/* Maximal number of threads updating the sensors concurrently */
+#define SAMPLING_THREADS_MAX 4
+
+/*
+ * Scheduler of the updates of the sensors, created by the main
+ * thread because the configuration of the sensors is not thread-safe
+ * and then owned by the thread executing update_measures().
+ */
+static struct psched sampler;
+static struct sampling_job *jobs;
+static int jobs_count;
+
+/*
+ * The jobs run concurrently on a pool of threads, except the jobs of
+ * a same provider because the providers rely on global states.
+ */
+static struct ppool workers;
+static bool workers_started;
+static pthread_mutex_t provider_mutexes[PSENSOR_PROVIDERS_COUNT];
+
 /*
  * Updates the size of the sensor values if different than the
- * configuration.
+ * configuration.  A job which missed its deadline may still be
+ * updating the sensors, the resize holds the mutex of the provider
+ * to not interleave with it.
  */
-static void
-update_psensor_values_size(struct psensor **sensors, struct config *cfg)
+static void update_psensor_values_size(struct config *cfg)
+{
+	struct sampling_job *j;
+	struct psensor **cur;
+	int i, length;
+
+	length = cfg->sensor_values_max_length;
+
+	for (i = 0, j = jobs; i < jobs_count; i++, j++) {
+		for (cur = j->sensors; *cur; cur++)
+			if ((*cur)->values_max_length != length)
+				break;
+
+		if (!*cur)
+			continue;
+
+		pthread_mutex_lock(&provider_mutexes[j->provider]);
+
+		for (; *cur; cur++)
+			if ((*cur)->values_max_length != length)
+				psensor_values_resize(*cur, length);
+
+		pthread_mutex_unlock(&provider_mutexes[j->provider]);
+	}
+}
+
+/* Logs the effective sampling rate of each sensor of a job. */
+static void report_sampling_rates(struct sampling_job *j, int64_t now)
+{
+	struct sampling_state *st;
+	double elapsed;
+	int i;
+
+	elapsed = (now - j->report_time) / 1000.0;
+
+	for (i = 0; j->sensors[i]; i++) {
+		st = &j->states[i];
+
+		if (!__atomic_load_n(&j->enabled[i], __ATOMIC_RELAXED))
+			continue;
+
+		log_info(_("Sampling of %s: %.3f measures/s, "
+			   "%d ms interval (%.3f measures/s at most)."),
+			 j->sensors[i]->id,
+			 st->samples / elapsed,
+			 st->interval,
+			 1000.0 / j->min_interval);
+
+		st->samples = 0;
+	}
+
+	j->report_time = now;
+}
+
+/* Computes the next interval of the sensors just updated. */
+static void update_adaptive_intervals(struct sampling_job *j, int64_t tick)
+{
+	struct sampling_state *st;
+	int i, min;
+
+	min = __atomic_load_n(&j->min_interval, __ATOMIC_RELAXED);
+
+	for (i = 0; j->sensors[i]; i++) {
+		st = &j->states[i];
+
+		if (!st->due)
+			continue;
+
+		st->interval = sampling_next_interval(j->sensors[i],
+						      st->interval,
+						      min,
+						      adaptive_max_interval);
+		st->deadline = tick + st->interval;
+		st->samples++;
+	}
+
+	if (!j->report_time)
+		j->report_time = tick;
+	else if (tick - j->report_time >= SAMPLING_REPORT_INTERVAL)
+		report_sampling_rates(j, tick);
+}
+
+/*
+ * Updates the enabled sensors of a job, only the ones whose adaptive
+ * deadline is reached if the adaptive sampling is enabled.
+ */
+static void run_job(void *data)
+{
+	struct sampling_job *j;
+	struct sampling_state *st;
+	int64_t tick;
+	int i, n;
+	bool enabled;
+
+	j = (struct sampling_job *)data;
+
+	tick = __atomic_load_n(&j->tick, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&provider_mutexes[j->provider]);
+
+	for (i = 0, n = 0; j->sensors[i]; i++) {
+		enabled = __atomic_load_n(&j->enabled[i], __ATOMIC_RELAXED);
+
+		if (j->states) {
+			st = &j->states[i];
+			st->due = enabled && st->deadline <= tick;
+
+			if (!st->due)
+				continue;
+		} else if (!enabled) {
+			continue;
+		}
+
+		j->due[n++] = j->sensors[i];
+	}
+	j->due[n] = NULL;
+
+	if (n)
+		PROVIDER_UPDATES[j->provider](j->due);
+
+	if (j->states)
+		update_adaptive_intervals(j, tick);
+
+	pthread_mutex_unlock(&provider_mutexes[j->provider]);
+}
+
+static void submit_job(void *data)
 {
-	struct psensor **cur, *s;
+	struct sampling_job *j;
 
-	for (cur = sensors; *cur; cur++) {
-		s = *cur;
+	j = (struct sampling_job *)data;
 
-		if (s->values_max_length != cfg->sensor_values_max_length)
-			psensor_values_resize(s,
-					      cfg->sensor_values_max_length);
+	if (j->states) {
+		__atomic_store_n(&j->tick, j->task->deadline, __ATOMIC_RELAXED);
+		__atomic_store_n(&j->min_interval,
+				 j->task->interval,
+				 __ATOMIC_RELAXED);
 	}
+
+	if (!workers_started)
+		run_job(j);
+	else if (!ppool_submit(&workers, &j->work))
+		j->task->overruns++;
+}
+
+static void add_job(enum psensor_provider p,
+		    struct psensor **sensors,
+		    int n,
+		    int interval,
+		    bool adaptive)
+{
+	struct sampling_job *j;
+	int i;
+
+	j = &jobs[jobs_count];
+	j->provider = p;
+	j->sensors = sensors;
+	j->interval = interval;
+	j->overruns = 0;
+	j->tick = 0;
+	j->min_interval = 0;
+	j->report_time = 0;
+
+	j->enabled = malloc(n * sizeof(bool));
+	for (i = 0; i < n; i++)
+		j->enabled[i] = config_is_sensor_enabled(sensors[i]->id);
+
+	/* all the sensors are due at the first run */
+	if (adaptive)
+		j->states = calloc(n, sizeof(struct sampling_state));
+	else
+		j->states = NULL;
+
+	j->due = malloc((n + 1) * sizeof(struct psensor *));
+
+	jobs_count++;
+}
+
+/*
+ * Creates a job for each sensor having its own update interval and a
+ * job for the other sensors of each provider.
+ */
+static void create_sampling_jobs(const struct psensor_registry *r)
+{
+	struct psensor **ss, **shared, **single;
+	int p, i, n, interval;
+	int64_t now;
+	bool adaptive;
+
+	adaptive = config_is_adaptive_sampling_enabled();
+	adaptive_max_interval = config_get_adaptive_sampling_max_interval();
+
+	jobs = malloc((psensor_registry_size(r) + PSENSOR_PROVIDERS_COUNT)
+		      * sizeof(struct sampling_job));
+	jobs_count = 0;
+
+	for (p = 0; p < PSENSOR_PROVIDERS_COUNT; p++) {
+		ss = psensor_registry_get_provider(r, p);
+
+		for (n = 0; ss[n]; n++)
+			;
+
+		if (!n)
+			continue;
+
+		shared = malloc((n + 1) * sizeof(struct psensor *));
+
+		for (i = 0, n = 0; ss[i]; i++) {
+			interval = config_get_sensor_update_interval(ss[i]->id);
+
+			if (interval) {
+				single = malloc(2 * sizeof(struct psensor *));
+				single[0] = ss[i];
+				single[1] = NULL;
+
+				add_job(p, single, 1, interval, adaptive);
+			} else {
+				shared[n++] = ss[i];
+			}
+		}
+		shared[n] = NULL;
+
+		if (n) {
+			interval = config_get_provider_update_interval(p);
+			add_job(p, shared, n, interval, adaptive);
+		} else {
+			free(shared);
+		}
+	}
+
+	psched_init(&sampler);
+
+	for (p = 0; p < PSENSOR_PROVIDERS_COUNT; p++)
+		pthread_mutex_init(&provider_mutexes[p], NULL);
+
+	n = jobs_count;
+	if (n > SAMPLING_THREADS_MAX)
+		n = SAMPLING_THREADS_MAX;
+	workers_started = n && ppool_init(&workers, n);
+
+	now = psched_get_time();
+	for (i = 0; i < jobs_count; i++) {
+		ppool_job_init(&jobs[i].work, run_job, &jobs[i]);
+
+		jobs[i].task = psched_add(&sampler,
+					  jobs[i].interval,
+					  submit_job,
+					  &jobs[i],
+					  now);
+
+		log_debug("Sampling job %d: provider %s, interval %dms",
+			  i,
+			  psensor_provider_get_name(jobs[i].provider),
+			  jobs[i].interval);
+	}
+}
+
+static void free_sampling_jobs(void)
+{
+	int i;
+
+	if (workers_started) {
+		ppool_free(&workers);
+		workers_started = false;
+	}
+
+	psched_free(&sampler);
+
+	for (i = 0; i < jobs_count; i++) {
+		free(jobs[i].sensors);
+		free(jobs[i].enabled);
+		free(jobs[i].states);
+		free(jobs[i].due);
+	}
+
+	free(jobs);
+	jobs = NULL;
+	jobs_count = 0;
+}
+
+/*
+ * Called in the main loop after the hardware set the alarm flag of a
+ * sensor: the sensor is updated immediately and its alarm is raised
+ * even if the measure is within the thresholds.
+ */
+static gboolean hwmon_alarm_update(gpointer data)
+{
+	struct psensor *s, *list[2];
+
+	s = data;
+
+	if (!config_is_sensor_enabled(s->id))
+		return FALSE;
+
+	list[0] = s;
+	list[1] = NULL;
+
+	pthread_mutex_lock(&provider_mutexes[PSENSOR_PROVIDER_HWMON]);
+
+	hwmon_psensor_list_update(list);
+	psensor_raise_alarm(s);
+
+	pthread_mutex_unlock(&provider_mutexes[PSENSOR_PROVIDER_HWMON]);
+
+	return FALSE;
+}
+
+/*
+ * Called by the hwmon watching thread, the configuration is read
+ * only by the main loop.
+ */
+static void cb_hwmon_alarm(struct psensor *s, void *data)
+{
+	g_idle_add(hwmon_alarm_update, s);
+}
+
+/* Updates the active set when a sensor is enabled or disabled. */
+static void cb_sensor_enabled_changed(const char *sid, bool enabled, void *data)
+{
+	struct sampling_job *j;
+	int i, k;
+
+	for (i = 0, j = jobs; i < jobs_count; i++, j++)
+		for (k = 0; j->sensors[k]; k++)
+			if (!strcmp(j->sensors[k]->id, sid))
+				__atomic_store_n(&j->enabled[k],
+						 enabled,
+						 __ATOMIC_RELAXED);
+}
+
+/*
+ * Applies sensor_update_interval to the jobs without their own
+ * interval, it may have been changed in the preferences.
+ */
+static void update_sampling_intervals(const struct config *cfg)
+{
+	struct sampling_job *j;
+	int i;
+
+	for (i = 0, j = jobs; i < jobs_count; i++, j++)
+		if (!j->interval)
+			psched_task_set_interval(j->task,
+						 cfg->sensor_update_interval);
+}
+
+/*
+ * Logs the deadlines missed since the last call, because a job was
+ * still running or the sampling thread was late.
+ */
+static void log_sampling_overruns(void)
+{
+	struct sampling_job *j;
+	int i;
+
+	for (i = 0, j = jobs; i < jobs_count; i++, j++)
+		if (j->task->overruns != j->overruns) {
+			log_warn(_("Sampling of %s missed %u deadlines "
+				   "(%u in total)."),
+				 psensor_provider_get_name(j->provider),
+				 j->task->overruns - j->overruns,
+				 j->task->overruns);
+
+			j->overruns = j->task->overruns;
+		}
 }
 
 static void *update_measures(void *data)
 {
 	struct psensor **sensors;
 	struct config *cfg;
-	int period;
 	struct ui_psensor *ui;
+	int64_t deadline;
 
 	ui = (struct ui_psensor *)data;
 	cfg = ui->config;
@@ -131,35 +594,46 @@ static void *update_measures(void *data)
 		pmutex_lock(&ui->sensors_mutex);
 
 		sensors = ui->sensors;
-		if (!sensors)
+		if (!sensors) {
+			pmutex_unlock(&ui->sensors_mutex);
+			free_sampling_jobs();
 			pthread_exit(NULL);
+		}
+
+		update_psensor_values_size(cfg);
 
-		update_psensor_values_size(sensors, cfg);
+		update_sampling_intervals(cfg);
 
-		lmsensor_psensor_list_update(sensors);
+		psched_run_due(&sampler, psched_get_time());
 
-		remote_psensor_list_update(sensors);
-		nvidia_psensor_list_update(sensors);
-		amd_psensor_list_update(sensors);
-		udisks2_psensor_list_update(sensors);
-		gtop2_psensor_list_update(sensors);
-		atasmart_psensor_list_update(sensors);
-		hddtemp_psensor_list_update(sensors);
-		phone_sensor_psensor_list_update(sensors);
+		deadline = psched_get_next_deadline(&sampler);
+		if (deadline == -1)
+			deadline = psched_get_time()
+				+ cfg->sensor_update_interval;
+
+		/*
+		 * A job still running at the next deadline completes in
+		 * the background, it is not submitted again meanwhile.
+		 */
+		if (workers_started)
+			ppool_wait(&workers, deadline);
+
+		psensor_cycle_end();
 
 		psensor_log_measures(sensors);
 
-		period = cfg->sensor_update_interval;
+		log_sampling_overruns();
 
 		pmutex_unlock(&ui->sensors_mutex);
 
-		sleep(period);
+		psched_sleep_until(deadline);
 	}
 }
 
 static void indicators_update(struct ui_psensor *ui)
 {
 	struct psensor **ss, *s;
+	struct psensor_snapshot snapshot;
 	bool attention;
 
 	attention = false;
@@ -167,7 +641,10 @@ static void indicators_update(struct ui_psensor *ui)
 	while (*ss) {
 		s = *ss;
 
-		if (s->alarm_raised && config_get_sensor_alarm_enabled(s->id)) {
+		psensor_get_snapshot(s, &snapshot);
+
+		if (snapshot.alarm_raised
+		    && config_get_sensor_alarm_enabled(s->id)) {
 			attention = true;
 			break;
 		}
@@ -182,33 +659,51 @@ static void indicators_update(struct ui_psensor *ui)
 		ui_status_update(ui, attention);
 }
 
+/* Number of sampling cycles adding measures */
+static unsigned int cycles;
+
+static void on_cycle_end(void *data)
+{
+	__atomic_add_fetch(&cycles, 1, __ATOMIC_RELAXED);
+}
+
 static gboolean ui_refresh_thread(gpointer data)
 {
 	struct config *cfg;
 	gboolean ret;
 	struct ui_psensor *ui = (struct ui_psensor *)data;
+	static unsigned int refreshed_cycles;
+	unsigned int n;
 
 	ret = TRUE;
 	cfg = ui->config;
 
-	pmutex_lock(&ui->sensors_mutex);
-
+	/*
+	 * The measures are read without locking sensors_mutex, so
+	 * rendering never delays the sampling thread.
+	 */
 	graph_update(ui->sensors, ui_get_graph(), ui->config, ui->main_window);
 
-	ui_sensorlist_update(ui, 0);
+	/* the values are unchanged if no cycle ended meanwhile */
+	n = __atomic_load_n(&cycles, __ATOMIC_RELAXED);
+	if (n != refreshed_cycles) {
+		refreshed_cycles = n;
+
+		ui_sensorlist_update(ui, 0);
 
-	if (is_appindicator_supported() || is_status_supported())
-		indicators_update(ui);
+		if (is_appindicator_supported() || is_status_supported())
+			indicators_update(ui);
 
-	ui_unity_launcher_entry_update(ui->sensors);
+		ui_unity_launcher_entry_update
+			(psensor_registry_get_type(&ui->registry,
+						   PSENSOR_VALUE_TEMP));
+	}
 
 	if (ui->graph_update_interval != cfg->graph_update_interval) {
 		ui->graph_update_interval = cfg->graph_update_interval;
 		ret = FALSE;
 	}
 
-	pmutex_unlock(&ui->sensors_mutex);
-
 	if (ret == FALSE)
 		g_timeout_add(1000 * ui->graph_update_interval,
 			      ui_refresh_thread, ui);
@@ -216,12 +711,19 @@ static gboolean ui_refresh_thread(gpointer data)
 	return ret;
 }
 
+/* Serializes the alarms raised by the concurrent sampling jobs */
+static pthread_mutex_t alarm_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void cb_alarm_raised(struct psensor *sensor, void *data)
 {
+	pthread_mutex_lock(&alarm_mutex);
+
 	if (config_get_sensor_alarm_enabled(sensor->id)) {
 		ui_notify(sensor, (struct ui_psensor *)data);
 		notify_cmd(sensor);
 	}
+
+	pthread_mutex_unlock(&alarm_mutex);
 }
 
 static void
@@ -267,6 +769,7 @@ static void associate_preferences(struct psensor **sensors)
 
 	while (*sensor_cur) {
 		char *n;
+		bool graphed;
 		struct psensor *s = *sensor_cur;
 
 		n = config_get_sensor_name(s->id);
@@ -276,10 +779,26 @@ static void associate_preferences(struct psensor **sensors)
 			s->name = n;
 		}
 
+		/* the history is only kept for the graphed sensors */
+		graphed = config_is_sensor_graph_enabled(s->id);
+		psensor_set_history_enabled(s, graphed);
+
 		sensor_cur++;
 	}
 }
 
+/* Allocates or frees the history of a sensor graphed or not anymore. */
+static void
+cb_sensor_graph_enabled_changed(const char *sid, bool enabled, void *data)
+{
+	struct psensor *s;
+
+	s = psensor_list_get_by_id((struct psensor **)data, sid);
+
+	if (s)
+		psensor_set_history_enabled(s, enabled);
+}
+
 static void log_init(void)
 {
 	const char *dir;
@@ -357,11 +876,23 @@ static void cleanup(struct ui_psensor *ui)
 
 	log_debug("Cleanup...");
 
+	/*
+	 * The jobs which overran their deadline and the alarm watcher
+	 * run without the sensors mutex: they are stopped before the
+	 * providers and the sensors are freed.
+	 */
+	hwmon_alarm_watch_stop();
+	free_sampling_jobs();
+
 	nvidia_cleanup();
 	amd_cleanup();
+	hwmon_cleanup();
+	powercap_cleanup();
+	cpufreq_cleanup();
+	cpustat_cleanup();
 	rsensor_cleanup();
 
-	psensor_list_free(ui->sensors);
+	psensor_registry_free(&ui->registry);
 	ui->sensors = NULL;
 
 	ui_appindicator_cleanup();
@@ -376,54 +907,76 @@ static void cleanup(struct ui_psensor *ui)
 }
 
 /*
- * Creates the list of sensors.
+ * Fills the registry of sensors.
  *
  * 'url': remote psensor server url, null for local monitoring.
  */
-static struct psensor **create_sensors_list(const char *url)
+static void create_sensors_registry(struct psensor_registry *r,
+				    const char *url)
 {
-	struct psensor **sensors;
+	char *root;
+
+	psensor_registry_init(r);
 
 	if (url) {
 		if (rsensor_is_supported()) {
 			rsensor_init();
-			sensors = get_remote_sensors(url, 600);
+			remote_psensor_list_append(r, url, 600);
 		} else {
 			log_err(_("Psensor has not been compiled with remote "
 				  "sensor support."));
 			exit(EXIT_FAILURE);
 		}
 	} else {
-		sensors = malloc(sizeof(struct psensor *));
-		*sensors = NULL;
-
 		if (config_is_lmsensor_enabled())
-			lmsensor_psensor_list_append(&sensors, 600);
+			lmsensor_psensor_list_append(r, 600);
+
+		if (config_is_hwmon_enabled()) {
+			root = config_get_hwmon_sysfs_root();
+			hwmon_psensor_list_append(r, root, 600);
+			free(root);
+		}
 
 		if (config_is_hddtemp_enabled())
-			hddtemp_psensor_list_append(&sensors, 600);
+			hddtemp_psensor_list_append(r, 600);
 
 		if (config_is_libatasmart_enabled())
-			atasmart_psensor_list_append(&sensors, 600);
+			atasmart_psensor_list_append(r, 600);
 
 		if (config_is_nvctrl_enabled())
-			nvidia_psensor_list_append(&sensors, 600);
+			nvidia_psensor_list_append(r, 600);
 
 		if (config_is_atiadlsdk_enabled())
-			amd_psensor_list_append(&sensors, 600);
+			amd_psensor_list_append(r, 600);
 
 		if (config_is_gtop2_enabled())
-			gtop2_psensor_list_append(&sensors, 600);
+			gtop2_psensor_list_append(r, 600);
+
+		if (config_is_cpustat_enabled())
+			cpustat_psensor_list_append(r,
+						    CPUSTAT_PROC_STAT,
+						    CPUSTAT_SYSFS_ROOT,
+						    600);
+
+		if (config_is_cpufreq_enabled()) {
+			root = config_get_cpufreq_sysfs_root();
+			cpufreq_psensor_list_append(r, root, 600);
+			free(root);
+		}
+
+		if (config_is_powercap_enabled()) {
+			root = config_get_powercap_sysfs_root();
+			powercap_psensor_list_append(r, root, 600);
+			free(root);
+		}
 
 		if (config_is_udisks2_enabled())
-			udisks2_psensor_list_append(&sensors, 600);
+			udisks2_psensor_list_append(r, 600);
 
-		phone_sensor_psensor_list_append(&sensors, 600);
+		phone_sensor_psensor_list_append(r, 600);
 	}
 
-	associate_preferences(sensors);
-
-	return sensors;
+	associate_preferences(psensor_registry_list(r));
 }
 
 int main(int argc, char **argv)
@@ -508,14 +1061,12 @@ int main(int argc, char **argv)
 
 	ui.config = config_load();
 
-	ui.sensors = create_sensors_list(url);
+	create_sensors_registry(&ui.registry, url);
+	ui.sensors = psensor_registry_list(&ui.registry);
 	associate_cb_alarm_raised(ui.sensors, &ui);
 
 	if (ui.config->slog_enabled)
-		slog_activate(NULL,
-			      ui.sensors,
-			      &ui.sensors_mutex,
-			      config_get_slog_interval());
+		slog_activate(NULL, ui.sensors, config_get_slog_interval());
 
 	ui_status_init(&ui);
 	ui_status_set_visible(1);
@@ -525,6 +1076,18 @@ int main(int argc, char **argv)
 
 	ui_enable_alpha_channel(&ui);
 
+	psensor_cycle_add_listener(on_cycle_end, NULL);
+
+	create_sampling_jobs(&ui.registry);
+	hwmon_alarm_watch_start
+		(psensor_registry_get_provider(&ui.registry,
+					       PSENSOR_PROVIDER_HWMON),
+		 cb_hwmon_alarm,
+		 NULL);
+	config_set_sensor_enabled_changed_cbk(cb_sensor_enabled_changed, NULL);
+	config_set_sensor_graph_enabled_changed_cbk
+		(cb_sensor_graph_enabled_changed, ui.sensors);
+
 	ret = pthread_create(&thread, NULL, update_measures, &ui);
 
 	if (ret)
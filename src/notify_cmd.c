@@ -26,13 +26,13 @@
 
 void notify_cmd(struct psensor *s)
 {
-	char *script, *v, *cmd;
+	char *script, *cmd, v[PSENSOR_VALUE_STR_SIZE];
 	int ret;
 
 	script = config_get_notif_script();
 
 	if (script) {
-		v = psensor_current_value_to_str(s, 1);
+		psensor_current_value_to_buf(s, 1, v, sizeof(v));
 
 		cmd = malloc(strlen(script)
 			     + 1
@@ -52,7 +52,6 @@ void notify_cmd(struct psensor *s)
 		log_fct("cmd returns: %d", ret);
 
 		free(cmd);
-		free(v);
 		free(script);
 	}
 }
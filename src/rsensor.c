@@ -119,53 +119,45 @@ static json_object *get_json_object(const char *url)
 	return obj;
 }
 
-struct psensor **get_remote_sensors(const char *server_url,
-				    int values_max_length)
+void remote_psensor_list_append(struct psensor_registry *r,
+				const char *server_url,
+				int values_max_length)
 {
-	struct psensor **sensors, *s;
+	struct psensor *s;
 	char *url;
 	json_object *obj;
 	int i, n;
 
-	sensors = NULL;
-
 	url = create_api_1_1_sensors_url(server_url);
 
 	obj = get_json_object(url);
 
 	if (obj && !is_error(obj)) {
 		n = json_object_array_length(obj);
-		sensors = malloc((n + 1) * sizeof(struct psensor *));
 
 		for (i = 0; i < n; i++) {
 			s = psensor_new_from_json
 				(json_object_array_get_idx(obj, i),
 				 url,
 				 values_max_length);
-			sensors[i] = s;
+			psensor_registry_add(r, s);
 		}
 
-		sensors[n] = NULL;
-
 		json_object_put(obj);
 	} else {
 		log_err(_("%s: Invalid content: %s"), PROVIDER_NAME, url);
 	}
 
 	free(url);
-
-	if (!sensors) {
-		sensors = malloc(sizeof(struct psensor *));
-		*sensors = NULL;
-	}
-
-	return sensors;
 }
 
-static void remote_psensor_update(struct psensor *s)
+static void remote_psensor_update(struct psensor_batch *b, int i)
 {
+	struct psensor *s;
 	json_object *obj;
 
+	s = b->sensors[i];
+
 	obj = get_json_object(get_url(s));
 
 	if (obj && !is_error(obj)) {
@@ -175,16 +167,22 @@ static void remote_psensor_update(struct psensor *s)
 
 		if (!is_error(obj)) {
 			json_object *ov, *ot;
-			struct timeval tv;
+			struct measure m;
 
 			json_object_object_get_ex(om, "value", &ov);
-			json_object_object_get_ex(om, "time", &ot);
 
-			tv.tv_sec = json_object_get_int(ot);
-			tv.tv_usec = 0;
-
-			psensor_set_current_measure
-			    (s, json_object_get_double(ov), tv);
+			/* the previous servers provide only seconds */
+			if (json_object_object_get_ex(om, "time_ms", &ot)) {
+				measure_set_time_ms
+					(&m, json_object_get_int64(ot));
+			} else {
+				json_object_object_get_ex(om, "time", &ot);
+				m.time.tv_sec = json_object_get_int(ot);
+				m.time.tv_usec = 0;
+			}
+
+			psensor_batch_set_measure
+			    (b, i, json_object_get_double(ov), m.time);
 		}
 
 		json_object_put(obj);
@@ -196,15 +194,14 @@ static void remote_psensor_update(struct psensor *s)
 
 void remote_psensor_list_update(struct psensor **sensors)
 {
-	struct psensor **cur;
+	struct psensor_batch b;
+	int i;
 
-	cur = sensors;
-	while (*cur) {
-		struct psensor *s = *cur;
+	psensor_batch_begin(&b, sensors);
 
-		if (s->type & SENSOR_TYPE_REMOTE)
-			remote_psensor_update(s);
+	for (i = 0; sensors[i]; i++)
+		if (sensors[i]->type & SENSOR_TYPE_REMOTE)
+			remote_psensor_update(&b, i);
 
-		cur++;
-	}
+	psensor_batch_commit(&b);
 }
@@ -19,13 +19,14 @@
 #ifndef _PSENSOR_RSENSOR_H_
 #define _PSENSOR_RSENSOR_H_
 
+#include <pregistry.h>
 #include <psensor.h>
 
 #if defined(HAVE_REMOTE_SUPPORT) && HAVE_REMOTE_SUPPORT
 
 static inline bool rsensor_is_supported(void) { return true; }
 
-struct psensor **get_remote_sensors(const char *, int);
+void remote_psensor_list_append(struct psensor_registry *, const char *, int);
 void remote_psensor_list_update(struct psensor **);
 void rsensor_init(void);
 void rsensor_cleanup(void);
@@ -34,8 +35,9 @@ void rsensor_cleanup(void);
 
 static inline bool rsensor_is_supported(void) { return false; }
 
-static inline struct psensor **
-get_remote_sensors(const char *url, int n) { return NULL; }
+static inline void
+remote_psensor_list_append(struct psensor_registry *r, const char *url, int n)
+{}
 static inline void remote_psensor_list_update(struct psensor **s) {}
 static inline void rsensor_init(void) {}
 static inline void rsensor_cleanup(void) {}
@@ -43,11 +43,15 @@
 #include <pgtop2.h>
 #endif
 
+#include <cpufreq.h>
+#include <cpustat.h>
 #include <hdd.h>
 #include <lmsensor.h>
 #include <plog.h>
+#include <powercap.h>
 #include "psensor_json.h"
 #include <pmutex.h>
+#include <psched.h>
 #include "url.h"
 #include "server.h"
 #include "slog.h"
@@ -61,6 +65,9 @@ static const char *program_name;
 
 static const int DEFAULT_PORT = 3131;
 
+/* Update interval of the sensors in milliseconds */
+static const int DEFAULT_SENSOR_UPDATE_INTERVAL = 5000;
+
 #define PAGE_NOT_FOUND (_("<html><body><p>"\
 "Page not found - Go to <a href='/'>Main page</a></p></body>"))
 
@@ -73,6 +80,7 @@ static struct option long_options[] = {
 	{"log-file", required_argument, NULL, 'l'},
 	{"sensor-log-file", required_argument, NULL, 0},
 	{"sensor-log-interval", required_argument, NULL, 0},
+	{"sensor-update-interval", required_argument, NULL, 0},
 	{NULL, 0, NULL, 0}
 };
 
@@ -116,6 +124,8 @@ static void print_help(void)
 	puts(_("  --sensor-log-file=PATH set the sensor log file to PATH"));
 	puts(_("  --sensor-log-interval=S "
 	       "set the sensor log interval to S (seconds)"));
+	puts(_("  --sensor-update-interval=MS "
+	       "set the sensor update interval to MS (milliseconds)"));
 
 	puts("");
 	printf(_("Report bugs to: %s\n"), PACKAGE_BUGREPORT);
@@ -159,7 +169,10 @@ file_reader(void *cls, uint64_t pos, char *buf, int max)
 }
 
 static struct MHD_Response *
-create_response_api(const char *nurl, const char *method, unsigned int *rp_code)
+create_response_api(const char *nurl,
+		    const char *method,
+		    int span,
+		    unsigned int *rp_code)
 {
 	struct MHD_Response *resp;
 	struct psensor *s;
@@ -169,9 +182,12 @@ create_response_api(const char *nurl, const char *method, unsigned int *rp_code)
 		page = sensors_to_json_string(server_data.sensors);
 #ifdef HAVE_GTOP
 	} else if (!strcmp(nurl, URL_API_1_1_SYSINFO)) {
+		pmutex_lock(&mutex);
 		page = sysinfo_to_json_string(&server_data.psysinfo);
+		pmutex_unlock(&mutex);
 	} else if (!strcmp(nurl, URL_API_1_1_CPU_USAGE)) {
-		page = sensor_to_json_string(server_data.cpu_usage);
+		page = sensor_to_json_string(server_data.cpu_usage,
+					     span);
 #endif
 	} else if (!strncmp(nurl, URL_BASE_API_1_1_SENSORS,
 			    strlen(URL_BASE_API_1_1_SENSORS))
@@ -182,7 +198,7 @@ create_response_api(const char *nurl, const char *method, unsigned int *rp_code)
 		s = psensor_list_get_by_id(server_data.sensors, sid);
 
 		if (s)
-			page = sensor_to_json_string(s);
+			page = sensor_to_json_string(s, span);
 
 	} else if (!strcmp(nurl, URL_API_1_1_SERVER_STOP)) {
 
@@ -275,13 +291,16 @@ static int is_access_allowed(char *path)
 }
 
 static struct MHD_Response *
-create_response(const char *nurl, const char *method, unsigned int *rp_code)
+create_response(const char *nurl,
+		const char *method,
+		int span,
+		unsigned int *rp_code)
 {
 	char *page, *fpath;
 	struct MHD_Response *resp = NULL;
 
 	if (!strncmp(nurl, URL_BASE_API_1_1, strlen(URL_BASE_API_1_1))) {
-		resp = create_response_api(nurl, method, rp_code);
+		resp = create_response_api(nurl, method, span, rp_code);
 	} else {
 		fpath = get_path(nurl, server_data.www_dir);
 
@@ -316,8 +335,9 @@ static int cbk_http_request(void *cls,
 {
 	static int dummy;
 	struct MHD_Response *response;
-	int ret;
+	int ret, span;
 	char *nurl;
+	const char *arg;
 	unsigned int resp_code;
 
 	if (strcmp(method, "GET"))
@@ -340,9 +360,20 @@ static int cbk_http_request(void *cls,
 
 	nurl = url_normalize(url);
 
-	pmutex_lock(&mutex);
-	response = create_response(nurl, method, &resp_code);
-	pmutex_unlock(&mutex);
+	/* duration in seconds of the requested measures */
+	arg = MHD_lookup_connection_value(connection,
+					  MHD_GET_ARGUMENT_KIND,
+					  "span");
+	if (arg)
+		span = atoi(arg);
+	else
+		span = 0;
+
+	/*
+	 * The measures are read without lock, only the system
+	 * information requires the mutex of the sampling loop.
+	 */
+	response = create_response(nurl, method, span, &resp_code);
 
 	ret = MHD_queue_response(connection, resp_code, response);
 	MHD_destroy_response(response);
@@ -352,11 +383,120 @@ static int cbk_http_request(void *cls,
 	return ret;
 }
 
+#ifdef HAVE_GTOP
+static void update_sysinfo(void *data)
+{
+	sysinfo_update(&server_data.psysinfo);
+	cpu_usage_sensor_update(server_data.cpu_usage);
+}
+#endif
+
+#ifdef HAVE_ATASMART
+static void update_atasmart(void *data)
+{
+	atasmart_psensor_list_update((struct psensor **)data);
+}
+#endif
+
+static void update_hddtemp(void *data)
+{
+	hddtemp_psensor_list_update((struct psensor **)data);
+}
+
+static void update_lmsensor(void *data)
+{
+	lmsensor_psensor_list_update((struct psensor **)data);
+}
+
+static void update_powercap(void *data)
+{
+	powercap_psensor_list_update((struct psensor **)data);
+}
+
+static void update_cpufreq(void *data)
+{
+	cpufreq_psensor_list_update((struct psensor **)data);
+}
+
+static void update_cpustat(void *data)
+{
+	cpustat_psensor_list_update((struct psensor **)data);
+}
+
+/* Schedules the updates of the measures of each provider. */
+static void
+create_sampling_tasks(struct psched *s,
+		      const struct psensor_registry *r,
+		      int interval)
+{
+	int64_t now;
+
+	now = psched_get_time();
+
+#ifdef HAVE_GTOP
+	psched_add(s, interval, update_sysinfo, NULL, now);
+#endif
+
+#ifdef HAVE_ATASMART
+	psched_add(s,
+		   interval,
+		   update_atasmart,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_ATASMART),
+		   now);
+#endif
+
+	psched_add(s,
+		   interval,
+		   update_hddtemp,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_HDDTEMP),
+		   now);
+
+	psched_add(s,
+		   interval,
+		   update_lmsensor,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_LMSENSOR),
+		   now);
+
+	psched_add(s,
+		   interval,
+		   update_powercap,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_POWERCAP),
+		   now);
+
+	psched_add(s,
+		   interval,
+		   update_cpufreq,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_CPUFREQ),
+		   now);
+
+	psched_add(s,
+		   interval,
+		   update_cpustat,
+		   psensor_registry_get_provider(r, PSENSOR_PROVIDER_CPUSTAT),
+		   now);
+}
+
+/* Returns the number of deadlines missed by the tasks of 's'. */
+static unsigned int get_overruns(const struct psched *s)
+{
+	unsigned int n;
+	int i;
+
+	n = 0;
+	for (i = 0; i < s->size; i++)
+		n += s->heap[i]->overruns;
+
+	return n;
+}
+
 int main(int argc, char *argv[])
 {
 	struct MHD_Daemon *d;
-	int port, opti, optc, cmdok, ret, slog_interval;
+	int port, opti, optc, cmdok, ret, slog_interval, interval;
+	unsigned int overruns, logged_overruns;
+	struct psched sampler;
 	char *log_file, *slog_file;
+	struct psensor **cur;
 
 	program_name = argv[0];
 
@@ -374,6 +514,7 @@ int main(int argc, char *argv[])
 	log_file = NULL;
 	slog_file = NULL;
 	slog_interval = 300;
+	interval = DEFAULT_SENSOR_UPDATE_INTERVAL;
 	port = DEFAULT_PORT;
 	cmdok = 1;
 
@@ -411,6 +552,9 @@ int main(int argc, char *argv[])
 			else if (!strcmp(long_options[opti].name,
 					 "sensor-log-interval"))
 				slog_interval = atoi(optarg);
+			else if (!strcmp(long_options[opti].name,
+					 "sensor-update-interval"))
+				interval = atoi(optarg);
 			break;
 		default:
 			cmdok = 0;
@@ -440,15 +584,37 @@ int main(int argc, char *argv[])
 
 	log_open(log_file);
 
-	hddtemp_psensor_list_append(&server_data.sensors, 600);
+	psensor_registry_init(&server_data.registry);
+
+	hddtemp_psensor_list_append(&server_data.registry, 600);
+
+	lmsensor_psensor_list_append(&server_data.registry, 600);
 
-	lmsensor_psensor_list_append(&server_data.sensors, 600);
+	powercap_psensor_list_append(&server_data.registry,
+				     POWERCAP_SYSFS_ROOT,
+				     600);
+
+	cpufreq_psensor_list_append(&server_data.registry,
+				    CPUFREQ_SYSFS_ROOT,
+				    600);
+
+	cpustat_psensor_list_append(&server_data.registry,
+				    CPUSTAT_PROC_STAT,
+				    CPUSTAT_SYSFS_ROOT,
+				    600);
+
+	server_data.sensors = psensor_registry_list(&server_data.registry);
+
+	/* the measures of all the sensors are served */
+	for (cur = server_data.sensors; *cur; cur++)
+		psensor_set_history_enabled(*cur, true);
 
 #ifdef HAVE_GTOP
 	server_data.cpu_usage = create_cpu_usage_sensor(600);
+	psensor_set_history_enabled(server_data.cpu_usage, true);
 #endif
 
-	if (!server_data.sensors || !*server_data.sensors)
+	if (!psensor_registry_size(&server_data.registry))
 		log_err(_("No sensors detected."));
 
 	d = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION,
@@ -469,45 +635,57 @@ int main(int argc, char *argv[])
 			slog_interval = 300;
 		ret = slog_activate(slog_file,
 				    server_data.sensors,
-				    &mutex,
 				    slog_interval);
 		if (!ret)
 			log_err(_("Failed to activate logging of sensors."));
 	}
 
-	while (!server_stop_requested) {
-		pmutex_lock(&mutex);
+	if (interval <= 0)
+		interval = DEFAULT_SENSOR_UPDATE_INTERVAL;
 
-#ifdef HAVE_GTOP
-		sysinfo_update(&server_data.psysinfo);
-		cpu_usage_sensor_update(server_data.cpu_usage);
-#endif
+	psched_init(&sampler);
+	create_sampling_tasks(&sampler, &server_data.registry, interval);
+	logged_overruns = 0;
 
-#ifdef HAVE_ATASMART
-		atasmart_psensor_list_update(server_data.sensors);
-#endif
+	while (!server_stop_requested) {
+		pmutex_lock(&mutex);
 
-		hddtemp_psensor_list_update(server_data.sensors);
+		psched_run_due(&sampler, psched_get_time());
 
-		lmsensor_psensor_list_update(server_data.sensors);
+		psensor_cycle_end();
 
 		psensor_log_measures(server_data.sensors);
 
 		pmutex_unlock(&mutex);
-		sleep(5);
+
+		overruns = get_overruns(&sampler);
+		if (overruns != logged_overruns) {
+			log_warn(_("Sampling missed %u deadlines "
+				   "(%u in total)."),
+				 overruns - logged_overruns,
+				 overruns);
+			logged_overruns = overruns;
+		}
+
+		psched_sleep_until(psched_get_next_deadline(&sampler));
 	}
 
+	psched_free(&sampler);
+
 	slog_close();
 
 	MHD_stop_daemon(d);
 
 	/* sanity cleanup for valgrind */
-	psensor_list_free(server_data.sensors);
+	psensor_registry_free(&server_data.registry);
 #ifdef HAVE_GTOP
 	psensor_free(server_data.cpu_usage);
 #endif
 	free(server_data.www_dir);
 	lmsensor_cleanup();
+	powercap_cleanup();
+	cpufreq_cleanup();
+	cpustat_cleanup();
 
 #ifdef HAVE_GTOP
 	sysinfo_cleanup();
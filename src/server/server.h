@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include "pregistry.h"
 #include "psensor.h"
 
 #ifdef HAVE_GTOP
@@ -35,6 +36,8 @@
 
 struct server_data {
 	struct psensor *cpu_usage;
+	struct psensor_registry registry;
+	/* list of all the sensors of the registry */
 	struct psensor **sensors;
 #ifdef HAVE_GTOP
 	struct psysinfo psysinfo;
@@ -301,16 +301,14 @@ static void slog_enabled_cbk(void *data)
 {
 	struct ui_psensor *ui;
 	struct psensor **sensors;
-	pthread_mutex_t *mutex;
 
 	ui = (struct ui_psensor *)data;
 	sensors = ui->sensors;
-	mutex = &ui->sensors_mutex;
 
 	log_debug("slog_enabled_cbk");
 
 	if (is_slog_enabled())
-		slog_activate(NULL, sensors, mutex, config_get_slog_interval());
+		slog_activate(NULL, sensors, config_get_slog_interval());
 	else
 		slog_close();
 }
@@ -436,15 +434,20 @@ static int cmp_sensors(const void *p1, const void *p2)
 	return pos1 - pos2;
 }
 
+void ui_sort_sensors_by_position(struct psensor **sensors)
+{
+	qsort(sensors,
+	      psensor_list_size(sensors),
+	      sizeof(struct psensor *),
+	      cmp_sensors);
+}
+
 struct psensor **ui_get_sensors_ordered_by_position(struct psensor **sensors)
 {
 	struct psensor **result;
 
 	result = psensor_list_copy(sensors);
-	qsort(result,
-	      psensor_list_size(result),
-	      sizeof(struct psensor *),
-	      cmp_sensors);
+	ui_sort_sensors_by_position(result);
 
 	return result;
 }
@@ -30,13 +30,20 @@
 #include <libappindicator/app-indicator.h>
 #endif
 
+#include "pregistry.h"
 #include "psensor.h"
 
 #define PSENSOR_ICON "psensor"
 
 struct ui_psensor {
+	struct psensor_registry registry;
+	/* list of all the sensors of the registry */
 	struct psensor **sensors;
-	/* mutex which MUST be used for accessing sensors.*/
+	/*
+	 * Mutex held while updating the measures and which MUST be
+	 * used for modifying the sensors.  The measures are read
+	 * without it, see psensor_get_snapshot().
+	 */
 	pthread_mutex_t sensors_mutex;
 
 	struct config *config;
@@ -81,4 +88,7 @@ void ui_cb_sensor_preferences(GtkMenuItem *mi, gpointer data);
 GtkWidget *ui_get_graph(void);
 
 struct psensor **ui_get_sensors_ordered_by_position(struct psensor **);
+
+/* Sorts in place a NULL-terminated list of sensors by position. */
+void ui_sort_sensors_by_position(struct psensor **);
 #endif
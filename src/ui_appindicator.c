@@ -65,15 +65,14 @@ static void
 update_menu_item(GtkMenuItem *item, struct psensor *s, int use_celsius)
 {
 	gchar *str;
-	char *v;
+	char v[PSENSOR_VALUE_STR_SIZE];
 
-	v = psensor_current_value_to_str(s, use_celsius);
+	psensor_current_value_to_buf(s, use_celsius, v, sizeof(v));
 
 	str = g_strdup_printf("%s: %s", s->name, v);
 
 	gtk_menu_item_set_label(item, str);
 
-	free(v);
 	g_free(str);
 }
 
@@ -164,62 +163,89 @@ static GtkMenu *load_menu(struct ui_psensor *ui)
 	return menu;
 }
 
+/*
+ * Appends 'str' to the string 'buf' of length 'len', separated by
+ * 'sep' if not empty, growing the buffer of 'size' bytes if needed.
+ */
+static void
+label_append(char **buf, size_t *size, size_t *len, char sep, const char *str)
+{
+	size_t n;
+
+	n = strlen(str);
+
+	if (*len + n + 2 > *size) {
+		*size = 2 * (*len + n + 2);
+		*buf = realloc(*buf, *size);
+	}
+
+	if (*len)
+		(*buf)[(*len)++] = sep;
+
+	memcpy(*buf + *len, str, n + 1);
+	*len += n;
+}
+
+/*
+ * The label is rebuilt at each refresh into buffers kept across the
+ * calls, so that only the first refreshes have to allocate.
+ */
 static void update_label(struct ui_psensor *ui)
 {
-	char *label, *str, *tmp, *guide;
+	static struct psensor **sorted;
+	static int sorted_capacity;
+	static char *label, *guide;
+	static size_t label_size, guide_size;
+	char str[PSENSOR_VALUE_STR_SIZE];
+	const char *g;
 	struct psensor **p;
-	int use_celsius;
+	size_t label_len, guide_len;
+	int n, use_celsius;
 
-	p =  ui_get_sensors_ordered_by_position(ui->sensors);
-	label = NULL;
-	guide = NULL;
+	n = psensor_list_size(ui->sensors);
+	if (n + 1 > sorted_capacity) {
+		sorted_capacity = n + 1;
+		sorted = realloc(sorted, sorted_capacity * sizeof(*sorted));
+	}
+	memcpy(sorted, ui->sensors, n * sizeof(*sorted));
+	sorted[n] = NULL;
+	ui_sort_sensors_by_position(sorted);
+
+	label_len = 0;
+	guide_len = 0;
 
 	if (config_get_temperature_unit() == CELSIUS)
 		use_celsius = 1;
 	else
 		use_celsius = 0;
 
-	while (*p) {
-		if (config_is_appindicator_label_enabled((*p)->id)) {
-			str = psensor_current_value_to_str(*p, use_celsius);
-
-			if (label == NULL) {
-				label = str;
-			} else {
-				tmp = malloc(strlen(label)
-					     + 1
-					     + strlen(str)
-					     + 1);
-				sprintf(tmp, "%s %s", label, str);
-				free(label);
-				free(str);
-				label = tmp;
-			}
-
-			if (is_temp_type((*p)->type))
-				str = "999UUU";
-			else if ((*p)->type & SENSOR_TYPE_RPM)
-				str = "999UUU";
-			else /* percent */
-				str = "999%";
-
-			if (guide == NULL) {
-				guide = strdup(str);
-			} else {
-				tmp = malloc(strlen(guide)
-					     + 1
-					     + strlen(str)
-					     + 1);
-				sprintf(tmp, "%sW%s", guide, str);
-				free(guide);
-				guide = tmp;
-			}
-
-		}
-		p++;
+	for (p = sorted; *p; p++) {
+		if (!config_is_appindicator_label_enabled((*p)->id))
+			continue;
+
+		psensor_current_value_to_buf(*p, use_celsius, str, sizeof(str));
+		label_append(&label, &label_size, &label_len, ' ', str);
+
+		if (is_temp_type((*p)->type))
+			g = "999UUU";
+		else if ((*p)->type & SENSOR_TYPE_RPM)
+			g = "999UUU";
+		else if ((*p)->type & SENSOR_TYPE_POWER)
+			g = "999.9W";
+		else if ((*p)->type & SENSOR_TYPE_FREQ)
+			g = "9999MHz";
+		else if ((*p)->type & SENSOR_TYPE_RATE)
+			g = "999.9/s";
+		else /* percent */
+			g = "999%";
+
+		label_append(&guide, &guide_size, &guide_len, 'W', g);
 	}
 
-	app_indicator_set_label(indicator, label, guide);
+	if (label_len)
+		app_indicator_set_label(indicator, label, guide);
+	else
+		app_indicator_set_label(indicator, NULL, NULL);
 }
 
 void ui_appindicator_update(struct ui_psensor *ui, bool attention)
@@ -37,10 +37,11 @@ static struct timeval last_notification_tv;
 void ui_notify(struct psensor *sensor, struct ui_psensor *ui)
 {
 	struct timeval t;
-	char *body, *svalue;
+	char *body, svalue[PSENSOR_VALUE_STR_SIZE];
 	const char *summary;
 	NotifyNotification *notif;
 	unsigned int use_celsius;
+	struct measure m;
 
 	log_debug("last_notification %d", last_notification_tv.tv_sec);
 
@@ -64,14 +65,15 @@ void ui_notify(struct psensor *sensor, struct ui_psensor *ui)
 		else
 			use_celsius = 0;
 
-		svalue = psensor_measure_to_str
-			(psensor_get_current_measure(sensor),
-			 sensor->type,
-			 use_celsius);
+		psensor_get_current_measure(sensor, &m);
+		psensor_value_to_buf(sensor->type,
+				     m.value,
+				     use_celsius,
+				     svalue,
+				     sizeof(svalue));
 
 		body = malloc(strlen(sensor->name) + 3 + strlen(svalue) + 1);
 		sprintf(body, "%s : %s", sensor->name, svalue);
-		free(svalue);
 
 		if (is_temp_type(sensor->type))
 			summary = _("Temperature alert");
@@ -97,6 +99,7 @@ void ui_notify(struct psensor *sensor, struct ui_psensor *ui)
 		notify_notification_show(notif, NULL);
 
 		g_object_unref(notif);
+		free(body);
 	} else {
 		log_err("notify not initialized");
 	}
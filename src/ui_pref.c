@@ -95,7 +95,8 @@ void ui_pref_dialog_run(struct ui_psensor *ui)
 		*w_hide_on_startup, *w_win_restore, *w_slog_enabled,
 		*w_autostart, *w_smooth_curves, *w_atiadlsdk, *w_lmsensors,
 		*w_nvctrl, *w_gtop2, *w_hddtemp, *w_libatasmart, *w_udisks2,
-		*w_decoration, *w_keep_below;
+		*w_hwmon, *w_powercap, *w_cpufreq, *w_cpustat, *w_decoration,
+		*w_keep_below;
 	GtkComboBoxText *w_temp_unit;
 	GtkEntry *w_notif_script;
 	char *notif_script;
@@ -148,7 +149,7 @@ void ui_pref_dialog_run(struct ui_psensor *ui)
 		= GTK_SPIN_BUTTON(gtk_builder_get_object
 				  (builder, "sensor_update_interval"));
 	gtk_spin_button_set_value(w_s_update_interval,
-				  cfg->sensor_update_interval);
+				  cfg->sensor_update_interval / 1000.0);
 
 	w_decoration = GTK_TOGGLE_BUTTON(gtk_builder_get_object
 					 (builder, "hide_window_decoration"));
@@ -238,6 +239,24 @@ void ui_pref_dialog_run(struct ui_psensor *ui)
 		gtk_widget_set_has_tooltip(GTK_WIDGET(w_lmsensors), TRUE);
 	}
 
+	w_hwmon = GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder, "hwmon"));
+	gtk_toggle_button_set_active(w_hwmon, config_is_hwmon_enabled());
+
+	w_powercap
+		= GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder,
+							   "powercap"));
+	gtk_toggle_button_set_active(w_powercap, config_is_powercap_enabled());
+
+	w_cpufreq
+		= GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder,
+							   "cpufreq"));
+	gtk_toggle_button_set_active(w_cpufreq, config_is_cpufreq_enabled());
+
+	w_cpustat
+		= GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder,
+							   "cpustat"));
+	gtk_toggle_button_set_active(w_cpustat, config_is_cpustat_enabled());
+
 	w_nvctrl
 		= GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder,
 							   "nvctrl"));
@@ -344,7 +363,8 @@ void ui_pref_dialog_run(struct ui_psensor *ui)
 			cfg->alpha_channel_enabled = 1;
 
 		cfg->sensor_update_interval
-			= gtk_spin_button_get_value_as_int(w_s_update_interval);
+			= 1000 * gtk_spin_button_get_value(w_s_update_interval)
+			+ 0.5;
 
 		cfg->graph_update_interval = gtk_spin_button_get_value_as_int
 			(w_update_interval);
@@ -375,6 +395,18 @@ void ui_pref_dialog_run(struct ui_psensor *ui)
 		config_set_lmsensor_enable
 			(gtk_toggle_button_get_active(w_lmsensors));
 
+		config_set_hwmon_enable
+			(gtk_toggle_button_get_active(w_hwmon));
+
+		config_set_powercap_enable
+			(gtk_toggle_button_get_active(w_powercap));
+
+		config_set_cpufreq_enable
+			(gtk_toggle_button_get_active(w_cpufreq));
+
+		config_set_cpustat_enable
+			(gtk_toggle_button_get_active(w_cpustat));
+
 		config_set_nvctrl_enable
 			(gtk_toggle_button_get_active(w_nvctrl));
 
@@ -112,8 +112,11 @@ static void populate(struct ui_psensor *ui)
 
 void ui_sensorlist_update(struct ui_psensor *ui, bool complete)
 {
-	char *value, *min, *max;
+	char value[PSENSOR_VALUE_STR_SIZE];
+	char min[PSENSOR_VALUE_STR_SIZE];
+	char max[PSENSOR_VALUE_STR_SIZE];
 	struct psensor *s;
+	struct psensor_snapshot snapshot;
 	GtkTreeIter iter;
 	GtkTreeModel *model;
 	gboolean valid;
@@ -137,24 +140,29 @@ void ui_sensorlist_update(struct ui_psensor *ui, bool complete)
 	while (valid) {
 		gtk_tree_model_get(model, &iter, COL_SENSOR, &s, -1);
 
-		value = psensor_value_to_str(s->type,
-						 psensor_get_current_value(s),
-						 use_celsius);
-		min = psensor_value_to_str(s->type,
-					   s->sess_lowest,
-					   use_celsius);
-		max = psensor_value_to_str(s->type,
-					   s->sess_highest,
-					   use_celsius);
+		psensor_get_snapshot(s, &snapshot);
+
+		psensor_value_to_buf(s->type,
+				     snapshot.current.value,
+				     use_celsius,
+				     value,
+				     sizeof(value));
+		psensor_value_to_buf(s->type,
+				     snapshot.sess_lowest,
+				     use_celsius,
+				     min,
+				     sizeof(min));
+		psensor_value_to_buf(s->type,
+				     snapshot.sess_highest,
+				     use_celsius,
+				     max,
+				     sizeof(max));
 
 		gtk_list_store_set(store, &iter,
 				   COL_TEMP, value,
 				   COL_TEMP_MIN, min,
 				   COL_TEMP_MAX, max,
 				   -1);
-		free(value);
-		free(min);
-		free(max);
 
 		valid = gtk_tree_model_iter_next(model, &iter);
 	}
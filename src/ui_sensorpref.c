@@ -273,7 +273,7 @@ static void update_pref(struct psensor *s)
 	int use_celsius, threshold;
 	GdkRGBA *color;
 	const char *chip;
-	char *smin, *smax;
+	char str[PSENSOR_VALUE_STR_SIZE];
 
 	if (!s)
 		return;
@@ -293,19 +293,24 @@ static void update_pref(struct psensor *s)
 	use_celsius = config_get_temperature_unit() == CELSIUS ? 1 : 0;
 
 	if (s->min == UNKNOWN_DBL_VALUE)
-		smin = strdup(_("Unknown"));
+		gtk_label_set_text(w_sensor_min, _("Unknown"));
 	else
-		smin = psensor_value_to_str(s->type, s->min, use_celsius);
-
-	gtk_label_set_text(w_sensor_min, smin);
-	free(smin);
+		gtk_label_set_text(w_sensor_min,
+				   psensor_value_to_buf(s->type,
+							s->min,
+							use_celsius,
+							str,
+							sizeof(str)));
 
 	if (s->max == UNKNOWN_DBL_VALUE)
-		smax = strdup(_("Unknown"));
+		gtk_label_set_text(w_sensor_max, _("Unknown"));
 	else
-		smax = psensor_value_to_str(s->type, s->max, use_celsius);
-	gtk_label_set_text(w_sensor_max, smax);
-	free(smax);
+		gtk_label_set_text(w_sensor_max,
+				   psensor_value_to_buf(s->type,
+							s->max,
+							use_celsius,
+							str,
+							sizeof(str)));
 
 	gtk_toggle_button_set_active(w_sensor_draw,
 				     config_is_sensor_graph_enabled(s->id));
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * Micro-benchmark of the statistics kernels: 'make bench-stats' and
+ * run ./bench-stats.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "../src/lib/stats.h"
+
+/* Size of the columns, the one of the longest rollup tier */
+#define COLUMN_SIZE 432
+#define ITERATIONS 200000
+
+static const char * const ISA_NAMES[] = {"scalar", "sse2", "avx2"};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	measure_value_t v[COLUMN_SIZE];
+	enum stats_isa isa;
+	double t, r, scalar;
+	int i, count;
+
+	srand(1);
+	for (i = 0; i < COLUMN_SIZE; i++)
+		if (rand() % 10)
+			v[i] = 30 + (rand() % 400) / 10.0;
+		else
+			v[i] = UNKNOWN_MEASURE_VALUE;
+
+	scalar = 0;
+	for (isa = STATS_ISA_SCALAR; isa <= STATS_ISA_AVX2; isa++) {
+		if (!stats_select_isa(isa))
+			continue;
+
+		r = 0;
+		t = now();
+		for (i = 0; i < ITERATIONS; i++) {
+			/* prevents hoisting the calls out of the loop */
+			v[i % COLUMN_SIZE] += 0;
+
+			r += stats_min(v, COLUMN_SIZE);
+			r += stats_max(v, COLUMN_SIZE);
+			r += stats_sum(v, COLUMN_SIZE, &count);
+		}
+		t = (now() - t) * 1e9 / ITERATIONS;
+
+		if (isa == STATS_ISA_SCALAR)
+			scalar = t;
+
+		printf("%-6s %8.1f ns per min/max/sum of %d values",
+		       ISA_NAMES[isa], t, COLUMN_SIZE);
+		printf(", x%.1f (%g)\n", scalar / t, r);
+	}
+
+	return EXIT_SUCCESS;
+}
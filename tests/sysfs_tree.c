@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#define _XOPEN_SOURCE 700
+#include <ftw.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sysfs_tree.h"
+
+static char root[64];
+
+const char *sysfs_tree_create(const char *name)
+{
+	snprintf(root, sizeof(root), "/tmp/test-%s-XXXXXX", name);
+
+	if (!mkdtemp(root)) {
+		perror(root);
+		exit(EXIT_FAILURE);
+	}
+
+	return root;
+}
+
+void sysfs_tree_mkdir(const char *path)
+{
+	char buf[256];
+
+	snprintf(buf, sizeof(buf), "%s/%s", root, path);
+
+	if (mkdir(buf, 0700)) {
+		perror(buf);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void sysfs_tree_write(const char *path, const char *content)
+{
+	char buf[256];
+	FILE *f;
+
+	snprintf(buf, sizeof(buf), "%s/%s", root, path);
+
+	f = fopen(buf, "w");
+	if (!f) {
+		perror(buf);
+		exit(EXIT_FAILURE);
+	}
+
+	fputs(content, f);
+	fclose(f);
+}
+
+void sysfs_tree_symlink(const char *target, const char *path)
+{
+	char buf[256];
+
+	snprintf(buf, sizeof(buf), "%s/%s", root, path);
+
+	if (symlink(target, buf)) {
+		perror(buf);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static int remove_file(const char *path,
+		       const struct stat *st,
+		       int flag,
+		       struct FTW *ftw)
+{
+	return remove(path);
+}
+
+void sysfs_tree_remove(void)
+{
+	nftw(root, remove_file, 8, FTW_DEPTH | FTW_PHYS);
+}
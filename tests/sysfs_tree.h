@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef _PSENSOR_TESTS_SYSFS_TREE_H_
+#define _PSENSOR_TESTS_SYSFS_TREE_H_
+
+/*
+ * Fake sysfs trees of the provider tests, the tree is created in a
+ * temporary directory. Any failure while creating it exits the test.
+ */
+
+/* Creates the root directory, 'name' is appended to its prefix */
+const char *sysfs_tree_create(const char *name);
+
+void sysfs_tree_mkdir(const char *path);
+
+void sysfs_tree_write(const char *path, const char *content);
+
+/* Creates the link 'path' to 'target', relative to the link. */
+void sysfs_tree_symlink(const char *target, const char *path);
+
+/* Removes the whole tree */
+void sysfs_tree_remove(void);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/lib/cpufreq.h"
+
+#include "sysfs_tree.h"
+
+static void create_cpu(int cpu, const char *freq, const char *count)
+{
+	char dir[16], path[64];
+
+	snprintf(dir, sizeof(dir), "cpu%d", cpu);
+	sysfs_tree_mkdir(dir);
+
+	snprintf(path, sizeof(path), "%s/cpufreq", dir);
+	sysfs_tree_mkdir(path);
+	snprintf(path, sizeof(path), "%s/cpufreq/scaling_cur_freq", dir);
+	sysfs_tree_write(path, freq);
+
+	snprintf(path, sizeof(path), "%s/topology", dir);
+	sysfs_tree_mkdir(path);
+	snprintf(path, sizeof(path), "%s/topology/physical_package_id", dir);
+	sysfs_tree_write(path, "0\n");
+
+	snprintf(path, sizeof(path), "%s/thermal_throttle", dir);
+	sysfs_tree_mkdir(path);
+	snprintf(path,
+		 sizeof(path),
+		 "%s/thermal_throttle/core_throttle_count",
+		 dir);
+	sysfs_tree_write(path, count);
+	snprintf(path,
+		 sizeof(path),
+		 "%s/thermal_throttle/package_throttle_count",
+		 dir);
+	sysfs_tree_write(path, "10\n");
+}
+
+/*
+ * Creates a fake CPU tree: two cores of the same package, listed
+ * after 'cpu10' by alphasort(), and a directory which is not a CPU.
+ */
+static void create_tree(void)
+{
+	create_cpu(2, "800000\n", "0\n");
+	create_cpu(10, "2400000\n", "5\n");
+	sysfs_tree_write("cpu10/cpufreq/cpuinfo_max_freq", "3600000\n");
+
+	sysfs_tree_mkdir("cpufreq");
+}
+
+static int check(struct psensor *s, const char *id, double v)
+{
+	if (strcmp(s->id, id) || psensor_get_current_value(s) != v) {
+		fprintf(stderr,
+			"FAILURE: %s is %f instead of %s %f\n",
+			s->id, psensor_get_current_value(s), id, v);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	struct psensor_registry r;
+	struct psensor **sensors;
+	int failures;
+
+	root = sysfs_tree_create("cpufreq");
+
+	create_tree();
+
+	psensor_registry_init(&r);
+	cpufreq_psensor_list_append(&r, root, 10);
+
+	failures = 0;
+
+	if (psensor_registry_size(&r) != 5) {
+		fprintf(stderr,
+			"FAILURE: %d sensors\n", psensor_registry_size(&r));
+		failures++;
+	} else {
+		sensors = psensor_registry_list(&r);
+
+		/* the first update only reads the counters */
+		cpufreq_psensor_list_update(sensors);
+		failures += check(sensors[0], "cpufreq cpu2 frequency", 800);
+		failures += check(sensors[1],
+				  "cpufreq cpu2 throttling",
+				  UNKNOWN_DBL_VALUE);
+		failures += check(sensors[2],
+				  "cpufreq package0 throttling",
+				  UNKNOWN_DBL_VALUE);
+		failures += check(sensors[3], "cpufreq cpu10 frequency", 2400);
+
+		if (sensors[3]->max != 3600)
+			failures++;
+
+		usleep(10000);
+		sysfs_tree_write("cpu10/thermal_throttle/core_throttle_count",
+			   "9\n");
+		cpufreq_psensor_list_update(sensors);
+
+		failures += check(sensors[1], "cpufreq cpu2 throttling", 0);
+		if (psensor_get_current_value(sensors[4]) <= 0)
+			failures++;
+	}
+
+	psensor_registry_free(&r);
+	cpufreq_cleanup();
+
+	sysfs_tree_remove();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/cpustat.h"
+
+#include "sysfs_tree.h"
+
+/* Times of the first update, beyond 2^32 jiffies */
+static const char *STAT1 =
+	"cpu  15000000900 0 0 0 0 0 0 0 0 0\n"
+	"cpu0 5000000000 100 200 1000 100 0 0 0 0 0\n"
+	"cpu1 5000000000 0 0 1000 0 0 0 0 0 0\n"
+	"cpu2 10 0 0 1000 0 0 0 0 0 0\n"
+	"cpu4 10 0 0 1000 0 0 0 0 0 0\n"
+	"intr 1 2 3\n"
+	"ctxt 42\n";
+
+/* 'cpu0': 50% and 'cpu1': 25%, 'cpu2' is idle, 'cpu4' is busy */
+static const char *STAT2 =
+	"cpu  15000001075 0 0 0 0 0 0 0 0 0\n"
+	"cpu0 5000000030 100 210 1040 110 0 5 5 0 0\n"
+	"cpu1 5000000025 0 0 1075 0 0 0 0 0 0\n"
+	"cpu2 10 0 0 1100 0 0 0 0 0 0\n"
+	"cpu4 110 0 0 1000 0 0 0 0 0 0\n"
+	"intr 1 2 3\n"
+	"ctxt 42\n";
+
+static void create_cpu(int cpu, const char *pkg)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "cpu%d", cpu);
+	sysfs_tree_mkdir(path);
+
+	snprintf(path, sizeof(path), "cpu%d/topology", cpu);
+	sysfs_tree_mkdir(path);
+
+	snprintf(path, sizeof(path), "cpu%d/topology/physical_package_id", cpu);
+	sysfs_tree_write(path, pkg);
+}
+
+/* CPU 3 is offline, the package of CPU 4 is unknown */
+static void create_tree(void)
+{
+	sysfs_tree_write("stat", STAT1);
+
+	create_cpu(0, "0\n");
+	create_cpu(1, "0\n");
+	create_cpu(2, "1\n");
+	create_cpu(3, "1\n");
+}
+
+static int check(struct psensor *s, const char *id, double v)
+{
+	if (strcmp(s->id, id) || psensor_get_current_value(s) != v) {
+		fprintf(stderr,
+			"FAILURE: %s is %f instead of %s %f\n",
+			s->id, psensor_get_current_value(s), id, v);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_parse(void)
+{
+	struct cpustat_times times[2];
+	int failures, n;
+
+	failures = 0;
+
+	memset(times, 0, sizeof(times));
+	n = cpustat_parse(STAT1, times, 2);
+
+	if (n != 5)
+		failures++;
+
+	if (times[0].used != 5000000300ULL || times[0].total != 5000001400ULL)
+		failures++;
+
+	if (times[1].used != 5000000000ULL || times[1].total != 5000001000ULL)
+		failures++;
+
+	if (failures)
+		fprintf(stderr, "FAILURE: wrong parsing of /proc/stat\n");
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	struct psensor_registry r;
+	struct psensor **sensors;
+	char path[64];
+	int failures;
+
+	failures = test_parse();
+
+	root = sysfs_tree_create("cpustat");
+
+	create_tree();
+
+	snprintf(path, sizeof(path), "%s/stat", root);
+
+	psensor_registry_init(&r);
+	cpustat_psensor_list_append(&r, path, root, 10);
+
+	if (psensor_registry_size(&r) != 6) {
+		fprintf(stderr,
+			"FAILURE: %d sensors\n", psensor_registry_size(&r));
+		failures++;
+	} else {
+		sensors = psensor_registry_list(&r);
+
+		/* the first update only reads the times */
+		cpustat_psensor_list_update(sensors);
+		failures += check(sensors[0],
+				  "cpustat cpu0 usage",
+				  UNKNOWN_DBL_VALUE);
+
+		/* the file is kept open, the new content is read */
+		sysfs_tree_write("stat", STAT2);
+		cpustat_psensor_list_update(sensors);
+
+		failures += check(sensors[0], "cpustat cpu0 usage", 50);
+		failures += check(sensors[1], "cpustat cpu1 usage", 25);
+		failures += check(sensors[2], "cpustat cpu2 usage", 0);
+		failures += check(sensors[3], "cpustat cpu4 usage", 100);
+		failures += check(sensors[4], "cpustat package0 usage", 37.5);
+		failures += check(sensors[5], "cpustat package1 usage", 0);
+	}
+
+	psensor_registry_free(&r);
+	cpustat_cleanup();
+
+	sysfs_tree_remove();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
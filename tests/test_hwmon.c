@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/hwmon.h"
+
+#include "sysfs_tree.h"
+
+/* Directory of the hwmon devices in the fake tree */
+#define HWMON "class/hwmon/"
+
+/* Prefix of the identifiers of the sensors of the CPU chip */
+#define CPU_ID "hwmon coretemp-platform-coretemp.0 "
+
+/*
+ * Creates a fake sysfs tree: a CPU chip with a faulty input, a chip
+ * of an old driver whose attributes are in the device directory and
+ * a virtual chip.
+ */
+static void create_tree(void)
+{
+	sysfs_tree_mkdir("class");
+	sysfs_tree_mkdir("class/hwmon");
+	sysfs_tree_mkdir("devices");
+	sysfs_tree_mkdir("devices/platform");
+
+	sysfs_tree_mkdir("devices/platform/coretemp.0");
+	sysfs_tree_symlink("../../../bus/platform",
+			   "devices/platform/coretemp.0/subsystem");
+
+	sysfs_tree_mkdir(HWMON "hwmon0");
+	sysfs_tree_symlink("../../../devices/platform/coretemp.0",
+			   HWMON "hwmon0/device");
+	sysfs_tree_write(HWMON "hwmon0/name", "coretemp\n");
+	sysfs_tree_write(HWMON "hwmon0/temp1_input", "45000\n");
+	sysfs_tree_write(HWMON "hwmon0/temp1_label", "Core 0\n");
+	sysfs_tree_write(HWMON "hwmon0/temp1_max", "80000\n");
+	sysfs_tree_write(HWMON "hwmon0/temp1_crit_alarm", "0\n");
+	sysfs_tree_write(HWMON "hwmon0/temp2_input", "-1500\n");
+	sysfs_tree_write(HWMON "hwmon0/temp3_input", "20000\n");
+	sysfs_tree_write(HWMON "hwmon0/temp3_fault", "1\n");
+
+	sysfs_tree_mkdir("devices/platform/it87.656");
+	sysfs_tree_symlink("../../../bus/platform",
+			   "devices/platform/it87.656/subsystem");
+	sysfs_tree_write("devices/platform/it87.656/name", "it87\n");
+	sysfs_tree_write("devices/platform/it87.656/fan1_input", "1200\n");
+	sysfs_tree_write("devices/platform/it87.656/fan1_min", "300\n");
+
+	sysfs_tree_mkdir(HWMON "hwmon1");
+	sysfs_tree_symlink("../../../devices/platform/it87.656",
+			   HWMON "hwmon1/device");
+
+	sysfs_tree_mkdir(HWMON "hwmon2");
+	sysfs_tree_write(HWMON "hwmon2/name", "acpitz\n");
+	sysfs_tree_write(HWMON "hwmon2/temp1_input", "27500\n");
+}
+
+static int check(struct psensor *s, const char *id, double v)
+{
+	if (strcmp(s->id, id) || psensor_get_current_value(s) != v) {
+		fprintf(stderr,
+			"FAILURE: %s is %f instead of %s %f\n",
+			s->id, psensor_get_current_value(s), id, v);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void cb_alarm(struct psensor *s, void *data)
+{
+	(*(int *)data)++;
+}
+
+int main(int argc, char **argv)
+{
+	char root[256];
+	struct psensor_registry r;
+	struct psensor **sensors;
+	int failures, alarms;
+
+	snprintf(root, sizeof(root), "%s/" HWMON, sysfs_tree_create("hwmon"));
+
+	create_tree();
+
+	psensor_registry_init(&r);
+	hwmon_psensor_list_append(&r, root, 10);
+
+	failures = 0;
+
+	if (psensor_registry_size(&r) != 4) {
+		fprintf(stderr,
+			"FAILURE: %d sensors\n", psensor_registry_size(&r));
+		failures++;
+	} else {
+		sensors = psensor_registry_list(&r);
+
+		hwmon_psensor_list_update(sensors);
+		failures += check(sensors[0], CPU_ID "Core 0", 45);
+		failures += check(sensors[1], CPU_ID "temp2", -1.5);
+		failures += check(sensors[2],
+				  "hwmon it87-platform-it87.656 fan1",
+				  1200);
+		failures += check(sensors[3],
+				  "hwmon acpitz-hwmon2 temp1",
+				  27.5);
+
+		if (sensors[0]->max != 80 || sensors[2]->min != 300)
+			failures++;
+
+		/* the files stay open, the new content is read */
+		sysfs_tree_write(HWMON "hwmon0/temp1_input", "47250\n");
+		hwmon_psensor_list_update(sensors);
+		failures += check(sensors[0], CPU_ID "Core 0", 47.25);
+
+		/* the regular files are never notified */
+		alarms = 0;
+		if (!hwmon_alarm_watch_start(sensors, cb_alarm, &alarms)) {
+			fprintf(stderr, "FAILURE: alarms not watched\n");
+			failures++;
+		}
+		hwmon_alarm_watch_stop();
+
+		if (alarms)
+			failures++;
+
+		/* fan1 has no alarm attribute */
+		if (hwmon_alarm_watch_start(sensors + 2, cb_alarm, &alarms)) {
+			fprintf(stderr, "FAILURE: alarms of fan1 watched\n");
+			failures++;
+		}
+	}
+
+	psensor_registry_free(&r);
+
+	sysfs_tree_remove();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../src/lib/measure_archive.h"
+
+#define BASE_TIME 1400000000
+
+/* Slowly changing temperature measured every second with jitter. */
+static double value_at(int i)
+{
+	if (i % 1000 == 999)
+		return UNKNOWN_DBL_VALUE;
+
+	return 40 + (i / 300) % 20 + ((i / 60) % 2) * 0.5;
+}
+
+static struct timeval time_at(int i)
+{
+	struct timeval tv;
+
+	tv.tv_sec = BASE_TIME + i;
+	tv.tv_usec = ((i * 7) % 5) * 1000;
+
+	return tv;
+}
+
+static void push(struct measure_archive *a, int first, int last)
+{
+	int i;
+
+	for (i = first; i <= last; i++)
+		measure_archive_push(a, value_at(i), time_at(i));
+}
+
+static int check_measure(const struct measure *m, int i)
+{
+	struct timeval tv;
+
+	tv = time_at(i);
+
+	if (m->value != value_at(i)
+	    || m->time.tv_sec != tv.tv_sec
+	    || m->time.tv_usec != tv.tv_usec) {
+		fprintf(stderr,
+			"FAILURE: measure %d is %f at %ld.%06ld\n",
+			i, m->value, (long)m->time.tv_sec,
+			(long)m->time.tv_usec);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Checks that 'a' contains the measures 'first' to 'last'. */
+static int check_archive(const struct measure_archive *a, int first, int last)
+{
+	struct measure_archive_cursor cur;
+	struct measure m;
+	int i, j, failures;
+	bool ok;
+
+	failures = 0;
+
+	if (measure_archive_length(a) != last - first + 1) {
+		fprintf(stderr, "FAILURE: length %d\n",
+			measure_archive_length(a));
+		return 1;
+	}
+
+	i = first;
+	for (ok = measure_archive_first(a, &cur);
+	     ok;
+	     ok = measure_archive_next(a, &cur))
+		for (j = 0; j < cur.count; j++, i++) {
+			measure_archive_cursor_get(&cur, j, &m);
+			if (!check_measure(&m, i))
+				failures++;
+		}
+
+	if (i != last + 1)
+		failures++;
+
+	i = last;
+	for (ok = measure_archive_last(a, &cur);
+	     ok;
+	     ok = measure_archive_prev(a, &cur))
+		for (j = cur.count - 1; j >= 0; j--, i--) {
+			measure_archive_cursor_get(&cur, j, &m);
+			if (!check_measure(&m, i))
+				failures++;
+		}
+
+	if (i != first - 1)
+		failures++;
+
+	j = measure_archive_seek(a, 1000, &cur);
+	measure_archive_cursor_get(&cur, j, &m);
+	if (!check_measure(&m, first + 1000))
+		failures++;
+
+	if (measure_archive_seek(a, last - first + 1, &cur) != -1)
+		failures++;
+
+	return failures;
+}
+
+static int test_compression(void)
+{
+	struct measure_archive a;
+	int failures;
+	size_t size;
+
+	failures = 0;
+
+	measure_archive_init(&a, 24 * 3600);
+
+	push(&a, 0, 24 * 3600 - 1);
+	failures += check_archive(&a, 0, 24 * 3600 - 1);
+
+	/* an uncompressed measure takes 16 bytes */
+	size = measure_archive_size(&a);
+	if (size > 3 * 24 * 3600) {
+		fprintf(stderr, "FAILURE: size %zu\n", size);
+		failures++;
+	}
+
+	measure_archive_free(&a);
+
+	return failures;
+}
+
+static int test_eviction(void)
+{
+	struct measure_archive a;
+	struct measure_archive_cursor cur;
+	int failures;
+
+	failures = 0;
+
+	measure_archive_init(&a, 1000);
+
+	/* the oldest blocks are evicted while being iterated */
+	push(&a, 0, 1999);
+	measure_archive_first(&a, &cur);
+	push(&a, 2000, 2999);
+	measure_archive_next(&a, &cur);
+	measure_archive_release(&a);
+
+	if (cur.seq != a.first->seq)
+		failures++;
+
+	/* blocks whose last measure is older than 1000s are evicted */
+	failures += check_archive(&a,
+				  a.first->seq * MEASURE_BLOCK_SIZE,
+				  2999);
+	if (a.first->last_time / 1000 < BASE_TIME + 2999 - 1000)
+		failures++;
+
+	measure_archive_free(&a);
+
+	return failures;
+}
+
+static int test_time_jump(void)
+{
+	struct measure_archive a;
+	struct measure_archive_cursor cur;
+	struct measure m;
+	struct timeval tv;
+	int failures;
+
+	failures = 0;
+
+	measure_archive_init(&a, 365 * 24 * 3600);
+
+	push(&a, 0, 9);
+	tv = time_at(10);
+	tv.tv_sec += 100 * 24 * 3600;
+	measure_archive_push(&a, 55, tv);
+
+	measure_archive_last(&a, &cur);
+	measure_archive_cursor_get(&cur, cur.count - 1, &m);
+	if (cur.count != 1 || m.value != 55 || m.time.tv_sec != tv.tv_sec)
+		failures++;
+
+	measure_archive_prev(&a, &cur);
+	measure_archive_cursor_get(&cur, cur.count - 1, &m);
+	if (cur.count != 10 || !check_measure(&m, 9))
+		failures++;
+
+	measure_archive_free(&a);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	if (test_compression() || test_eviction() || test_time_jump())
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/powercap.h"
+
+#include "sysfs_tree.h"
+
+/*
+ * Creates a fake powercap tree: the control type without counter, a
+ * package zone with a subzone and a psys zone.
+ */
+static void create_tree(void)
+{
+	sysfs_tree_mkdir("intel-rapl");
+	sysfs_tree_write("intel-rapl/enabled", "1\n");
+
+	sysfs_tree_mkdir("intel-rapl:0");
+	sysfs_tree_write("intel-rapl:0/name", "package-0\n");
+	sysfs_tree_write("intel-rapl:0/energy_uj", "262143000000\n");
+	sysfs_tree_write("intel-rapl:0/max_energy_range_uj", "262143328850\n");
+	sysfs_tree_write("intel-rapl:0/constraint_0_max_power_uw",
+			 "15000000\n");
+
+	sysfs_tree_mkdir("intel-rapl:0:0");
+	sysfs_tree_write("intel-rapl:0:0/name", "core\n");
+	sysfs_tree_write("intel-rapl:0:0/energy_uj", "5000\n");
+
+	sysfs_tree_mkdir("intel-rapl:1");
+	sysfs_tree_write("intel-rapl:1/name", "psys\n");
+	sysfs_tree_write("intel-rapl:1/energy_uj", "7000\n");
+}
+
+static int check_power(uint64_t last,
+		       uint64_t cur,
+		       uint64_t range,
+		       int64_t us,
+		       double ref)
+{
+	double w;
+
+	w = powercap_get_power(last, cur, range, us);
+	if (w != ref) {
+		fprintf(stderr, "FAILURE: %f W instead of %f W\n", w, ref);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int check_id(struct psensor *s, const char *id)
+{
+	if (strcmp(s->id, id)) {
+		fprintf(stderr, "FAILURE: %s instead of %s\n", s->id, id);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	struct psensor_registry r;
+	struct psensor **sensors;
+	int failures;
+
+	failures = check_power(1000, 3000, 0, 1000, 2);
+	/* wraparound */
+	failures += check_power(9000, 1000, 10000, 2000, 1);
+	failures += check_power(9000, 1000, 0, 2000, UNKNOWN_DBL_VALUE);
+	failures += check_power(1000, 1000, 0, 0, UNKNOWN_DBL_VALUE);
+
+	root = sysfs_tree_create("powercap");
+
+	create_tree();
+
+	psensor_registry_init(&r);
+	powercap_psensor_list_append(&r, root, 10);
+
+	sensors = psensor_registry_get_type(&r, PSENSOR_VALUE_POWER);
+
+	if (psensor_registry_size(&r) != 3 || !sensors[2]) {
+		fprintf(stderr,
+			"FAILURE: %d sensors\n", psensor_registry_size(&r));
+		failures++;
+	} else {
+		failures += check_id(sensors[0],
+				     "powercap intel-rapl:0 package-0");
+		failures += check_id(sensors[1],
+				     "powercap intel-rapl:0:0 package-0 core");
+		failures += check_id(sensors[2], "powercap intel-rapl:1 psys");
+
+		if (sensors[0]->max != 15)
+			failures++;
+
+		/* the first update only reads the counters */
+		powercap_psensor_list_update(sensors);
+		if (psensor_get_current_value(sensors[0])
+		    != UNKNOWN_DBL_VALUE)
+			failures++;
+
+		/* the counter of the package wraps around */
+		sysfs_tree_write("intel-rapl:0/energy_uj", "1000\n");
+		sysfs_tree_write("intel-rapl:0:0/energy_uj", "6000\n");
+		powercap_psensor_list_update(sensors);
+
+		if (psensor_get_current_value(sensors[0]) <= 0
+		    || psensor_get_current_value(sensors[1]) <= 0
+		    || psensor_get_current_value(sensors[2]) != 0) {
+			fprintf(stderr, "FAILURE: wrong powers\n");
+			failures++;
+		}
+	}
+
+	psensor_registry_free(&r);
+	powercap_cleanup();
+
+	sysfs_tree_remove();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
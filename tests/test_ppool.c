@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/lib/ppool.h"
+#include "../src/lib/psched.h"
+
+/* Duration of a job in milliseconds */
+#define JOB_DURATION 100
+
+#define JOBS_COUNT 4
+
+static void run_sleep(void *data)
+{
+	usleep(JOB_DURATION * 1000);
+
+	__atomic_add_fetch((int *)data, 1, __ATOMIC_RELAXED);
+}
+
+/* Checks that the jobs run concurrently. */
+static int test_concurrency(void)
+{
+	struct ppool p;
+	struct ppool_job jobs[JOBS_COUNT];
+	int i, n, failures;
+	int64_t t;
+
+	failures = 0;
+	n = 0;
+
+	if (!ppool_init(&p, JOBS_COUNT))
+		return 1;
+
+	t = psched_get_time();
+
+	for (i = 0; i < JOBS_COUNT; i++) {
+		ppool_job_init(&jobs[i], run_sleep, &n);
+		ppool_submit(&p, &jobs[i]);
+	}
+
+	if (ppool_submit(&p, &jobs[0]))
+		failures++;
+
+	if (ppool_wait(&p, -1) || n != JOBS_COUNT)
+		failures++;
+
+	t = psched_get_time() - t;
+	if (t >= 2 * JOB_DURATION) {
+		fprintf(stderr, "FAILURE: jobs run in %ldms\n", (long)t);
+		failures++;
+	}
+
+	ppool_free(&p);
+
+	return failures;
+}
+
+/* Checks that waiting stops at the deadline and that freeing waits. */
+static int test_deadline(void)
+{
+	struct ppool p;
+	struct ppool_job jobs[JOBS_COUNT];
+	int i, n, failures;
+
+	failures = 0;
+	n = 0;
+
+	if (!ppool_init(&p, 1))
+		return 1;
+
+	for (i = 0; i < JOBS_COUNT; i++) {
+		ppool_job_init(&jobs[i], run_sleep, &n);
+		ppool_submit(&p, &jobs[i]);
+	}
+
+	if (!ppool_wait(&p, psched_get_time() + JOB_DURATION / 2))
+		failures++;
+
+	ppool_free(&p);
+
+	if (n != JOBS_COUNT)
+		failures++;
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	if (test_concurrency() || test_deadline())
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/lib/preader.h"
+
+#include "sysfs_tree.h"
+
+/* Reads of a run, more than a submission of the ring */
+#define READS_COUNT (PREADER_RING_SIZE + 8)
+
+#define CONTENT "45000\n"
+
+/* Size of the buffers, larger than CONTENT: the reads are short */
+#define BUFFER_SIZE 32
+
+/* Index of the read of an invalid file descriptor */
+#define BAD_FD_READ 5
+
+/* Index of the read into a buffer smaller than CONTENT */
+#define TRUNCATED_READ 7
+#define TRUNCATED_SIZE 2
+
+static char bufs[READS_COUNT][BUFFER_SIZE];
+
+static int check_reads(struct preader *r, const char *name)
+{
+	struct preader_req *q;
+	int i, failures;
+	ssize_t ret;
+
+	if (r->count != READS_COUNT) {
+		fprintf(stderr, "FAILURE: %s: %d reads\n", name, r->count);
+		return 1;
+	}
+
+	failures = 0;
+
+	for (i = 0; i < r->count; i++) {
+		q = &r->reqs[i];
+
+		if (i == BAD_FD_READ)
+			ret = -EBADF;
+		else if (i == TRUNCATED_READ)
+			ret = TRUNCATED_SIZE;
+		else
+			ret = strlen(CONTENT);
+
+		if (q->ret != ret
+		    || (ret > 0 && strncmp(q->buf, CONTENT, ret))) {
+			fprintf(stderr,
+				"FAILURE: %s: read %d returned %zd instead of %zd\n",
+				name, i, q->ret, ret);
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+/* Adds the reads checked by check_reads(). */
+static void add_reads(struct preader *r, int fd)
+{
+	int i;
+
+	preader_clear(r);
+	memset(bufs, 0, sizeof(bufs));
+
+	for (i = 0; i < READS_COUNT; i++)
+		if (i == BAD_FD_READ)
+			preader_add(r, -1, bufs[i], BUFFER_SIZE);
+		else if (i == TRUNCATED_READ)
+			preader_add(r, fd, bufs[i], TRUNCATED_SIZE);
+		else
+			preader_add(r, fd, bufs[i], BUFFER_SIZE);
+}
+
+/* Reads with the ring when psensor is built with liburing. */
+static int test_run(int fd)
+{
+	struct preader r;
+	int failures;
+
+	preader_init(&r);
+
+	add_reads(&r, fd);
+	preader_run(&r);
+	failures = check_reads(&r, "run");
+
+	/* the reads and the ring are reused by the next run */
+	add_reads(&r, fd);
+	preader_run(&r);
+	failures += check_reads(&r, "second run");
+
+	preader_free(&r);
+
+	return failures;
+}
+
+/* Reads with pread() when the ring cannot be created. */
+static int test_ring_failure(int fd)
+{
+	struct preader r;
+	int failures;
+
+	preader_init(&r);
+	r.ring_failed = true;
+
+	add_reads(&r, fd);
+	preader_run(&r);
+	failures = check_reads(&r, "ring failure");
+
+	if (r.ring) {
+		fprintf(stderr, "FAILURE: ring created\n");
+		failures++;
+	}
+
+	preader_free(&r);
+
+	return failures;
+}
+
+/* A single read is done with pread(), the ring is not created. */
+static int test_single_read(int fd)
+{
+	struct preader r;
+	char buf[BUFFER_SIZE];
+	int failures;
+
+	preader_init(&r);
+	failures = 0;
+
+	if (preader_add(&r, fd, buf, sizeof(buf)) != 0)
+		failures++;
+
+	preader_run(&r);
+
+	if (r.reqs[0].ret != strlen(CONTENT)
+	    || strncmp(buf, CONTENT, strlen(CONTENT))) {
+		fprintf(stderr, "FAILURE: single read\n");
+		failures++;
+	}
+
+	if (r.ring) {
+		fprintf(stderr, "FAILURE: ring created for a single read\n");
+		failures++;
+	}
+
+	preader_free(&r);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	char path[256];
+	int fd, failures;
+
+	snprintf(path,
+		 sizeof(path),
+		 "%s/temp1_input",
+		 sysfs_tree_create("preader"));
+	sysfs_tree_write("temp1_input", CONTENT);
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	failures = test_run(fd);
+	failures += test_ring_failure(fd);
+	failures += test_single_read(fd);
+
+	close(fd);
+	sysfs_tree_remove();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../src/lib/psched.h"
+
+static void count_run(void *data)
+{
+	(*(int *)data)++;
+}
+
+/* Checks the number of runs of tasks of different periods. */
+static int test_periods(void)
+{
+	struct psched s;
+	int fast, slow, late, failures;
+	int64_t now;
+
+	failures = 0;
+	fast = 0;
+	slow = 0;
+	late = 0;
+
+	psched_init(&s);
+
+	psched_add(&s, 250, count_run, &fast, 0);
+	psched_add(&s, 30000, count_run, &slow, 0);
+	psched_add(&s, 1000, count_run, &late, 500);
+
+	if (psched_get_next_deadline(&s) != 0)
+		failures++;
+
+	for (now = 0; now < 60000; now = psched_get_next_deadline(&s))
+		psched_run_due(&s, now);
+
+	if (fast != 240 || slow != 2 || late != 60) {
+		fprintf(stderr, "FAILURE: %d %d %d runs\n", fast, slow, late);
+		failures++;
+	}
+
+	psched_free(&s);
+
+	return failures;
+}
+
+/*
+ * Checks that the missed runs of a late task are skipped and counted
+ * and that the deadlines do not drift.
+ */
+static int test_late(void)
+{
+	struct psched s;
+	struct psched_task *t;
+	int n, failures;
+
+	failures = 0;
+	n = 0;
+
+	psched_init(&s);
+
+	t = psched_add(&s, 100, count_run, &n, 0);
+
+	if (psched_run_due(&s, 1050) != 1 || n != 1)
+		failures++;
+
+	if (psched_get_next_deadline(&s) != 1100 || t->overruns != 10)
+		failures++;
+
+	psched_run_due(&s, 1130);
+
+	if (psched_get_next_deadline(&s) != 1200 || t->overruns != 10)
+		failures++;
+
+	psched_task_set_interval(t, 0);
+	psched_run_due(&s, 1200);
+
+	if (t->interval != 1 || psched_get_next_deadline(&s) != 1201)
+		failures++;
+
+	psched_free(&s);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	if (test_periods() || test_late())
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
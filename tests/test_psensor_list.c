@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/pregistry.h"
+#include "../src/lib/psensor.h"
+
+static struct psensor *create_typed_sensor(int i, unsigned int type)
+{
+	char *id;
+
+	id = malloc(32);
+	sprintf(id, "test %d", i);
+
+	return psensor_create(id, strdup("test"), NULL, type, 2);
+}
+
+static struct psensor *create_sensor(int i)
+{
+	return create_typed_sensor(i, SENSOR_TYPE_TEMP);
+}
+
+static int check_get_by_id(struct psensor **sensors, int i, bool present)
+{
+	struct psensor *s;
+	char id[32];
+
+	sprintf(id, "test %d", i);
+
+	s = psensor_list_get_by_id(sensors, id);
+
+	if ((present && (!s || strcmp(s->id, id))) || (!present && s)) {
+		fprintf(stderr, "FAILURE: lookup of %s\n", id);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_get_by_id(void)
+{
+	struct psensor **sensors, *s, *other[2];
+	int i, n, failures;
+
+	failures = 0;
+	n = 500;
+
+	sensors = malloc(sizeof(struct psensor *));
+	*sensors = NULL;
+
+	for (i = 0; i < n; i++)
+		psensor_list_append(&sensors, create_sensor(i));
+
+	for (i = 0; i < n; i++)
+		if (!check_get_by_id(sensors, i, true))
+			failures++;
+
+	if (!check_get_by_id(sensors, n, false))
+		failures++;
+
+	/* a freed sensor is no longer indexed */
+	s = sensors[n - 1];
+	sensors[n - 1] = NULL;
+	psensor_free(s);
+
+	if (!check_get_by_id(sensors, n - 1, false))
+		failures++;
+
+	/* not indexed sensor */
+	other[0] = create_sensor(n);
+	other[1] = NULL;
+
+	if (!check_get_by_id(other, n, true))
+		failures++;
+
+	psensor_free(other[0]);
+
+	psensor_list_free(sensors);
+
+	sensors = malloc(sizeof(struct psensor *));
+	*sensors = NULL;
+
+	if (!check_get_by_id(sensors, 0, false))
+		failures++;
+
+	free(sensors);
+
+	return failures;
+}
+
+/* Checks that a NULL terminated list contains 'n' sensors of 'type'. */
+static int check_sublist(struct psensor **sensors, int n, unsigned int type)
+{
+	int i;
+
+	for (i = 0; sensors[i]; i++)
+		if (!(sensors[i]->type & type))
+			break;
+
+	if (i != n || sensors[i]) {
+		fprintf(stderr, "FAILURE: sublist of type %x\n", type);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_registry(void)
+{
+	struct psensor_registry r;
+	struct psensor *s;
+	unsigned int type;
+	int i, n, failures;
+
+	failures = 0;
+	n = 300;
+
+	psensor_registry_init(&r);
+
+	for (i = 0; i < n; i++) {
+		if (i % 3 == 0)
+			type = SENSOR_TYPE_LMSENSOR | SENSOR_TYPE_TEMP;
+		else if (i % 3 == 1)
+			type = SENSOR_TYPE_LMSENSOR | SENSOR_TYPE_RPM;
+		else
+			type = SENSOR_TYPE_REMOTE
+				| SENSOR_TYPE_LMSENSOR
+				| SENSOR_TYPE_PERCENT;
+
+		s = create_typed_sensor(i, type);
+		psensor_registry_add(&r, s);
+
+		if (psensor_registry_size(&r) != i + 1
+		    || psensor_registry_get(&r, i) != s)
+			failures++;
+	}
+
+	psensor_registry_add(&r, NULL);
+
+	if (psensor_registry_size(&r) != n
+	    || psensor_registry_list(&r)[n]
+	    || !check_get_by_id(psensor_registry_list(&r), n / 2, true))
+		failures++;
+
+	if (!check_sublist(psensor_registry_get_provider
+			   (&r, PSENSOR_PROVIDER_LMSENSOR),
+			   2 * n / 3,
+			   SENSOR_TYPE_LMSENSOR)
+	    || !check_sublist(psensor_registry_get_provider
+			      (&r, PSENSOR_PROVIDER_REMOTE),
+			      n / 3,
+			      SENSOR_TYPE_REMOTE)
+	    || !check_sublist(psensor_registry_get_provider
+			      (&r, PSENSOR_PROVIDER_HDDTEMP),
+			      0,
+			      SENSOR_TYPE_HDDTEMP)
+	    || !check_sublist(psensor_registry_get_type(&r, PSENSOR_VALUE_RPM),
+			      n / 3,
+			      SENSOR_TYPE_RPM))
+		failures++;
+
+	psensor_registry_free(&r);
+
+	if (!check_get_by_id(NULL, 0, false))
+		failures++;
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	if (test_get_by_id() || test_registry())
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,714 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/pregistry.h"
+#include "../src/lib/psensor.h"
+
+static struct psensor *create_sensor(int n)
+{
+	struct psensor *s;
+
+	s = psensor_create(strdup("test"),
+			   strdup("test"),
+			   NULL,
+			   SENSOR_TYPE_TEMP,
+			   n);
+	psensor_set_history_enabled(s, true);
+
+	return s;
+}
+
+static void add_values(struct psensor *s, int first, int last)
+{
+	struct timeval tv;
+	int i;
+
+	for (i = first; i <= last; i++) {
+		tv.tv_sec = i;
+		tv.tv_usec = 0;
+		psensor_set_current_measure(s, i, tv);
+	}
+}
+
+/*
+ * Checks that the history of 's' contains 'n' unknown measures
+ * followed by the values 'first'..'last'.
+ */
+static int
+check_measures(struct psensor *s, bool newest_first, int n, int first, int last)
+{
+	struct psensor_measure_iter it;
+	struct measure m;
+	int i, count, length;
+	double expected;
+
+	length = psensor_get_tier_length(s, PSENSOR_TIER_FULL);
+
+	count = 0;
+	psensor_measure_iter_init(&it, s, newest_first);
+	while (psensor_measure_iter_next(&it, &m)) {
+		if (newest_first)
+			i = length - 1 - count;
+		else
+			i = count;
+
+		if (i < n)
+			expected = UNKNOWN_DBL_VALUE;
+		else
+			expected = first + i - n;
+
+		if (m.value != expected) {
+			fprintf(stderr,
+				"FAILURE: measure %d is %f instead of %f\n",
+				i, m.value, expected);
+			return 0;
+		}
+
+		count++;
+	}
+
+	if (count != length || n + last - first + 1 != count) {
+		fprintf(stderr, "FAILURE: %d measures iterated\n", count);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_ring(void)
+{
+	struct psensor *s;
+	int failures;
+
+	failures = 0;
+
+	s = create_sensor(4);
+
+	add_values(s, 1, 2);
+	if (!check_measures(s, false, 2, 1, 2))
+		failures++;
+
+	add_values(s, 3, 7);
+	if (!check_measures(s, false, 0, 4, 7))
+		failures++;
+	if (!check_measures(s, true, 0, 4, 7))
+		failures++;
+
+	if (psensor_get_current_value(s) != 7)
+		failures++;
+
+	psensor_values_resize(s, 6);
+	if (!check_measures(s, false, 2, 4, 7))
+		failures++;
+
+	add_values(s, 8, 8);
+	psensor_values_resize(s, 2);
+	if (!check_measures(s, false, 0, 7, 8))
+		failures++;
+
+	if (psensor_get_current_value(s) != 8)
+		failures++;
+
+	psensor_free(s);
+
+	/* iterated by several chunks */
+	s = create_sensor(2 * PSENSOR_MEASURE_ITER_CHUNK + 10);
+
+	add_values(s, 1, 2 * PSENSOR_MEASURE_ITER_CHUNK);
+	if (!check_measures(s, false, 10, 1, 2 * PSENSOR_MEASURE_ITER_CHUNK))
+		failures++;
+	if (!check_measures(s, true, 10, 1, 2 * PSENSOR_MEASURE_ITER_CHUNK))
+		failures++;
+
+	psensor_free(s);
+
+	return failures;
+}
+
+static int check_time(struct psensor *s, int i, time_t sec, suseconds_t usec)
+{
+	struct measure m;
+
+	psensor_get_measure(s, i, &m);
+
+	if (m.time.tv_sec != sec || m.time.tv_usec != usec) {
+		fprintf(stderr,
+			"FAILURE: time of measure %d is %ld.%06ld\n",
+			i, (long)m.time.tv_sec, (long)m.time.tv_usec);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_timestamps(void)
+{
+	struct psensor *s;
+	struct timeval tv;
+	int failures;
+
+	failures = 0;
+
+	s = create_sensor(3);
+
+	tv.tv_sec = 1400000000;
+	tv.tv_usec = 250000;
+	psensor_set_current_measure(s, 1, tv);
+
+	tv.tv_sec += 10;
+	tv.tv_usec = 999000;
+	psensor_set_current_measure(s, 2, tv);
+
+	if (!check_time(s, 0, 0, 0))
+		failures++;
+	if (!check_time(s, 1, 1400000000, 250000))
+		failures++;
+	if (!check_time(s, 2, 1400000010, 999000))
+		failures++;
+
+	/* beyond the range of the 32 bits offsets, older ones dropped */
+	tv.tv_sec += 60 * 24 * 3600;
+	tv.tv_usec = 0;
+	psensor_set_current_measure(s, 3, tv);
+
+	if (!check_measures(s, false, 2, 3, 3))
+		failures++;
+	if (!check_time(s, 2, tv.tv_sec, 0))
+		failures++;
+
+	/* clock going backward */
+	tv.tv_sec -= 3600;
+	psensor_set_current_measure(s, 4, tv);
+
+	if (!check_time(s, 1, tv.tv_sec + 3600, 0))
+		failures++;
+	if (!check_time(s, 2, tv.tv_sec, 0))
+		failures++;
+
+	psensor_free(s);
+
+	return failures;
+}
+
+/* Computes the minimum and maximum by scanning the whole history. */
+static void scan_min_max(struct psensor *s, double *min, double *max)
+{
+	struct psensor_measure_iter it;
+	struct measure m;
+
+	*min = *max = UNKNOWN_DBL_VALUE;
+
+	psensor_measure_iter_init(&it, s, false);
+	while (psensor_measure_iter_next(&it, &m)) {
+		if (m.value == UNKNOWN_DBL_VALUE)
+			continue;
+
+		if (*min == UNKNOWN_DBL_VALUE || m.value < *min)
+			*min = m.value;
+
+		if (*max == UNKNOWN_DBL_VALUE || m.value > *max)
+			*max = m.value;
+	}
+}
+
+static int test_min_max(void)
+{
+	struct psensor *s, *sensors[2];
+	struct timeval tv;
+	int i, failures;
+	double v, min, max;
+
+	failures = 0;
+
+	s = create_sensor(16);
+	sensors[0] = s;
+	sensors[1] = NULL;
+
+	srand(1);
+	for (i = 0; i < 1000; i++) {
+		if (rand() % 10)
+			v = rand() % 100;
+		else
+			v = UNKNOWN_DBL_VALUE;
+
+		tv.tv_sec = 1400000000 + i;
+		tv.tv_usec = 0;
+		psensor_set_current_measure(s, v, tv);
+
+		if (i == 500)
+			psensor_values_resize(s, 5);
+		else if (i == 700)
+			psensor_values_resize(s, 32);
+
+		scan_min_max(s, &min, &max);
+
+		if (get_min_temp(sensors) != min
+		    || get_max_temp(sensors) != max) {
+			fprintf(stderr,
+				"FAILURE: min/max %f/%f instead of %f/%f\n",
+				get_min_temp(sensors),
+				get_max_temp(sensors),
+				min,
+				max);
+			failures++;
+		}
+	}
+
+	psensor_free(s);
+
+	return failures;
+}
+
+static int check_rollup(struct psensor *s,
+			int tier,
+			int i,
+			double min,
+			double avg,
+			double max)
+{
+	struct measure_rollup r;
+
+	psensor_get_rollup(s, tier, i, &r);
+
+	if (r.min != min || r.avg != avg || r.max != max) {
+		fprintf(stderr,
+			"FAILURE: rollup %d of tier %d is %f/%f/%f\n",
+			i, tier, r.min, r.avg, r.max);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int test_tiers(void)
+{
+	struct psensor *s, *sensors[2];
+	int n, failures;
+
+	failures = 0;
+
+	s = create_sensor(10);
+	sensors[0] = s;
+	sensors[1] = NULL;
+
+	add_values(s, 1000, 1094);
+
+	if (psensor_get_tier(s, 5) != PSENSOR_TIER_FULL)
+		failures++;
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (psensor_get_tier(s, 7200) != PSENSOR_TIER_ARCHIVE)
+		failures++;
+#else
+	if (psensor_get_tier(s, 60) != 0)
+		failures++;
+	if (psensor_get_tier(s, 7200) != 1)
+		failures++;
+#endif
+	if (psensor_get_tier(s, 365 * 24 * 3600) != PSENSOR_TIERS_COUNT - 1)
+		failures++;
+
+	/* period being aggregated and the last completed one */
+	n = psensor_get_tier_length(s, 0);
+	if (!check_rollup(s, 0, n - 1, 1090, 1092, 1094))
+		failures++;
+	if (!check_rollup(s, 0, n - 2, 1080, 1084.5, 1089))
+		failures++;
+
+	if (!check_rollup(s, 1, n - 1, 1080, 1087, 1094))
+		failures++;
+
+	if (psensor_list_get_min(sensors, SENSOR_TYPE_TEMP, 60) != 1000
+	    || psensor_list_get_max(sensors, SENSOR_TYPE_TEMP, 60) != 1094
+	    || psensor_list_get_min(sensors, SENSOR_TYPE_TEMP, 0) != 1085)
+		failures++;
+
+	psensor_free(s);
+
+	return failures;
+}
+
+static int test_list_extrema(void)
+{
+	struct psensor *temp, *fan, *sensors[3];
+	struct psensor_list_extrema e;
+	int failures;
+
+	failures = 0;
+
+	temp = create_sensor(16);
+	fan = psensor_create(strdup("fan"),
+			     strdup("fan"),
+			     NULL,
+			     SENSOR_TYPE_FAN | SENSOR_TYPE_RPM,
+			     16);
+	psensor_set_history_enabled(fan, true);
+	sensors[0] = temp;
+	sensors[1] = fan;
+	sensors[2] = NULL;
+
+	add_values(temp, 1, 10);
+	add_values(fan, 1000, 1002);
+
+	memset(&e, 0, sizeof(e));
+	psensor_list_extrema_update(&e, sensors, 0);
+
+	if (e.min[PSENSOR_VALUE_TEMP] != 1
+	    || e.max[PSENSOR_VALUE_TEMP] != 10
+	    || e.min[PSENSOR_VALUE_RPM] != 1000
+	    || e.max[PSENSOR_VALUE_RPM] != 1002
+	    || e.max[PSENSOR_VALUE_POWER] != UNKNOWN_DBL_VALUE)
+		failures++;
+
+	/* no new measure: the cached extrema are kept */
+	e.max[PSENSOR_VALUE_TEMP] = -1;
+	psensor_list_extrema_update(&e, sensors, 0);
+	if (e.max[PSENSOR_VALUE_TEMP] != -1)
+		failures++;
+
+	add_values(temp, 11, 11);
+	psensor_list_extrema_update(&e, sensors, 0);
+	if (e.max[PSENSOR_VALUE_TEMP] != 11)
+		failures++;
+
+	sensors[0] = fan;
+	sensors[1] = NULL;
+	psensor_list_extrema_update(&e, sensors, 0);
+	if (e.min[PSENSOR_VALUE_TEMP] != UNKNOWN_DBL_VALUE
+	    || e.max[PSENSOR_VALUE_RPM] != 1002)
+		failures++;
+
+	if (failures)
+		fprintf(stderr, "FAILURE: list extrema\n");
+
+	psensor_list_extrema_free(&e);
+	psensor_free(temp);
+	psensor_free(fan);
+
+	return failures;
+}
+
+static int test_history(void)
+{
+	struct psensor *s;
+	struct psensor_snapshot snapshot;
+	int failures;
+
+	failures = 0;
+
+	s = psensor_create(strdup("test"),
+			   strdup("test"),
+			   NULL,
+			   SENSOR_TYPE_TEMP,
+			   10);
+
+	/* only the last measures and the session extrema are kept */
+	add_values(s, 1000, 1030);
+	if (!check_measures(s, false, 0, 1029, 1030))
+		failures++;
+
+	psensor_get_snapshot(s, &snapshot);
+	if (snapshot.current.value != 1030
+	    || snapshot.sess_lowest != 1000
+	    || snapshot.sess_highest != 1030)
+		failures++;
+
+	if (psensor_get_tier(s, 3600) != PSENSOR_TIER_FULL
+	    || psensor_get_tier_length(s, 0) != 0
+	    || !check_rollup(s, 0, 0, UNKNOWN_DBL_VALUE, UNKNOWN_DBL_VALUE,
+			     UNKNOWN_DBL_VALUE))
+		failures++;
+
+	/* allocated by the next measure, the last ones are kept */
+	psensor_set_history_enabled(s, true);
+	add_values(s, 1031, 1031);
+	if (!check_measures(s, false, 7, 1029, 1031))
+		failures++;
+
+	add_values(s, 1032, 1050);
+	if (psensor_get_tier(s, 60) == PSENSOR_TIER_FULL
+	    || !check_rollup(s, 0, psensor_get_tier_length(s, 0) - 1,
+			     1050, 1050, 1050))
+		failures++;
+
+	psensor_set_history_enabled(s, false);
+	add_values(s, 1051, 1051);
+	if (!check_measures(s, false, 0, 1050, 1051)
+	    || psensor_get_tier_length(s, 0) != 0)
+		failures++;
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (psensor_get_tier_length(s, PSENSOR_TIER_ARCHIVE) != 0)
+		failures++;
+#endif
+
+	psensor_free(s);
+
+	return failures;
+}
+
+static int alarms, cycles;
+static double last_value;
+
+/* Called when the alarm of the first sensor of 'data' is raised. */
+static void cb_alarm(struct psensor *s, void *data)
+{
+	struct psensor **sensors = data;
+
+	alarms++;
+
+	/* all the measures of the batch are added before the callbacks */
+	last_value = psensor_get_current_value(sensors[2]);
+}
+
+static void cb_cycle(void *data)
+{
+	cycles++;
+}
+
+static int test_batch(void)
+{
+	struct psensor *sensors[4];
+	struct psensor_batch b;
+	struct measure m;
+	int i, failures;
+
+	failures = 0;
+
+	for (i = 0; i < 3; i++)
+		sensors[i] = create_sensor(4);
+	sensors[3] = NULL;
+
+	sensors[1]->alarm_high_threshold = 50;
+	sensors[1]->alarm_low_threshold = 0;
+	sensors[1]->cb_alarm_raised = cb_alarm;
+	sensors[1]->cb_alarm_raised_data = sensors;
+
+	psensor_cycle_add_listener(cb_cycle, NULL);
+
+	psensor_batch_begin(&b, sensors);
+	psensor_batch_set(&b, 0, 10);
+	psensor_batch_set(&b, 1, 60);
+	psensor_batch_set(&b, 2, 20);
+
+	if (psensor_batch_commit(&b) != 3)
+		failures++;
+
+	for (i = 0; i < 3; i++) {
+		psensor_get_current_measure(sensors[i], &m);
+
+		if (m.time.tv_sec != b.time.tv_sec
+		    || m.time.tv_usec / 1000 != b.time.tv_usec / 1000)
+			failures++;
+	}
+
+	if (alarms != 1 || last_value != 20 || cycles != 0)
+		failures++;
+
+	/* the batches of a cycle are notified once */
+	psensor_batch_begin(&b, sensors + 2);
+	psensor_batch_set(&b, 0, 30);
+	if (psensor_batch_commit(&b) != 1)
+		failures++;
+
+	psensor_cycle_end();
+	if (cycles != 1)
+		failures++;
+
+	/* a cycle without measure is not notified */
+	psensor_batch_begin(&b, sensors);
+	if (psensor_batch_commit(&b) != 0)
+		failures++;
+
+	psensor_cycle_end();
+	if (cycles != 1)
+		failures++;
+
+	if (failures)
+		fprintf(stderr, "FAILURE: batch %d alarms %d cycles\n",
+			alarms, cycles);
+
+	for (i = 0; i < 3; i++)
+		psensor_free(sensors[i]);
+
+	return failures;
+}
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+/*
+ * Checks that the compressed history of 's' contains the values
+ * 'first'..'last' measured at the time of their value.
+ */
+static int
+check_archive(struct psensor *s, bool newest_first, int first, int last)
+{
+	struct psensor_measure_iter it;
+	struct measure m;
+	int v, failures;
+
+	failures = 0;
+
+	v = newest_first ? last : first;
+	psensor_measure_iter_init_tier(&it,
+				       s,
+				       PSENSOR_TIER_ARCHIVE,
+				       newest_first);
+	while (psensor_measure_iter_next(&it, &m)) {
+		if (m.value != v || m.time.tv_sec != v)
+			failures++;
+
+		v += newest_first ? -1 : 1;
+	}
+
+	if (v != (newest_first ? first - 1 : last + 1))
+		failures++;
+
+	if (failures)
+		fprintf(stderr, "FAILURE: archive ends at %d\n", v);
+
+	return failures;
+}
+
+static int test_archive(void)
+{
+	struct psensor *s;
+	struct measure m;
+	int failures;
+
+	failures = 0;
+
+	s = create_sensor(10);
+
+	add_values(s, 1, 1000);
+
+	if (psensor_get_tier_length(s, PSENSOR_TIER_ARCHIVE) != 1000)
+		failures++;
+
+	failures += check_archive(s, false, 1, 1000);
+	failures += check_archive(s, true, 1, 1000);
+
+	psensor_get_tier_measure(s, PSENSOR_TIER_ARCHIVE, 499, &m);
+	if (m.value != 500)
+		failures++;
+
+	/* the sealed blocks are evicted, not the head block */
+	add_values(s,
+		   PSENSOR_ARCHIVE_DURATION + 1000,
+		   PSENSOR_ARCHIVE_DURATION + 1009);
+
+	psensor_get_tier_measure(s, PSENSOR_TIER_ARCHIVE, 0, &m);
+	if (m.value != 7 * MEASURE_BLOCK_SIZE + 1
+	    || psensor_get_tier_length(s, PSENSOR_TIER_ARCHIVE) != 114)
+		failures++;
+
+	psensor_free(s);
+
+	return failures;
+}
+#endif
+
+static bool writer_done;
+
+/* Adds measures whose value is their time, resizing the history. */
+static void *writer_routine(void *data)
+{
+	struct psensor *s = data;
+	struct timeval tv;
+	int i;
+
+	tv.tv_usec = 0;
+	for (i = 1; i <= 200000; i++) {
+		tv.tv_sec = i;
+		psensor_set_current_measure(s, i, tv);
+
+		if (i % 1000 == 0)
+			psensor_values_resize(s, 16 + (i / 1000) % 32);
+	}
+
+	__atomic_store_n(&writer_done, true, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+static int test_concurrent_reads(void)
+{
+	struct psensor *s;
+	struct psensor_measure_iter it;
+	struct psensor_snapshot snapshot;
+	struct measure m;
+	pthread_t writer;
+	int failures;
+
+	failures = 0;
+
+	s = create_sensor(16);
+
+	pthread_create(&writer, NULL, writer_routine, s);
+
+	while (!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+		psensor_measure_iter_init(&it, s, true);
+		while (psensor_measure_iter_next(&it, &m))
+			if (m.time.tv_sec && m.value != m.time.tv_sec)
+				failures++;
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+		psensor_measure_iter_init_tier(&it,
+					       s,
+					       PSENSOR_TIER_ARCHIVE,
+					       false);
+		while (psensor_measure_iter_next(&it, &m))
+			if (m.value != m.time.tv_sec)
+				failures++;
+#endif
+
+		psensor_get_snapshot(s, &snapshot);
+		if (snapshot.current.time.tv_sec
+		    && (snapshot.current.value != snapshot.current.time.tv_sec
+			|| snapshot.sess_highest != snapshot.current.value))
+			failures++;
+	}
+
+	pthread_join(writer, NULL);
+
+	if (failures)
+		fprintf(stderr, "FAILURE: %d inconsistent reads\n", failures);
+
+	psensor_free(s);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	if (test_ring() || test_timestamps() || test_min_max() || test_tiers()
+	    || test_list_extrema() || test_history() || test_batch()
+	    || test_concurrent_reads())
+		exit(EXIT_FAILURE);
+
+#ifdef ENABLE_COMPRESSED_HISTORY
+	if (test_archive())
+		exit(EXIT_FAILURE);
+#endif
+
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -44,6 +44,23 @@ test_psensor_value_to_str(unsigned int type,
 	}
 }
 
+static int
+test_psensor_value_to_buf(unsigned int type,
+			  double value,
+			  size_t size,
+			  const char *ref)
+{
+	char buf[PSENSOR_VALUE_STR_SIZE];
+
+	if (psensor_value_to_buf(type, value, 1, buf, size) != buf
+	    || strcmp(ref, buf)) {
+		fprintf(stderr, "returns: %s expected: %s\n", buf, ref);
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
 int main(int argc, char **argv)
 {
 	int errs;
@@ -57,6 +74,17 @@ int main(int argc, char **argv)
 	errs += test_psensor_value_to_str(SENSOR_TYPE_TEMP, 13.5, 1,
 					  "14"CELSIUS);
 
+	errs += test_psensor_value_to_buf(SENSOR_TYPE_RPM, 2400.2,
+					  PSENSOR_VALUE_STR_SIZE, "2400RPM");
+	errs += test_psensor_value_to_buf(SENSOR_TYPE_PERCENT, 57,
+					  PSENSOR_VALUE_STR_SIZE, "57%");
+	errs += test_psensor_value_to_buf(SENSOR_TYPE_POWER, 4.26,
+					  PSENSOR_VALUE_STR_SIZE, "4.3W");
+	errs += test_psensor_value_to_buf(SENSOR_TYPE_FREQ, 2400,
+					  PSENSOR_VALUE_STR_SIZE, "2400MHz");
+	/* truncated to the size of the buffer */
+	errs += test_psensor_value_to_buf(SENSOR_TYPE_RPM, 2400, 4, "240");
+
 	if (errs) 
 		exit(EXIT_FAILURE);
 	else
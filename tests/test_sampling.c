@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/lib/sampling.h"
+
+#define MIN 250
+#define MAX 10000
+
+/*
+ * Creates a temperature sensor whose last two measures are 'v1' and
+ * 'v2', taken 'dt' milliseconds apart.
+ */
+static struct psensor *create_sensor(double v1, double v2, int dt)
+{
+	struct psensor *s;
+	struct timeval tv;
+
+	s = psensor_create(strdup("test"),
+			   strdup("test"),
+			   NULL,
+			   SENSOR_TYPE_TEMP | SENSOR_TYPE_LMSENSOR,
+			   10);
+
+	s->alarm_high_threshold = 80;
+	s->alarm_low_threshold = 0;
+
+	tv.tv_sec = 1400000000;
+	tv.tv_usec = 0;
+	psensor_set_current_measure(s, v1, tv);
+
+	tv.tv_sec += dt / 1000;
+	tv.tv_usec = (dt % 1000) * 1000;
+	psensor_set_current_measure(s, v2, tv);
+
+	return s;
+}
+
+static int check(double v1, double v2, int dt, int interval, int expected)
+{
+	struct psensor *s;
+	int ret;
+
+	s = create_sensor(v1, v2, dt);
+
+	ret = sampling_next_interval(s, interval, MIN, MAX);
+
+	psensor_free(s);
+
+	if (ret != expected) {
+		fprintf(stderr,
+			"FAILURE: %f, %f in %dms, %dms: %dms instead of %dms\n",
+			v1, v2, dt, interval, ret, expected);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int failures;
+
+	failures = 0;
+
+	/* stable */
+	failures += check(40, 40, 1000, 1000, 1500);
+	failures += check(40, 40.01, 1000, 8000, MAX);
+
+	/* ramp */
+	failures += check(40, 42, 1000, 1000, 500);
+	failures += check(40, 45, 1000, 400, MIN);
+
+	/* slow change, kept */
+	failures += check(40, 40.5, 1000, 1000, 1000);
+
+	/* close to a threshold */
+	failures += check(78, 78, 1000, 4000, MIN);
+
+	/* approaching a threshold */
+	failures += check(75.6, 76.5, 1000, 1000, 972);
+
+	/* unknown measure */
+	failures += check(40, UNKNOWN_DBL_VALUE, 1000, 4000, MIN);
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2010-2016 jeanfi@gmail.com
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../src/lib/stats.h"
+
+#define MAX_VALUES 1000
+
+/* Compares the kernels of 'isa' with the scalar ones. */
+static int check_isa(enum stats_isa isa, const measure_value_t *v, int n)
+{
+	double min, max, sum;
+	int count, c;
+
+	stats_select_isa(STATS_ISA_SCALAR);
+	min = stats_min(v, n);
+	max = stats_max(v, n);
+	sum = stats_sum(v, n, &count);
+
+	stats_select_isa(isa);
+
+	if (stats_min(v, n) != min
+	    || stats_max(v, n) != max
+	    || fabs(stats_sum(v, n, &c) - sum) > 1e-3
+	    || c != count) {
+		fprintf(stderr,
+			"FAILURE: isa %d, %d values: %f %f %f %d\n",
+			isa, n, min, max, sum, count);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	measure_value_t v[MAX_VALUES];
+	enum stats_isa isa;
+	int i, n, failures, count;
+
+	failures = 0;
+
+	for (i = 0; i < MAX_VALUES; i++)
+		v[i] = UNKNOWN_MEASURE_VALUE;
+
+	if (stats_min(v, MAX_VALUES) != UNKNOWN_DBL_VALUE
+	    || stats_max(v, MAX_VALUES) != UNKNOWN_DBL_VALUE
+	    || stats_mean(v, MAX_VALUES) != UNKNOWN_DBL_VALUE
+	    || stats_sum(v, MAX_VALUES, &count) != 0 || count)
+		failures++;
+
+	srand(1);
+	for (i = 0; i < MAX_VALUES; i++)
+		if (rand() % 5)
+			v[i] = (rand() % 2000 - 1000) / 8.0;
+
+	v[0] = 1;
+	v[1] = 3;
+	if (stats_mean(v, 2) != 2)
+		failures++;
+
+	for (isa = STATS_ISA_SCALAR; isa <= STATS_ISA_AVX2; isa++) {
+		if (!stats_select_isa(isa))
+			continue;
+
+		for (n = 0; n <= 40; n++)
+			failures += check_isa(isa, v + n, n);
+
+		failures += check_isa(isa, v, MAX_VALUES);
+	}
+
+	/* rounded in each addition if accumulated in floats */
+	for (i = 0; i < MAX_VALUES; i++)
+		v[i] = 1000 + (rand() % 1000) / 10.0;
+
+	for (isa = STATS_ISA_SCALAR; isa <= STATS_ISA_AVX2; isa++)
+		if (stats_select_isa(isa))
+			failures += check_isa(isa, v, MAX_VALUES);
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -121,7 +121,10 @@ function update_chart(chart_id, title, data) {
     
     $.each(measures, function(i, item) {
         value = item["value"];
-        date = new Date(item["time"]*1000);
+        if ("time_ms" in item)
+            date = new Date(item["time_ms"]);
+        else
+            date = new Date(item["time"]*1000);
 	entry = [date, item["value"]];
 	
         data_chart.push(entry);